@@ -0,0 +1,832 @@
+/* Copyright (c) <2009> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+
+// headless benchmark, builds procedural versions of the sandbox demos using only the Newton api,
+// steps each one a fixed number of frames at 1 to N threads and writes the timings as json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+#include <Newton.h>
+
+
+#define BENCHMARK_TIMESTEP				(1.0f / 60.0f)
+#define BENCHMARK_DEFAULT_FRAMES		600
+#define BENCHMARK_GRAVITY				(-10.0f)
+#define BENCHMARK_MAX_FRACTURE_POINTS	4
+#define BENCHMARK_MAX_FRACTURE_PIECES	32
+#define BENCHMARK_MAX_FRACTURE_BOXES	128
+
+
+static unsigned m_randSeed = 0x12345678;
+
+static void ResetRandom ()
+{
+	m_randSeed = 0x12345678;
+}
+
+// deterministic random number in [-1, 1], so that all runs build the exact same scenes
+static dFloat RandomVariable (dFloat amp)
+{
+	m_randSeed = m_randSeed * 1664525u + 1013904223u;
+	return amp * (dFloat ((m_randSeed >> 8) & 0xffff) / dFloat (0x7fff) - 1.0f);
+}
+
+static double GetTimeInMilliseconds ()
+{
+#ifdef _WIN32
+	LARGE_INTEGER count;
+	LARGE_INTEGER frequency;
+	QueryPerformanceCounter (&count);
+	QueryPerformanceFrequency (&frequency);
+	return double (count.QuadPart) * 1000.0 / double (frequency.QuadPart);
+#else
+	timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return double (ts.tv_sec) * 1000.0 + double (ts.tv_nsec) * 1.0e-6;
+#endif
+}
+
+
+// row major matrix, with the rotation about the y axis followed by the rotation about the z axis
+static void MakeMatrix (dFloat* const matrix, dFloat x, dFloat y, dFloat z, dFloat yaw = 0.0f, dFloat roll = 0.0f)
+{
+	dFloat cy = dFloat (cos (yaw));
+	dFloat sy = dFloat (sin (yaw));
+	dFloat cr = dFloat (cos (roll));
+	dFloat sr = dFloat (sin (roll));
+
+	matrix[0] = cy * cr; matrix[1] = sr; matrix[2] = -sy * cr; matrix[3] = 0.0f;
+	matrix[4] = -cy * sr; matrix[5] = cr; matrix[6] = sy * sr; matrix[7] = 0.0f;
+	matrix[8] = sy; matrix[9] = 0.0f; matrix[10] = cy; matrix[11] = 0.0f;
+	matrix[12] = x; matrix[13] = y; matrix[14] = z; matrix[15] = 1.0f;
+}
+
+static void ApplyGravity (const NewtonBody* const body, dFloat timestep, int threadIndex)
+{
+	dFloat Ixx;
+	dFloat Iyy;
+	dFloat Izz;
+	dFloat mass;
+
+	NewtonBodyGetMassMatrix (body, &mass, &Ixx, &Iyy, &Izz);
+	dFloat force[4] = {0.0f, mass * BENCHMARK_GRAVITY, 0.0f, 0.0f};
+	NewtonBodySetForce (body, force);
+}
+
+// wheels carry their motor torque in the user data, and spin about their local x axis
+static void ApplyWheelTorque (const NewtonBody* const body, dFloat timestep, int threadIndex)
+{
+	ApplyGravity (body, timestep, threadIndex);
+
+	dFloat matrix[16];
+	const dFloat torque = *((dFloat*) NewtonBodyGetUserData (body));
+	NewtonBodyGetMatrix (body, matrix);
+	dFloat axisTorque[4] = {matrix[0] * torque, matrix[1] * torque, matrix[2] * torque, 0.0f};
+	NewtonBodySetTorque (body, axisTorque);
+}
+
+static NewtonBody* CreateBody (NewtonWorld* const world, const NewtonCollision* const collision, dFloat mass, const dFloat* const matrix)
+{
+	NewtonBody* const body = NewtonCreateDynamicBody (world, collision, matrix);
+	if (mass > 0.0f) {
+		NewtonBodySetMassProperties (body, mass, collision);
+		NewtonBodySetForceAndTorqueCallback (body, ApplyGravity);
+	}
+	return body;
+}
+
+static NewtonBody* CreateBox (NewtonWorld* const world, dFloat mass, dFloat x, dFloat y, dFloat z, dFloat dx, dFloat dy, dFloat dz, dFloat yaw = 0.0f)
+{
+	dFloat matrix[16];
+	MakeMatrix (matrix, x, y, z, yaw);
+	NewtonCollision* const collision = NewtonCreateBox (world, dx, dy, dz, 0, NULL);
+	NewtonBody* const body = CreateBody (world, collision, mass, matrix);
+	NewtonDestroyCollision (collision);
+	return body;
+}
+
+static void CreateFloor (NewtonWorld* const world, dFloat size)
+{
+	CreateBox (world, 0.0f, 0.0f, -0.5f, 0.0f, size, 1.0f, size);
+}
+
+// drops a grid of mixed convex primitives, the collision shapes in the sandbox scenes
+static void DropPrimitives (NewtonWorld* const world, int countX, int countZ, int layers, dFloat spacing, dFloat height)
+{
+	NewtonCollision* shapes[5];
+	shapes[0] = NewtonCreateBox (world, 0.8f, 0.6f, 0.7f, 0, NULL);
+	shapes[1] = NewtonCreateSphere (world, 0.4f, 0, NULL);
+	shapes[2] = NewtonCreateCapsule (world, 0.25f, 1.0f, 0, NULL);
+	shapes[3] = NewtonCreateCylinder (world, 0.35f, 0.6f, 0, NULL);
+	shapes[4] = NewtonCreateChamferCylinder (world, 0.4f, 0.3f, 0, NULL);
+
+	int index = 0;
+	dFloat x0 = -0.5f * spacing * dFloat (countX - 1);
+	dFloat z0 = -0.5f * spacing * dFloat (countZ - 1);
+	for (int y = 0; y < layers; y ++) {
+		for (int i = 0; i < countX; i ++) {
+			for (int k = 0; k < countZ; k ++) {
+				dFloat matrix[16];
+				MakeMatrix (matrix, x0 + spacing * i + RandomVariable (0.2f), height + 1.5f * y, z0 + spacing * k + RandomVariable (0.2f), RandomVariable (3.1416f), RandomVariable (3.1416f));
+				CreateBody (world, shapes[index % 5], 1.0f, matrix);
+				index ++;
+			}
+		}
+	}
+
+	for (int i = 0; i < 5; i ++) {
+		NewtonDestroyCollision (shapes[i]);
+	}
+}
+
+
+static void BuildBasicStacking (NewtonWorld* const world)
+{
+	CreateFloor (world, 200.0f);
+
+	// four box pyramids
+	const dFloat size = 0.5f;
+	for (int p = 0; p < 4; p ++) {
+		dFloat z = -12.0f + 8.0f * p;
+		for (int row = 0; row < 12; row ++) {
+			int count = 12 - row;
+			dFloat x0 = -0.5f * size * 1.05f * dFloat (count - 1);
+			for (int i = 0; i < count; i ++) {
+				CreateBox (world, 1.0f, x0 + size * 1.05f * i, 0.5f * size + size * row, z, size, size, size);
+			}
+		}
+	}
+
+	// a jenga tower of alternating layers
+	const dFloat plankLength = 1.5f;
+	const dFloat plankWidth = 0.5f;
+	const dFloat plankHeight = 0.3f;
+	for (int layer = 0; layer < 16; layer ++) {
+		dFloat y = 0.5f * plankHeight + plankHeight * layer;
+		for (int i = -1; i <= 1; i ++) {
+			if (layer & 1) {
+				CreateBox (world, 1.0f, 10.0f + i * plankWidth * 1.01f, y, 0.0f, plankWidth, plankHeight, plankLength);
+			} else {
+				CreateBox (world, 1.0f, 10.0f, y, i * plankWidth * 1.01f, plankLength, plankHeight, plankWidth);
+			}
+		}
+	}
+}
+
+
+static NewtonBody* CreateRagDollPart (NewtonWorld* const world, NewtonCollision* const collision, dFloat mass, dFloat x, dFloat y, dFloat z, dFloat roll = 0.0f)
+{
+	dFloat matrix[16];
+	MakeMatrix (matrix, x, y, z, 0.0f, roll);
+	return CreateBody (world, collision, mass, matrix);
+}
+
+static void LinkRagDollParts (NewtonWorld* const world, NewtonBody* const child, NewtonBody* const parent, dFloat x, dFloat y, dFloat z, dFloat px, dFloat py, dFloat pz, dFloat coneAngle, dFloat twistAngle)
+{
+	dFloat pivot[4] = {x, y, z, 1.0f};
+	dFloat pin[4] = {px, py, pz, 0.0f};
+	NewtonJoint* const joint = NewtonConstraintCreateBall (world, pivot, child, parent);
+	NewtonBallSetConeLimits (joint, pin, coneAngle, twistAngle);
+}
+
+static void BuildBasicRagDoll (NewtonWorld* const world)
+{
+	CreateFloor (world, 200.0f);
+
+	NewtonCollision* const pelvisShape = NewtonCreateBox (world, 0.4f, 0.2f, 0.25f, 0, NULL);
+	NewtonCollision* const torsoShape = NewtonCreateBox (world, 0.45f, 0.5f, 0.25f, 0, NULL);
+	NewtonCollision* const headShape = NewtonCreateSphere (world, 0.12f, 0, NULL);
+	NewtonCollision* const armShape = NewtonCreateCapsule (world, 0.06f, 0.3f, 0, NULL);
+	NewtonCollision* const legShape = NewtonCreateCapsule (world, 0.08f, 0.36f, 0, NULL);
+
+	// capsules are aligned to the x axis, legs are rolled to stand along y
+	const dFloat roll = 3.1416f * 0.5f;
+	const dFloat cone = 3.1416f * 0.25f;
+	const dFloat twist = 3.1416f * 0.125f;
+	for (int i = 0; i < 6; i ++) {
+		for (int k = 0; k < 6; k ++) {
+			dFloat x = -7.5f + 3.0f * i;
+			dFloat z = -7.5f + 3.0f * k;
+			dFloat y = 1.0f + 0.5f * ((i + k) & 3);
+
+			NewtonBody* const pelvis = CreateRagDollPart (world, pelvisShape, 4.0f, x, y + 1.0f, z);
+			NewtonBody* const torso = CreateRagDollPart (world, torsoShape, 8.0f, x, y + 1.4f, z);
+			NewtonBody* const head = CreateRagDollPart (world, headShape, 2.0f, x, y + 1.8f, z);
+			LinkRagDollParts (world, torso, pelvis, x, y + 1.15f, z, 0.0f, 1.0f, 0.0f, cone, twist);
+			LinkRagDollParts (world, head, torso, x, y + 1.68f, z, 0.0f, 1.0f, 0.0f, cone, twist);
+
+			for (int side = -1; side <= 1; side += 2) {
+				dFloat s = dFloat (side);
+				NewtonBody* const upperArm = CreateRagDollPart (world, armShape, 1.0f, x + s * 0.42f, y + 1.55f, z);
+				NewtonBody* const lowerArm = CreateRagDollPart (world, armShape, 1.0f, x + s * 0.76f, y + 1.55f, z);
+				LinkRagDollParts (world, upperArm, torso, x + s * 0.25f, y + 1.55f, z, s, 0.0f, 0.0f, cone, twist);
+				LinkRagDollParts (world, lowerArm, upperArm, x + s * 0.59f, y + 1.55f, z, s, 0.0f, 0.0f, cone, twist);
+
+				NewtonBody* const upperLeg = CreateRagDollPart (world, legShape, 2.0f, x + s * 0.12f, y + 0.68f, z, roll);
+				NewtonBody* const lowerLeg = CreateRagDollPart (world, legShape, 2.0f, x + s * 0.12f, y + 0.24f, z, roll);
+				LinkRagDollParts (world, upperLeg, pelvis, x + s * 0.12f, y + 0.9f, z, 0.0f, -1.0f, 0.0f, cone, twist);
+				LinkRagDollParts (world, lowerLeg, upperLeg, x + s * 0.12f, y + 0.46f, z, 0.0f, -1.0f, 0.0f, cone, twist);
+			}
+		}
+	}
+
+	NewtonDestroyCollision (legShape);
+	NewtonDestroyCollision (armShape);
+	NewtonDestroyCollision (headShape);
+	NewtonDestroyCollision (torsoShape);
+	NewtonDestroyCollision (pelvisShape);
+}
+
+
+static dFloat m_wheelTorque[2] = {-6000.0f, 6000.0f};
+
+static void BuildHeavyVehicles (NewtonWorld* const world)
+{
+	CreateFloor (world, 400.0f);
+
+	NewtonCollision* const chassisShape = NewtonCreateBox (world, 4.0f, 1.0f, 2.0f, 0, NULL);
+	NewtonCollision* const wheelShape = NewtonCreateCylinder (world, 0.6f, 0.4f, 0, NULL);
+
+	// wheel cylinders are aligned to the x axis, the yaw turns them to spin about the z axis
+	const dFloat yaw = 3.1416f * 0.5f;
+	for (int i = 0; i < 4; i ++) {
+		for (int k = 0; k < 4; k ++) {
+			dFloat x = -30.0f + 20.0f * i;
+			dFloat z = -12.0f + 8.0f * k;
+			dFloat* const torque = &m_wheelTorque[k & 1];
+
+			dFloat matrix[16];
+			MakeMatrix (matrix, x, 1.4f, z);
+			NewtonBody* const chassis = CreateBody (world, chassisShape, 2000.0f, matrix);
+			for (int w = 0; w < 4; w ++) {
+				dFloat wx = x + ((w & 1) ? 1.5f : -1.5f);
+				dFloat wz = z + ((w & 2) ? 1.25f : -1.25f);
+				MakeMatrix (matrix, wx, 0.7f, wz, yaw);
+				NewtonBody* const wheel = CreateBody (world, wheelShape, 100.0f, matrix);
+				NewtonBodySetUserData (wheel, torque);
+				NewtonBodySetForceAndTorqueCallback (wheel, ApplyWheelTorque);
+
+				dFloat pivot[4] = {wx, 0.7f, wz, 1.0f};
+				dFloat pin[4] = {0.0f, 0.0f, 1.0f, 0.0f};
+				NewtonConstraintCreateHinge (world, pivot, pin, wheel, chassis);
+			}
+		}
+	}
+
+	// light debris on the vehicle paths
+	for (int i = 0; i < 128; i ++) {
+		CreateBox (world, 5.0f, RandomVariable (40.0f), 0.25f, RandomVariable (16.0f), 0.5f, 0.5f, 0.5f, RandomVariable (3.1416f));
+	}
+
+	NewtonDestroyCollision (wheelShape);
+	NewtonDestroyCollision (chassisShape);
+}
+
+
+static void BuildHeighFieldCollision (NewtonWorld* const world)
+{
+	const int size = 128;
+	const dFloat cellSize = 1.0f;
+
+	dFloat* const elevation = new dFloat[size * size];
+	char* const attributes = new char[size * size];
+	for (int z = 0; z < size; z ++) {
+		for (int x = 0; x < size; x ++) {
+			elevation[z * size + x] = 2.0f * dFloat (sin (x * 0.15f) * cos (z * 0.11f)) + RandomVariable (0.1f);
+			attributes[z * size + x] = 0;
+		}
+	}
+
+	dFloat matrix[16];
+	MakeMatrix (matrix, -0.5f * cellSize * size, 0.0f, -0.5f * cellSize * size);
+	NewtonCollision* const collision = NewtonCreateHeightFieldCollision (world, size, size, 1, 0, elevation, attributes, 1.0f, cellSize, 0);
+	CreateBody (world, collision, 0.0f, matrix);
+	NewtonDestroyCollision (collision);
+
+	delete[] attributes;
+	delete[] elevation;
+
+	DropPrimitives (world, 12, 12, 3, 4.0f, 6.0f);
+}
+
+
+static void BuildMeshCollision (NewtonWorld* const world)
+{
+	const int size = 64;
+	const dFloat cellSize = 2.0f;
+
+	NewtonCollision* const collision = NewtonCreateTreeCollision (world, 0);
+	NewtonTreeCollisionBeginBuild (collision);
+	const dFloat origin = -0.5f * cellSize * size;
+	for (int z = 0; z < size; z ++) {
+		for (int x = 0; x < size; x ++) {
+			dFloat points[4][3];
+			for (int i = 0; i < 4; i ++) {
+				int px = x + ((i == 1) || (i == 2));
+				int pz = z + (i >= 2);
+				points[i][0] = origin + cellSize * px;
+				points[i][1] = 1.5f * dFloat (sin (px * 0.3f) * sin (pz * 0.25f));
+				points[i][2] = origin + cellSize * pz;
+			}
+			// two triangles per cell, wound so that the normal points up
+			dFloat face0[3][3] = {{points[0][0], points[0][1], points[0][2]}, {points[3][0], points[3][1], points[3][2]}, {points[1][0], points[1][1], points[1][2]}};
+			dFloat face1[3][3] = {{points[1][0], points[1][1], points[1][2]}, {points[3][0], points[3][1], points[3][2]}, {points[2][0], points[2][1], points[2][2]}};
+			NewtonTreeCollisionAddFace (collision, 3, &face0[0][0], 3 * sizeof (dFloat), 0);
+			NewtonTreeCollisionAddFace (collision, 3, &face1[0][0], 3 * sizeof (dFloat), 0);
+		}
+	}
+	NewtonTreeCollisionEndBuild (collision, 1);
+
+	dFloat matrix[16];
+	MakeMatrix (matrix, 0.0f, 0.0f, 0.0f);
+	CreateBody (world, collision, 0.0f, matrix);
+	NewtonDestroyCollision (collision);
+
+	DropPrimitives (world, 12, 12, 3, 4.0f, 6.0f);
+}
+
+
+static void BuildCompoundCollision (NewtonWorld* const world)
+{
+	CreateFloor (world, 200.0f);
+
+	// a table made of a top and four legs
+	NewtonCollision* const compound = NewtonCreateCompoundCollision (world, 0);
+	NewtonCompoundCollisionBeginAddRemove (compound);
+
+	dFloat offset[16];
+	MakeMatrix (offset, 0.0f, 0.5f, 0.0f);
+	NewtonCollision* const top = NewtonCreateBox (world, 1.6f, 0.1f, 1.0f, 0, offset);
+	NewtonCompoundCollisionAddSubCollision (compound, top);
+	NewtonDestroyCollision (top);
+	for (int i = 0; i < 4; i ++) {
+		MakeMatrix (offset, (i & 1) ? 0.7f : -0.7f, 0.0f, (i & 2) ? 0.4f : -0.4f);
+		NewtonCollision* const leg = NewtonCreateBox (world, 0.1f, 1.0f, 0.1f, 0, offset);
+		NewtonCompoundCollisionAddSubCollision (compound, leg);
+		NewtonDestroyCollision (leg);
+	}
+	NewtonCompoundCollisionEndAddRemove (compound);
+
+	for (int layer = 0; layer < 6; layer ++) {
+		for (int i = 0; i < 6; i ++) {
+			for (int k = 0; k < 6; k ++) {
+				dFloat matrix[16];
+				MakeMatrix (matrix, -7.5f + 3.0f * i + RandomVariable (0.3f), 1.0f + 1.5f * layer, -7.5f + 3.0f * k + RandomVariable (0.3f), RandomVariable (3.1416f));
+				CreateBody (world, compound, 5.0f, matrix);
+			}
+		}
+	}
+	NewtonDestroyCollision (compound);
+}
+
+
+// pieces of a unit box split by a voronoi decomposition, shared by all the fracturing boxes
+struct FracturePiece
+{
+	NewtonCollision* m_collision;
+	dFloat m_massFraction;
+};
+
+static int m_fracturePiecesCount;
+static FracturePiece m_fracturePieces[BENCHMARK_MAX_FRACTURE_PIECES];
+static int m_fractureBoxesCount;
+static NewtonBody* m_fractureBoxes[BENCHMARK_MAX_FRACTURE_BOXES];
+
+static void CreateFracturePieces (NewtonWorld* const world, NewtonCollision* const box, dFloat size)
+{
+	NewtonMesh* const mesh = NewtonMeshCreateFromCollision (box);
+
+	dFloat points[BENCHMARK_MAX_FRACTURE_POINTS + 8][3];
+	int count = 0;
+	for (int i = 0; i < BENCHMARK_MAX_FRACTURE_POINTS; i ++) {
+		points[count][0] = RandomVariable (size * 0.5f);
+		points[count][1] = RandomVariable (size * 0.5f);
+		points[count][2] = RandomVariable (size * 0.5f);
+		count ++;
+	}
+	// the box corners bound the decomposition
+	for (int i = 0; i < 8; i ++) {
+		points[count][0] = (i & 1) ? size * 0.5f : -size * 0.5f;
+		points[count][1] = (i & 2) ? size * 0.5f : -size * 0.5f;
+		points[count][2] = (i & 4) ? size * 0.5f : -size * 0.5f;
+		count ++;
+	}
+
+	dFloat textureMatrix[16];
+	MakeMatrix (textureMatrix, 0.0f, 0.0f, 0.0f);
+	const dFloat volume = NewtonConvexCollisionCalculateVolume (box);
+
+	m_fracturePiecesCount = 0;
+	NewtonMesh* const debris = NewtonMeshCreateVoronoiConvexDecomposition (world, count, &points[0][0], 3 * sizeof (dFloat), 0, textureMatrix);
+	NewtonMesh* next;
+	for (NewtonMesh* segment = NewtonMeshCreateFirstLayer (debris); segment; segment = next) {
+		next = NewtonMeshCreateNextLayer (debris, segment);
+		NewtonMesh* const piece = NewtonMeshConvexMeshIntersection (mesh, segment);
+		if (piece) {
+			NewtonCollision* const collision = NewtonCreateConvexHullFromMesh (world, piece, 0.0f, 0);
+			if (collision) {
+				if (m_fracturePiecesCount < BENCHMARK_MAX_FRACTURE_PIECES) {
+					m_fracturePieces[m_fracturePiecesCount].m_collision = collision;
+					m_fracturePieces[m_fracturePiecesCount].m_massFraction = NewtonConvexCollisionCalculateVolume (collision) / volume;
+					m_fracturePiecesCount ++;
+				} else {
+					NewtonDestroyCollision (collision);
+				}
+			}
+			NewtonMeshDestroy (piece);
+		}
+		NewtonMeshDestroy (segment);
+	}
+	NewtonMeshDestroy (debris);
+	NewtonMeshDestroy (mesh);
+}
+
+static void BuildSimpleConvexFracturing (NewtonWorld* const world)
+{
+	CreateFloor (world, 200.0f);
+
+	const dFloat size = 1.0f;
+	NewtonCollision* const box = NewtonCreateBox (world, size, size, size, 0, NULL);
+	CreateFracturePieces (world, box, size);
+
+	m_fractureBoxesCount = 0;
+	for (int layer = 0; layer < 2; layer ++) {
+		for (int i = 0; i < 6; i ++) {
+			for (int k = 0; k < 6; k ++) {
+				dFloat matrix[16];
+				MakeMatrix (matrix, -5.0f + 2.0f * i, 2.0f + 3.0f * layer, -5.0f + 2.0f * k, RandomVariable (3.1416f), RandomVariable (0.5f));
+				m_fractureBoxes[m_fractureBoxesCount] = CreateBody (world, box, 10.0f, matrix);
+				m_fractureBoxesCount ++;
+			}
+		}
+	}
+	NewtonDestroyCollision (box);
+}
+
+// replace each box that touched something by its pieces, this is done between updates like the sandbox does
+static void FractureBoxes (NewtonWorld* const world)
+{
+	for (int i = m_fractureBoxesCount - 1; i >= 0; i --) {
+		NewtonBody* const body = m_fractureBoxes[i];
+		if (NewtonBodyGetFirstContactJoint (body)) {
+			dFloat Ixx;
+			dFloat Iyy;
+			dFloat Izz;
+			dFloat mass;
+			dFloat veloc[4];
+			dFloat omega[4];
+			dFloat matrix[16];
+
+			NewtonBodyGetMatrix (body, matrix);
+			NewtonBodyGetVelocity (body, veloc);
+			NewtonBodyGetOmega (body, omega);
+			NewtonBodyGetMassMatrix (body, &mass, &Ixx, &Iyy, &Izz);
+			NewtonDestroyBody (body);
+
+			for (int j = 0; j < m_fracturePiecesCount; j ++) {
+				NewtonBody* const piece = CreateBody (world, m_fracturePieces[j].m_collision, mass * m_fracturePieces[j].m_massFraction, matrix);
+				NewtonBodySetVelocity (piece, veloc);
+				NewtonBodySetOmega (piece, omega);
+			}
+
+			m_fractureBoxesCount --;
+			m_fractureBoxes[i] = m_fractureBoxes[m_fractureBoxesCount];
+		}
+	}
+}
+
+static void DestroyFracturePieces ()
+{
+	for (int i = 0; i < m_fracturePiecesCount; i ++) {
+		NewtonDestroyCollision (m_fracturePieces[i].m_collision);
+	}
+	m_fracturePiecesCount = 0;
+	m_fractureBoxesCount = 0;
+}
+
+
+struct BenchmarkScene
+{
+	const char* m_name;
+	void (*m_build) (NewtonWorld* const world);
+	void (*m_postUpdate) (NewtonWorld* const world);
+	void (*m_destroy) ();
+};
+
+static BenchmarkScene m_scenes[] =
+{
+	{"BasicStacking", BuildBasicStacking, NULL, NULL},
+	{"BasicRagDoll", BuildBasicRagDoll, NULL, NULL},
+	{"HeavyVehicles", BuildHeavyVehicles, NULL, NULL},
+	{"HeighFieldCollision", BuildHeighFieldCollision, NULL, NULL},
+	{"MeshCollision", BuildMeshCollision, NULL, NULL},
+	{"CompoundCollision", BuildCompoundCollision, NULL, NULL},
+	{"SimpleConvexFracturing", BuildSimpleConvexFracturing, FractureBoxes, DestroyFracturePieces},
+};
+
+static const char* m_phaseNames[NEWTON_PROFILER_COUNTERS_COUNT] =
+{
+	"world", "collision", "broadPhase", "narrowPhase", "dynamics", "buildIslands", "solveIslands", "forceCallback", "softBody", "preListeners", "postListeners"
+};
+
+
+static int CompareTimes (const void* a, const void* b)
+{
+	double ta = *((const double*) a);
+	double tb = *((const double*) b);
+	return (ta < tb) ? -1 : ((ta > tb) ? 1 : 0);
+}
+
+static double Percentile (const double* const sortedTimes, int count, double percent)
+{
+	int index = int (percent * 0.01 * (count - 1) + 0.5);
+	return sortedTimes[index];
+}
+
+static double BodiesChecksum (const NewtonWorld* const world)
+{
+	double checksum = 0.0;
+	for (NewtonBody* body = NewtonWorldGetFirstBody (world); body; body = NewtonWorldGetNextBody (world, body)) {
+		dFloat matrix[16];
+		NewtonBodyGetMatrix (body, matrix);
+		checksum += matrix[12] + matrix[13] + matrix[14];
+	}
+	return checksum;
+}
+
+// sorts the times and writes the step statistics
+static void PrintTimes (FILE* const file, double* const times, int frames)
+{
+	double mean = 0.0;
+	for (int i = 0; i < frames; i ++) {
+		mean += times[i];
+	}
+	mean /= frames;
+	qsort (times, frames, sizeof (double), CompareTimes);
+
+	fprintf (file, "\t\t\t\"msPerStep\": {\"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+			 mean, times[0], Percentile (times, frames, 50.0), Percentile (times, frames, 90.0), Percentile (times, frames, 99.0), times[frames - 1]);
+}
+
+static void RunScene (FILE* const file, const BenchmarkScene& scene, int threads, int frames, int broadphase, int maintenance, bool first, const char* const recordName)
+{
+	ResetRandom ();
+	NewtonWorld* const world = NewtonCreate ();
+	NewtonSetThreadsCount (world, threads);
+	NewtonSelectBroadphaseAlgorithm (world, broadphase);
+	NewtonSetBroadphaseMaintenanceBudget (world, maintenance);
+	if (recordName && !NewtonRecorderStart (world, recordName)) {
+		fprintf (stderr, "can't create %s\n", recordName);
+	}
+	scene.m_build (world);
+	const int bodies = NewtonWorldGetBodyCount (world);
+
+	// phases are summed over all the threads rows, so worker phases report cpu time rather than wall time
+	double phases[NEWTON_PROFILER_COUNTERS_COUNT];
+	double counts[6];
+	memset (phases, 0, sizeof (phases));
+	memset (counts, 0, sizeof (counts));
+
+	double* const times = new double[frames];
+	for (int i = 0; i < frames; i ++) {
+		double start = GetTimeInMilliseconds ();
+		NewtonUpdate (world, BENCHMARK_TIMESTEP);
+		times[i] = GetTimeInMilliseconds () - start;
+
+		NewtonWorldCounters counters;
+		NewtonReadWorldCounters (world, &counters);
+		for (int j = 0; j < NEWTON_PROFILER_COUNTERS_COUNT; j ++) {
+			for (int k = 0; k <= NEWTON_MAX_THREADS_COUNT; k ++) {
+				phases[j] += double (counters.m_ticks[k][j]) * 1.0e-6;
+			}
+		}
+		counts[0] += counters.m_pairsTested;
+		counts[1] += counters.m_contactPoints;
+		counts[2] += counters.m_islands;
+		counts[3] += counters.m_solverRows;
+		counts[4] += counters.m_solverIterations;
+		counts[5] += counters.m_sleepingBodies;
+
+		if (scene.m_postUpdate) {
+			scene.m_postUpdate (world);
+		}
+	}
+
+	fprintf (file, "%s\t\t{\n", first ? "" : ",\n");
+	fprintf (file, "\t\t\t\"scene\": \"%s\",\n", scene.m_name);
+	fprintf (file, "\t\t\t\"threads\": %d,\n", NewtonGetThreadsCount (world));
+	fprintf (file, "\t\t\t\"broadphase\": %d,\n", NewtonGetBroadphaseAlgorithm (world));
+	fprintf (file, "\t\t\t\"maintenanceBudget\": %d,\n", NewtonGetBroadphaseMaintenanceBudget (world));
+	fprintf (file, "\t\t\t\"bodies\": %d,\n", bodies);
+	fprintf (file, "\t\t\t\"finalBodies\": %d,\n", NewtonWorldGetBodyCount (world));
+	PrintTimes (file, times, frames);
+	fprintf (file, "\t\t\t\"phasesMsPerStep\": {");
+	for (int j = 0; j < NEWTON_PROFILER_COUNTERS_COUNT; j ++) {
+		fprintf (file, "%s\"%s\": %.4f", j ? ", " : "", m_phaseNames[j], phases[j] / frames);
+	}
+	fprintf (file, "},\n");
+	fprintf (file, "\t\t\t\"countsPerStep\": {\"pairsTested\": %.1f, \"contactPoints\": %.1f, \"islands\": %.1f, \"solverRows\": %.1f, \"solverIterations\": %.1f, \"sleepingBodies\": %.1f},\n",
+			 counts[0] / frames, counts[1] / frames, counts[2] / frames, counts[3] / frames, counts[4] / frames, counts[5] / frames);
+	fprintf (file, "\t\t\t\"checksum\": %.6f,\n", BodiesChecksum (world));
+	fprintf (file, "\t\t\t\"stateCRC\": %u\n", NewtonWorldGetStateCRC (world));
+	fprintf (file, "\t\t}");
+	fflush (file);
+
+	// the scene shapes belong to the world, release them before the world goes away
+	delete[] times;
+	if (scene.m_destroy) {
+		scene.m_destroy ();
+	}
+	NewtonDestroy (world);
+}
+
+
+struct ReplayTimes
+{
+	int m_count;
+	int m_capacity;
+	double* m_times;
+};
+
+static void OnReplayFrame (void* const userData, int frame, dFloat milliseconds, unsigned recordedCRC, unsigned replayCRC)
+{
+	ReplayTimes* const replay = (ReplayTimes*) userData;
+	if (replay->m_count == replay->m_capacity) {
+		replay->m_capacity = replay->m_capacity ? replay->m_capacity * 2 : 256;
+		replay->m_times = (double*) realloc (replay->m_times, replay->m_capacity * sizeof (double));
+	}
+	replay->m_times[replay->m_count] = milliseconds;
+	replay->m_count ++;
+}
+
+static bool ReplayLog (FILE* const file, const char* const replayName, int threads, int broadphase, int maintenance, bool first, bool* const diverged)
+{
+	NewtonWorld* const world = NewtonCreate ();
+	NewtonSetThreadsCount (world, threads);
+	NewtonSelectBroadphaseAlgorithm (world, broadphase);
+	NewtonSetBroadphaseMaintenanceBudget (world, maintenance);
+
+	ReplayTimes replay;
+	memset (&replay, 0, sizeof (replay));
+	const int divergentFrame = NewtonReplay (world, replayName, OnReplayFrame, &replay);
+	if ((divergentFrame == -2) || !replay.m_count) {
+		free (replay.m_times);
+		NewtonDestroy (world);
+		return false;
+	}
+
+	fprintf (file, "%s\t\t{\n", first ? "" : ",\n");
+	fprintf (file, "\t\t\t\"replay\": \"%s\",\n", replayName);
+	fprintf (file, "\t\t\t\"threads\": %d,\n", NewtonGetThreadsCount (world));
+	fprintf (file, "\t\t\t\"frames\": %d,\n", replay.m_count);
+	fprintf (file, "\t\t\t\"bodies\": %d,\n", NewtonWorldGetBodyCount (world));
+	PrintTimes (file, replay.m_times, replay.m_count);
+	fprintf (file, "\t\t\t\"firstDivergentFrame\": %d\n", divergentFrame);
+	fprintf (file, "\t\t}");
+	fflush (file);
+	if (divergentFrame >= 0) {
+		fprintf (stderr, "%s diverges at frame %d with %d threads\n", replayName, divergentFrame, threads);
+		*diverged = true;
+	}
+
+	free (replay.m_times);
+	NewtonDestroy (world);
+	return true;
+}
+
+
+static void Usage (const char* const name)
+{
+	fprintf (stderr, "usage: %s [--frames n] [--threads n] [--broadphase n] [--maintenance us] [--scene name] [--out file.json] [--record file | --replay file]\n", name);
+	fprintf (stderr, "  --broadphase selects the broadphase algorithm: 0 generic, 1 persistent, 2 wide\n");
+	fprintf (stderr, "  --maintenance sets the broadphase tree maintenance budget in microseconds per step, 0 uses the tree rotations\n");
+	fprintf (stderr, "  --record runs the scene once at the given thread count and writes a log of the run\n");
+	fprintf (stderr, "  --replay runs a log at 1 to n threads and reports the first frame that does not match the recording,\n");
+	fprintf (stderr, "           the exit status is 2 when a run does not match\n");
+	fprintf (stderr, "  scenes:");
+	for (int i = 0; i < int (sizeof (m_scenes) / sizeof (m_scenes[0])); i ++) {
+		fprintf (stderr, " %s", m_scenes[i].m_name);
+	}
+	fprintf (stderr, "\n");
+}
+
+int main (int argc, char** argv)
+{
+	int frames = BENCHMARK_DEFAULT_FRAMES;
+	int maxThreads = 0;
+	int broadphase = 0;
+	int maintenance = 0;
+	const char* sceneName = NULL;
+	const char* outName = NULL;
+	const char* recordName = NULL;
+	const char* replayName = NULL;
+
+	for (int i = 1; i < argc; i ++) {
+		if (!strcmp (argv[i], "--frames") && (i + 1 < argc)) {
+			frames = atoi (argv[++ i]);
+		} else if (!strcmp (argv[i], "--threads") && (i + 1 < argc)) {
+			maxThreads = atoi (argv[++ i]);
+		} else if (!strcmp (argv[i], "--broadphase") && (i + 1 < argc)) {
+			broadphase = atoi (argv[++ i]);
+		} else if (!strcmp (argv[i], "--maintenance") && (i + 1 < argc)) {
+			maintenance = atoi (argv[++ i]);
+		} else if (!strcmp (argv[i], "--scene") && (i + 1 < argc)) {
+			sceneName = argv[++ i];
+		} else if (!strcmp (argv[i], "--out") && (i + 1 < argc)) {
+			outName = argv[++ i];
+		} else if (!strcmp (argv[i], "--record") && (i + 1 < argc)) {
+			recordName = argv[++ i];
+		} else if (!strcmp (argv[i], "--replay") && (i + 1 < argc)) {
+			replayName = argv[++ i];
+		} else {
+			Usage (argv[0]);
+			return 1;
+		}
+	}
+
+	if (recordName && (!sceneName || replayName)) {
+		Usage (argv[0]);
+		return 1;
+	}
+
+	// by default run from one thread up to the number the engine can use
+	int minThreads = 1;
+	if (recordName) {
+		maxThreads = (maxThreads > 0) ? maxThreads : 1;
+		minThreads = maxThreads;
+	} else if (maxThreads <= 0) {
+		NewtonWorld* const world = NewtonCreate ();
+		maxThreads = NewtonGetMaxThreadsCount (world);
+		NewtonDestroy (world);
+	}
+	if (frames <= 0) {
+		frames = 1;
+	}
+
+	FILE* const file = outName ? fopen (outName, "wt") : stdout;
+	if (!file) {
+		fprintf (stderr, "can't open %s\n", outName);
+		return 1;
+	}
+
+	fprintf (file, "{\n");
+	fprintf (file, "\t\"newtonVersion\": %d,\n", NewtonWorldGetVersion ());
+	fprintf (file, "\t\"frames\": %d,\n", frames);
+	fprintf (file, "\t\"timestep\": %f,\n", BENCHMARK_TIMESTEP);
+	fprintf (file, "\t\"results\": [\n");
+
+	bool first = true;
+	bool found = false;
+	bool diverged = false;
+	if (replayName) {
+		found = true;
+		for (int threads = 1; found && (threads <= maxThreads); threads ++) {
+			found = ReplayLog (file, replayName, threads, broadphase, maintenance, first, &diverged);
+			first = false;
+		}
+	} else {
+		for (int i = 0; i < int (sizeof (m_scenes) / sizeof (m_scenes[0])); i ++) {
+			if (!sceneName || !strcmp (sceneName, m_scenes[i].m_name)) {
+				found = true;
+				for (int threads = minThreads; threads <= maxThreads; threads ++) {
+					RunScene (file, m_scenes[i], threads, frames, broadphase, maintenance, first, recordName);
+					first = false;
+				}
+			}
+		}
+	}
+
+	fprintf (file, "\n\t]\n}\n");
+	if (outName) {
+		fclose (file);
+	}
+
+	if (!found) {
+		if (replayName) {
+			fprintf (stderr, "can't replay %s\n", replayName);
+		} else {
+			fprintf (stderr, "unknown scene %s\n", sceneName);
+		}
+		Usage (argv[0]);
+		return 1;
+	}
+	return diverged ? 2 : 0;
+}
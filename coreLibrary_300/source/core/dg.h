@@ -44,6 +44,7 @@
 #include "dgRandom.h"
 #include "dgThread.h"
 #include "dgFastQueue.h"
+#include "dgFrameArena.h"
 #include "dgSPDMatrix.h"
 #include "dgPolyhedra.h"
 #include "dgThreadHive.h"
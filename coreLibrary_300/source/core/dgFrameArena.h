@@ -0,0 +1,176 @@
+/* Copyright (c) <2003-2011> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __dgFrameArena__
+#define __dgFrameArena__
+
+#include "dgStdafx.h"
+#include "dgMemory.h"
+
+#define DG_FRAME_ARENA_ALIGMENT		64
+#define DG_FRAME_ARENA_GRANULARITY	(1024 * 4)
+#define DG_FRAME_ARENA_SERIAL		DG_MAX_THREADS_HIVE_COUNT
+
+// bump pointer memory for data that only lives for one update, it is rewound by Reset. 
+// each worker thread owns a sub arena, the last one is for the serial parts of the update.
+// allocations that do not fit go to the heap, and the sub arena grows to its peak on the next Reset,
+// so after a few updates a steady state simulation does not call the heap.
+class dgFrameArena
+{
+	public:
+	class dgThreadArena
+	{
+		public:
+		dgThreadArena();
+		void* Alloc (dgMemoryAllocator* const allocator, dgInt32 sizeInBytes);
+		void Reserve (dgMemoryAllocator* const allocator, dgInt32 sizeInBytes);
+		void Reset (dgMemoryAllocator* const allocator);
+		void Release (dgMemoryAllocator* const allocator);
+
+		dgUnsigned8* m_memory;
+		dgUnsigned8* m_overflow;
+		dgInt32 m_size;
+		dgInt32 m_used;
+		dgInt32 m_peak;
+	};
+
+	dgFrameArena (dgMemoryAllocator* const allocator);
+	~dgFrameArena ();
+
+	void Reset ();
+	void Reserve (dgInt32 sizeInBytes);
+	void* Alloc (dgInt32 sizeInBytes, dgInt32 threadIndex = DG_FRAME_ARENA_SERIAL);
+
+	dgInt32 GetPeak (dgInt32 threadIndex) const;
+	dgInt32 GetCapacity (dgInt32 threadIndex) const;
+
+	private:
+	dgMemoryAllocator* m_allocator;
+	dgThreadArena m_arenas[DG_FRAME_ARENA_SERIAL + 1];
+};
+
+
+inline dgFrameArena::dgThreadArena::dgThreadArena()
+	:m_memory(NULL)
+	,m_overflow(NULL)
+	,m_size(0)
+	,m_used(0)
+	,m_peak(0)
+{
+}
+
+inline void* dgFrameArena::dgThreadArena::Alloc (dgMemoryAllocator* const allocator, dgInt32 sizeInBytes)
+{
+	dgInt32 size = (sizeInBytes + DG_FRAME_ARENA_ALIGMENT - 1) & (-DG_FRAME_ARENA_ALIGMENT);
+	dgUnsigned8* ptr;
+	if ((m_used + size) <= m_size) {
+		ptr = &m_memory[m_used];
+	} else {
+		// out of space, link a heap block that is released on the next reset, the first bytes hold the link
+		dgUnsigned8* const block = (dgUnsigned8*) allocator->MallocLow (size + DG_FRAME_ARENA_ALIGMENT, DG_FRAME_ARENA_ALIGMENT);
+		*((dgUnsigned8**) block) = m_overflow;
+		m_overflow = block;
+		ptr = &block[DG_FRAME_ARENA_ALIGMENT];
+	}
+	m_used += size;
+	m_peak = dgMax (m_peak, m_used);
+	return ptr;
+}
+
+inline void dgFrameArena::dgThreadArena::Reserve (dgMemoryAllocator* const allocator, dgInt32 sizeInBytes)
+{
+	dgAssert (!m_used);
+	if (sizeInBytes > m_size) {
+		if (m_memory) {
+			allocator->FreeLow (m_memory);
+		}
+		m_size = (sizeInBytes + DG_FRAME_ARENA_GRANULARITY - 1) & (-DG_FRAME_ARENA_GRANULARITY);
+		m_memory = (dgUnsigned8*) allocator->MallocLow (m_size, DG_FRAME_ARENA_ALIGMENT);
+	}
+}
+
+inline void dgFrameArena::dgThreadArena::Reset (dgMemoryAllocator* const allocator)
+{
+	while (m_overflow) {
+		dgUnsigned8* const block = m_overflow;
+		m_overflow = *((dgUnsigned8**) block);
+		allocator->FreeLow (block);
+	}
+	m_used = 0;
+	Reserve (allocator, m_peak);
+}
+
+inline void dgFrameArena::dgThreadArena::Release (dgMemoryAllocator* const allocator)
+{
+	Reset (allocator);
+	if (m_memory) {
+		allocator->FreeLow (m_memory);
+	}
+	m_memory = NULL;
+	m_size = 0;
+}
+
+
+inline dgFrameArena::dgFrameArena (dgMemoryAllocator* const allocator)
+	:m_allocator(allocator)
+{
+}
+
+inline dgFrameArena::~dgFrameArena ()
+{
+	for (dgInt32 i = 0; i <= DG_FRAME_ARENA_SERIAL; i ++) {
+		m_arenas[i].Release (m_allocator);
+	}
+}
+
+inline void dgFrameArena::Reset ()
+{
+	for (dgInt32 i = 0; i <= DG_FRAME_ARENA_SERIAL; i ++) {
+		m_arenas[i].Reset (m_allocator);
+	}
+}
+
+inline void dgFrameArena::Reserve (dgInt32 sizeInBytes)
+{
+	for (dgInt32 i = 0; i <= DG_FRAME_ARENA_SERIAL; i ++) {
+		m_arenas[i].Reserve (m_allocator, sizeInBytes);
+	}
+}
+
+inline void* dgFrameArena::Alloc (dgInt32 sizeInBytes, dgInt32 threadIndex)
+{
+	dgAssert (threadIndex >= 0);
+	dgAssert (threadIndex <= DG_FRAME_ARENA_SERIAL);
+	return m_arenas[threadIndex].Alloc (m_allocator, sizeInBytes);
+}
+
+inline dgInt32 dgFrameArena::GetPeak (dgInt32 threadIndex) const
+{
+	return ((threadIndex >= 0) && (threadIndex <= DG_FRAME_ARENA_SERIAL)) ? m_arenas[threadIndex].m_peak : 0;
+}
+
+inline dgInt32 dgFrameArena::GetCapacity (dgInt32 threadIndex) const
+{
+	return ((threadIndex >= 0) && (threadIndex <= DG_FRAME_ARENA_SERIAL)) ? m_arenas[threadIndex].m_size : 0;
+}
+
+#endif
+
@@ -68,15 +68,44 @@ class dgGlobalAllocator: public dgMemoryAllocator, public dgList<dgMemoryAllocat
 	}
 
 
+	// the list nodes come from the bins of this allocator, so the list has its own lock instead of m_lock
+	void AddAllocator (dgMemoryAllocator* const allocator)
+	{
+		m_allocatorsLock.Lock();
+		Append (allocator);
+		m_allocatorsLock.Unlock();
+	}
+
+	void RemoveAllocator (dgMemoryAllocator* const allocator)
+	{
+		m_allocatorsLock.Lock();
+		Remove (allocator);
+		m_allocatorsLock.Unlock();
+	}
+
 	dgInt32 GetMemoryUsed () const
 	{
 		dgInt32 mem = m_memoryUsed;
+		m_allocatorsLock.Lock();
 		for (dgList<dgMemoryAllocator*>::dgListNode* node = GetFirst(); node; node = node->GetNext()) {
 			mem += node->GetInfo()->GetMemoryUsed();
 		}
+		m_allocatorsLock.Unlock();
+		return mem;
+	}
+
+	dgInt32 GetThreadMemoryUsed (dgInt32 threadSlot) const
+	{
+		dgInt32 mem = dgMemoryAllocator::GetThreadMemoryUsed(threadSlot);
+		m_allocatorsLock.Lock();
+		for (dgList<dgMemoryAllocator*>::dgListNode* node = GetFirst(); node; node = node->GetNext()) {
+			mem += node->GetInfo()->GetThreadMemoryUsed(threadSlot);
+		}
+		m_allocatorsLock.Unlock();
 		return mem;
 	}
 
+	mutable dgThread::dgCriticalSection m_allocatorsLock;
 	static dgGlobalAllocator m_globalAllocator;
 };
 
@@ -86,30 +115,41 @@ dgGlobalAllocator dgGlobalAllocator::m_globalAllocator;
 
 
 
+// slot of the calling thread in the allocators thread caches, -1 for threads that did not register
+static DG_THREAD_LOCAL dgInt32 dgMemoryThreadSlot = -1;
+static dgInt32 dgMemoryThreadSlotsUsed[DG_MEMORY_THREAD_SLOTS];
+
 dgMemoryAllocator::dgMemoryAllocator ()
 {
-	m_memoryUsed = 0;
-	m_emumerator = 0;
+	Init();
 	SetAllocatorsCallback (dgGlobalAllocator::m_globalAllocator.m_malloc, dgGlobalAllocator::m_globalAllocator.m_free);
-	memset (m_memoryDirectory, 0, sizeof (m_memoryDirectory));
-	dgGlobalAllocator::m_globalAllocator.Append(this);
+	dgGlobalAllocator::m_globalAllocator.AddAllocator(this);
 }
 
 dgMemoryAllocator::dgMemoryAllocator (dgMemAlloc memAlloc, dgMemFree memFree)
 {
-	m_memoryUsed = 0;
-	m_emumerator = 0;
+	Init();
 	SetAllocatorsCallback (memAlloc, memFree);
-	memset (m_memoryDirectory, 0, sizeof (m_memoryDirectory));
 }
 
 
 dgMemoryAllocator::~dgMemoryAllocator  ()
 {
-	dgGlobalAllocator::m_globalAllocator.Remove(this);
+	for (dgInt32 i = 0; i < DG_MEMORY_THREAD_SLOTS; i ++) {
+		FlushThreadCache (i);
+	}
+	dgGlobalAllocator::m_globalAllocator.RemoveAllocator(this);
 	dgAssert (m_memoryUsed == 0);
 }
 
+void dgMemoryAllocator::Init ()
+{
+	m_memoryUsed = 0;
+	m_emumerator = 0;
+	memset (m_memoryDirectory, 0, sizeof (m_memoryDirectory));
+	memset (m_threadCache, 0, sizeof (m_threadCache));
+}
+
 
 void *dgMemoryAllocator::operator new (size_t size) 
 { 
@@ -180,63 +220,96 @@ void *dgMemoryAllocator::Malloc (dgInt32 memsize)
 	dgInt32 entry = paddedSize >> DG_MEMORY_GRANULARITY_BITS;	
 
 	void* ptr;
+	const dgInt32 threadSlot = dgMemoryThreadSlot;
 	if (entry >= DG_MEMORY_BIN_ENTRIES) {
 		ptr = MallocLow (size);
-	} else {
-		if (!m_memoryDirectory[entry].m_cache) {
-			dgMemoryBin* const bin = (dgMemoryBin*) MallocLow (sizeof (dgMemoryBin));
-
-			dgInt32 count = dgInt32 (sizeof (bin->m_pool) / paddedSize);
-			bin->m_info.m_count = 0;
-			bin->m_info.m_totalCount = count;
-			bin->m_info.m_stepInBites = paddedSize;
-			bin->m_info.m_next = m_memoryDirectory[entry].m_first;
-			bin->m_info.m_prev = NULL;
-			if (bin->m_info.m_next) {
-				bin->m_info.m_next->m_info.m_prev = bin;
+	} else if (threadSlot >= 0) {
+		dgMemoryThreadCache& threadCache = m_threadCache[threadSlot];
+		if (!threadCache.m_cache[entry]) {
+			// refill the thread cache with a batch of blocks from the shared bins
+			m_lock.Lock();
+			for (dgInt32 i = 0; i < DG_MEMORY_THREAD_CACHE_BATCH; i ++) {
+				dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (((dgInt8*)MallocBin (entry, memsize)) - DG_MEMORY_GRANULARITY);
+				cashe->m_next = threadCache.m_cache[entry];
+				threadCache.m_cache[entry] = cashe;
 			}
+			m_lock.Unlock();
+			threadCache.m_count[entry] += DG_MEMORY_THREAD_CACHE_BATCH;
+		}
+		dgMemoryCacheEntry* const cashe = threadCache.m_cache[entry];
+		threadCache.m_cache[entry] = cashe->m_next;
+		threadCache.m_count[entry] --;
+		ptr = ((dgInt8*)cashe) + DG_MEMORY_GRANULARITY;
+	} else {
+		m_lock.Lock();
+		ptr = MallocBin (entry, memsize);
+		m_lock.Unlock();
+	}
 
-			m_memoryDirectory[entry].m_first = bin;
+	if (threadSlot >= 0) {
+		m_threadCache[threadSlot].m_memoryUsed += (entry >= DG_MEMORY_BIN_ENTRIES) ? (((dgMemoryInfo*) (ptr)) - 1)->m_size : paddedSize;
+	}
+	return ptr;
+}
 
-			dgInt8* charPtr = reinterpret_cast<dgInt8*>(bin->m_pool);
-			m_memoryDirectory[entry].m_cache = (dgMemoryCacheEntry*)charPtr;
+void *dgMemoryAllocator::MallocBin (dgInt32 entry, dgInt32 memsize)
+{
+	dgInt32 paddedSize = entry << DG_MEMORY_GRANULARITY_BITS;
 
-			for (dgInt32 i = 0; i < count; i ++) {
-				dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) charPtr;
-				cashe->m_next = (dgMemoryCacheEntry*) (charPtr + paddedSize);
-				cashe->m_prev = (dgMemoryCacheEntry*) (charPtr - paddedSize);
-				dgMemoryInfo* const info = ((dgMemoryInfo*) (charPtr + DG_MEMORY_GRANULARITY)) - 1;						
-				info->SaveInfo(this, bin, entry, m_emumerator, memsize);
-				charPtr += paddedSize;
-			}
-			dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (charPtr - paddedSize);
-			cashe->m_next = NULL;
-			m_memoryDirectory[entry].m_cache->m_prev = NULL;
+	void* ptr;
+	if (!m_memoryDirectory[entry].m_cache) {
+		dgMemoryBin* const bin = (dgMemoryBin*) MallocLow (sizeof (dgMemoryBin));
+
+		dgInt32 count = dgInt32 (sizeof (bin->m_pool) / paddedSize);
+		bin->m_info.m_count = 0;
+		bin->m_info.m_totalCount = count;
+		bin->m_info.m_stepInBites = paddedSize;
+		bin->m_info.m_next = m_memoryDirectory[entry].m_first;
+		bin->m_info.m_prev = NULL;
+		if (bin->m_info.m_next) {
+			bin->m_info.m_next->m_info.m_prev = bin;
 		}
 
+		m_memoryDirectory[entry].m_first = bin;
 
-		dgAssert (m_memoryDirectory[entry].m_cache);
+		dgInt8* charPtr = reinterpret_cast<dgInt8*>(bin->m_pool);
+		m_memoryDirectory[entry].m_cache = (dgMemoryCacheEntry*)charPtr;
 
-		dgMemoryCacheEntry* const cashe = m_memoryDirectory[entry].m_cache;
-		m_memoryDirectory[entry].m_cache = cashe->m_next;
-		if (cashe->m_next) {
-			cashe->m_next->m_prev = NULL;
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) charPtr;
+			cashe->m_next = (dgMemoryCacheEntry*) (charPtr + paddedSize);
+			cashe->m_prev = (dgMemoryCacheEntry*) (charPtr - paddedSize);
+			dgMemoryInfo* const info = ((dgMemoryInfo*) (charPtr + DG_MEMORY_GRANULARITY)) - 1;						
+			info->SaveInfo(this, bin, entry, m_emumerator, memsize);
+			charPtr += paddedSize;
 		}
+		dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (charPtr - paddedSize);
+		cashe->m_next = NULL;
+		m_memoryDirectory[entry].m_cache->m_prev = NULL;
+	}
 
-		ptr = ((dgInt8*)cashe) + DG_MEMORY_GRANULARITY;
 
-		dgMemoryInfo* info;
-		info = ((dgMemoryInfo*) (ptr)) - 1;
-		dgAssert (info->m_allocator == this);
+	dgAssert (m_memoryDirectory[entry].m_cache);
 
-		dgMemoryBin* const bin = (dgMemoryBin*) info->m_ptr;
-		bin->m_info.m_count ++;
+	dgMemoryCacheEntry* const cashe = m_memoryDirectory[entry].m_cache;
+	m_memoryDirectory[entry].m_cache = cashe->m_next;
+	if (cashe->m_next) {
+		cashe->m_next->m_prev = NULL;
+	}
 
-		#ifdef __TRACK_MEMORY_LEAKS__
-		m_leaklTracker.InsertBlock (dgInt32 (memsize), ptr);
-		#endif
+	ptr = ((dgInt8*)cashe) + DG_MEMORY_GRANULARITY;
+
+	dgMemoryInfo* info;
+	info = ((dgMemoryInfo*) (ptr)) - 1;
+	dgAssert (info->m_allocator == this);
+
+	dgMemoryBin* const bin = (dgMemoryBin*) info->m_ptr;
+	bin->m_info.m_count ++;
+
+	#ifdef __TRACK_MEMORY_LEAKS__
+	m_leaklTracker.InsertBlock (dgInt32 (memsize), ptr);
+	#endif
 
-	}
 	return ptr;
 }
 
@@ -249,69 +322,154 @@ void dgMemoryAllocator::Free (void* const retPtr)
 
 	dgInt32 entry = info->m_size;
 
+	const dgInt32 threadSlot = dgMemoryThreadSlot;
+	if (threadSlot >= 0) {
+		m_threadCache[threadSlot].m_memoryUsed -= (entry >= DG_MEMORY_BIN_ENTRIES) ? info->m_size : (entry << DG_MEMORY_GRANULARITY_BITS);
+	}
+
 	if (entry >= DG_MEMORY_BIN_ENTRIES) {
 		FreeLow (retPtr);
+	} else if (threadSlot >= 0) {
+		dgMemoryThreadCache& threadCache = m_threadCache[threadSlot];
+		dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (((char*)retPtr) - DG_MEMORY_GRANULARITY);
+		cashe->m_next = threadCache.m_cache[entry];
+		threadCache.m_cache[entry] = cashe;
+		threadCache.m_count[entry] ++;
+		if (threadCache.m_count[entry] > (DG_MEMORY_THREAD_CACHE_BATCH * 2)) {
+			// return a batch to the shared bins, so that a thread that only frees does not hoard memory 
+			m_lock.Lock();
+			for (dgInt32 i = 0; i < DG_MEMORY_THREAD_CACHE_BATCH; i ++) {
+				dgMemoryCacheEntry* const block = threadCache.m_cache[entry];
+				threadCache.m_cache[entry] = block->m_next;
+				FreeBin (((dgInt8*)block) + DG_MEMORY_GRANULARITY);
+			}
+			m_lock.Unlock();
+			threadCache.m_count[entry] -= DG_MEMORY_THREAD_CACHE_BATCH;
+		}
 	} else {
-		#ifdef __TRACK_MEMORY_LEAKS__
-		m_leaklTracker.RemoveBlock (retPtr);
-		#endif
+		m_lock.Lock();
+		FreeBin (retPtr);
+		m_lock.Unlock();
+	}
+}
 
-		dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (((char*)retPtr) - DG_MEMORY_GRANULARITY) ;
+void dgMemoryAllocator::FreeBin (void* const retPtr)
+{
+	dgMemoryInfo* const info = ((dgMemoryInfo*) (retPtr)) - 1;
+	dgInt32 entry = info->m_size;
+	#ifdef __TRACK_MEMORY_LEAKS__
+	m_leaklTracker.RemoveBlock (retPtr);
+	#endif
 
-		dgMemoryCacheEntry* const tmpCashe = m_memoryDirectory[entry].m_cache;
-		if (tmpCashe) {
-			dgAssert (!tmpCashe->m_prev);
-			tmpCashe->m_prev = cashe;
-		}
-		cashe->m_next = tmpCashe;
-		cashe->m_prev = NULL;
+	dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (((char*)retPtr) - DG_MEMORY_GRANULARITY) ;
 
-		m_memoryDirectory[entry].m_cache = cashe;
+	dgMemoryCacheEntry* const tmpCashe = m_memoryDirectory[entry].m_cache;
+	if (tmpCashe) {
+		dgAssert (!tmpCashe->m_prev);
+		tmpCashe->m_prev = cashe;
+	}
+	cashe->m_next = tmpCashe;
+	cashe->m_prev = NULL;
+
+	m_memoryDirectory[entry].m_cache = cashe;
 
-		dgMemoryBin* const bin = (dgMemoryBin *) info->m_ptr;
+	dgMemoryBin* const bin = (dgMemoryBin *) info->m_ptr;
 
-		dgAssert (bin);
+	dgAssert (bin);
 #ifdef _DEBUG
-		dgAssert ((bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY) > 0);
-		memset (retPtr, 0, bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY);
+	dgAssert ((bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY) > 0);
+	memset (retPtr, 0, bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY);
 #endif
 
-		bin->m_info.m_count --;
-		if (bin->m_info.m_count == 0) {
-
-			dgInt32 count = bin->m_info.m_totalCount;
-			dgInt32 sizeInBytes = bin->m_info.m_stepInBites;
-			char* charPtr = bin->m_pool;
-			for (dgInt32 i = 0; i < count; i ++) {
-				dgMemoryCacheEntry* const tmpCashe = (dgMemoryCacheEntry*)charPtr;
-				charPtr += sizeInBytes;
+	bin->m_info.m_count --;
+	if (bin->m_info.m_count == 0) {
 
-				if (tmpCashe == m_memoryDirectory[entry].m_cache) {
-					m_memoryDirectory[entry].m_cache = tmpCashe->m_next;
-				}
+		dgInt32 count = bin->m_info.m_totalCount;
+		dgInt32 sizeInBytes = bin->m_info.m_stepInBites;
+		char* charPtr = bin->m_pool;
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgMemoryCacheEntry* const tmpCashe = (dgMemoryCacheEntry*)charPtr;
+			charPtr += sizeInBytes;
 
-				if (tmpCashe->m_prev) {
-					tmpCashe->m_prev->m_next = tmpCashe->m_next;
-				}
-
-				if (tmpCashe->m_next) {
-					tmpCashe->m_next->m_prev = tmpCashe->m_prev;
-				}
+			if (tmpCashe == m_memoryDirectory[entry].m_cache) {
+				m_memoryDirectory[entry].m_cache = tmpCashe->m_next;
 			}
 
-			if (m_memoryDirectory[entry].m_first == bin) {
-				m_memoryDirectory[entry].m_first = bin->m_info.m_next;
+			if (tmpCashe->m_prev) {
+				tmpCashe->m_prev->m_next = tmpCashe->m_next;
 			}
 
-			if (bin->m_info.m_next) {
-				bin->m_info.m_next->m_info.m_prev = bin->m_info.m_prev;
+			if (tmpCashe->m_next) {
+				tmpCashe->m_next->m_prev = tmpCashe->m_prev;
 			}
-			if (bin->m_info.m_prev) {
-				bin->m_info.m_prev->m_info.m_next = bin->m_info.m_next;
+		}
+
+		if (m_memoryDirectory[entry].m_first == bin) {
+			m_memoryDirectory[entry].m_first = bin->m_info.m_next;
+		}
+
+		if (bin->m_info.m_next) {
+			bin->m_info.m_next->m_info.m_prev = bin->m_info.m_prev;
+		}
+		if (bin->m_info.m_prev) {
+			bin->m_info.m_prev->m_info.m_next = bin->m_info.m_next;
+		}
+
+		FreeLow (bin);
+	}
+}
+
+dgInt32 dgMemoryAllocator::GetThreadMemoryUsed (dgInt32 threadSlot) const
+{
+	return ((threadSlot >= 0) && (threadSlot < DG_MEMORY_THREAD_SLOTS)) ? m_threadCache[threadSlot].m_memoryUsed : 0;
+}
+
+void dgMemoryAllocator::FlushThreadCache (dgInt32 threadSlot)
+{
+	dgMemoryThreadCache& threadCache = m_threadCache[threadSlot];
+	m_lock.Lock();
+	for (dgInt32 entry = 0; entry < DG_MEMORY_BIN_ENTRIES; entry ++) {
+		while (threadCache.m_cache[entry]) {
+			dgMemoryCacheEntry* const block = threadCache.m_cache[entry];
+			threadCache.m_cache[entry] = block->m_next;
+			FreeBin (((dgInt8*)block) + DG_MEMORY_GRANULARITY);
+		}
+		threadCache.m_count[entry] = 0;
+	}
+	m_lock.Unlock();
+}
+
+dgInt32 dgMemoryAllocator::RegisterThread ()
+{
+	if (dgMemoryThreadSlot < 0) {
+		for (dgInt32 i = 0; i < DG_MEMORY_THREAD_SLOTS; i ++) {
+			if (!dgInterlockedExchange(&dgMemoryThreadSlotsUsed[i], 1)) {
+				dgMemoryThreadSlot = i;
+				break;
 			}
+		}
+	}
+	return dgMemoryThreadSlot;
+}
 
-			FreeLow (bin);
+void dgMemoryAllocator::UnregisterThread ()
+{
+	const dgInt32 threadSlot = dgMemoryThreadSlot;
+	if (threadSlot >= 0) {
+		// give the cached blocks back to all allocators before the slot can be reused by another thread
+		dgGlobalAllocator& globalAllocator = dgGlobalAllocator::m_globalAllocator;
+		dgMemoryThreadSlot = -1;
+		globalAllocator.FlushThreadCache (threadSlot);
+		globalAllocator.m_threadCache[threadSlot].m_memoryUsed = 0;
+		// worlds on other threads can create or destroy allocators while this thread exits
+		globalAllocator.m_allocatorsLock.Lock();
+		for (dgList<dgMemoryAllocator*>::dgListNode* node = globalAllocator.GetFirst(); node; node = node->GetNext()) {
+			dgMemoryAllocator* const allocator = node->GetInfo();
+			allocator->FlushThreadCache (threadSlot);
+			allocator->m_threadCache[threadSlot].m_memoryUsed = 0;
 		}
+		globalAllocator.m_allocatorsLock.Unlock();
+		dgInterlockedExchange(&dgMemoryThreadSlotsUsed[threadSlot], 0);
 	}
 }
 
@@ -402,6 +560,11 @@ dgInt32 dgGetMemoryUsed ()
 	return dgGlobalAllocator::m_globalAllocator.GetMemoryUsed();
 }
 
+dgInt32 dgGetThreadMemoryUsed (dgInt32 threadSlot)
+{
+	return dgGlobalAllocator::m_globalAllocator.GetThreadMemoryUsed(threadSlot);
+}
+
 // this can be used by function that allocates large memory pools memory locally on the stack
 // this by pases the pool allocation because this should only be used for very large memory blocks.
 // this was using virtual memory on windows but 
@@ -441,12 +604,9 @@ void* dgApi dgMalloc (size_t size, dgMemoryAllocator* const allocator)
 	void* ptr = NULL;
 	dgAssert (allocator);
 
-	DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
 	if (size) {
 		ptr = allocator->Malloc (dgInt32 (size));
 	}
-
-	DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
 	return ptr;
 
 	
@@ -457,12 +617,10 @@ void* dgApi dgMalloc (size_t size, dgMemoryAllocator* const allocator)
 void dgApi dgFree (void* const ptr)
 {
 	if (ptr) {
-		DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
 		dgMemoryAllocator::dgMemoryInfo* info;
 		info = ((dgMemoryAllocator::dgMemoryInfo*) ptr) - 1; 
 		dgAssert (info->m_allocator);
 		info->m_allocator->Free (ptr);
-		DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
 	}
 }
 
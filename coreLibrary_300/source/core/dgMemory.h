@@ -23,6 +23,7 @@
 #define __dgMemory__
 
 #include "dgStdafx.h"
+#include "dgThread.h"
 
 #ifdef _DEBUG
 //#define __TRACK_MEMORY_LEAKS__
@@ -45,6 +46,7 @@ typedef void (dgApi *dgMemFree) (void* const ptr, dgUnsigned32 size);
 //void dgSetMemoryDrivers (dgMemAlloc alloc, dgMemFree free);
 void dgSetGlobalAllocators (dgMemAlloc alloc, dgMemFree free);
 dgInt32 dgGetMemoryUsed ();
+dgInt32 dgGetThreadMemoryUsed (dgInt32 threadSlot);
 
 
 #define DG_CLASS_ALLOCATOR_NEW(allocator)			inline void *operator new (size_t size, dgMemoryAllocator* const allocator) { return dgMalloc(size, allocator);}
@@ -82,6 +84,8 @@ class dgMemoryAllocator
 	#define DG_MEMORY_SIZE						(1024 - 64)
 	#define DG_MEMORY_BIN_SIZE					(1024 * 16)
 	#define DG_MEMORY_BIN_ENTRIES				(DG_MEMORY_SIZE / DG_MEMORY_GRANULARITY)
+	#define DG_MEMORY_THREAD_SLOTS				64
+	#define DG_MEMORY_THREAD_CACHE_BATCH		16
 
 	public: 
 
@@ -141,6 +145,15 @@ class dgMemoryAllocator
 		dgMemoryCacheEntry* m_cache;
 	};
 
+	// blocks owned by one registered thread, they move to and from the shared directory in batches 
+	class dgMemoryThreadCache
+	{
+		public: 
+		dgMemoryCacheEntry* m_cache[DG_MEMORY_BIN_ENTRIES];
+		dgInt32 m_count[DG_MEMORY_BIN_ENTRIES];
+		dgInt32 m_memoryUsed;
+	};
+
 
 	// this is a simple memory leak tracker, it uses an flat array of two megabyte indexed by a hatch code
 #ifdef __TRACK_MEMORY_LEAKS__
@@ -181,15 +194,26 @@ class dgMemoryAllocator
 	void *Malloc (dgInt32 memsize);
 	void Free (void* const retPtr);
 
+	dgInt32 GetThreadMemoryUsed (dgInt32 threadSlot) const;
+	void FlushThreadCache (dgInt32 threadSlot);
+
+	// threads that allocate concurrently register to get a private cache in front of the bins
+	static dgInt32 RegisterThread ();
+	static void UnregisterThread ();
 
 	protected:
 	dgMemoryAllocator (dgMemAlloc memAlloc, dgMemFree memFree);
+	void Init ();
+	void *MallocBin (dgInt32 entry, dgInt32 memsize);
+	void FreeBin (void* const retPtr);
 
 	dgInt32 m_emumerator;
 	dgInt32 m_memoryUsed;
 	dgMemFree m_free;
 	dgMemAlloc m_malloc;
+	dgThread::dgCriticalSection m_lock;
 	dgMemDirectory m_memoryDirectory[DG_MEMORY_BIN_ENTRIES + 1]; 
+	dgMemoryThreadCache m_threadCache[DG_MEMORY_THREAD_SLOTS];
 
 #ifdef __TRACK_MEMORY_LEAKS__
 	dgMemoryLeaksTracker m_leaklTracker;
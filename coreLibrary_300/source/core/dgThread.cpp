@@ -111,6 +111,16 @@ void dgThread::SetPriority(int priority)
 {
 }
 
+bool dgThread::SetAffinity (dgInt32 cpuIndex)
+{
+	return false;
+}
+
+dgInt32 dgThread::GetNumaNodeCpus (dgInt32 node, dgInt32* const cpus, dgInt32 maxCount)
+{
+	return 0;
+}
+
 
 void* dgThread::dgThreadSystemCallback(void* threadData)
 {
@@ -220,6 +230,65 @@ void dgThread::SetPriority(int priority)
 	pthread_setschedparam (m_handle, policy, &param);
 }
 
+bool dgThread::SetAffinity (dgInt32 cpuIndex)
+{
+	#if defined (__linux__) && !defined (ANDROID)
+		cpu_set_t cpuSet;
+		CPU_ZERO (&cpuSet);
+		if (cpuIndex >= 0) {
+			if (cpuIndex >= CPU_SETSIZE) {
+				return false;
+			}
+			CPU_SET (cpuIndex, &cpuSet);
+		} else {
+			sched_getaffinity (0, sizeof (cpuSet), &cpuSet);
+		}
+		return pthread_setaffinity_np (m_handle, sizeof (cpuSet), &cpuSet) == 0;
+	#else
+		return false;
+	#endif
+}
+
+dgInt32 dgThread::GetNumaNodeCpus (dgInt32 node, dgInt32* const cpus, dgInt32 maxCount)
+{
+	dgInt32 count = 0;
+	#if defined (__linux__) && !defined (ANDROID)
+		char name[256];
+		sprintf (name, "/sys/devices/system/node/node%d/cpulist", node);
+		FILE* const file = fopen (name, "rb");
+		if (file) {
+			// the list is a comma separated set of ranges, ex: 0-7,16-23
+			int cpu0;
+			while ((count < maxCount) && (fscanf (file, "%d", &cpu0) == 1)) {
+				int cpu1 = cpu0;
+				int ch = fgetc (file);
+				if (ch == '-') {
+					if (fscanf (file, "%d", &cpu1) != 1) {
+						break;
+					}
+					ch = fgetc (file);
+				}
+				for (dgInt32 i = cpu0; (i <= cpu1) && (count < maxCount); i ++) {
+					cpus[count] = i;
+					count ++;
+				}
+				if (ch != ',') {
+					break;
+				}
+			}
+			fclose (file);
+		} else if (!node) {
+			// kernels without numa support see all cpus as node zero
+			dgInt32 cpuCount = dgInt32 (sysconf (_SC_NPROCESSORS_ONLN));
+			for (dgInt32 i = 0; (i < cpuCount) && (count < maxCount); i ++) {
+				cpus[count] = i;
+				count ++;
+			}
+		}
+	#endif
+	return count;
+}
+
 
 void dgThread::SuspendExecution (dgSemaphore& mutex)
 {
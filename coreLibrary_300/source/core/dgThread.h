@@ -83,6 +83,10 @@ public:
 	dgInt32 GetPriority() const;
 	void SetPriority(int priority);
 
+	// pin the thread to one logical cpu, a negative index restores the process affinity
+	bool SetAffinity (dgInt32 cpuIndex);
+	static dgInt32 GetNumaNodeCpus (dgInt32 node, dgInt32* const cpus, dgInt32 maxCount);
+
 	protected:
 	void Init ();
 	void Init (const char* const name, dgInt32 id);
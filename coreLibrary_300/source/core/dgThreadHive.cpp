@@ -27,10 +27,50 @@
 
 
 
+dgThreadHive::dgThreadSignal::dgThreadSignal()
+	:m_token(0)
+	,m_semaphore()
+{
+}
+
+void dgThreadHive::dgThreadSignal::Release()
+{
+	// a negative token means the waiting thread is parked on the semaphore
+	if (dgAtomicExchangeAndAdd(&m_token, 1) < 0) {
+		m_semaphore.Release();
+	}
+}
+
+void dgThreadHive::dgThreadSignal::Wait(dgInt32 spinCount, dgUnsigned64& spinTime, dgUnsigned64& parkTime)
+{
+	// a negative spin count polls for ever
+	if (spinCount) {
+		dgUnsigned64 time0 = dgGetTimeInMicrosenconds();
+		for (dgInt32 i = 0; ((spinCount < 0) || (i < spinCount)) && (dgAtomicExchangeAndAdd(&m_token, 0) <= 0); i ++) {
+			dgSpinPause();
+		}
+		spinTime += dgGetTimeInMicrosenconds() - time0;
+	}
+
+	if (dgAtomicExchangeAndAdd(&m_token, -1) <= 0) {
+		dgUnsigned64 time0 = dgGetTimeInMicrosenconds();
+		m_semaphore.Wait();
+		parkTime += dgGetTimeInMicrosenconds() - time0;
+	}
+}
+
+
 dgThreadHive::dgThreadBee::dgThreadBee()
 	:dgThread()
 	,m_isBusy(0)
+	,m_memorySlot(-1)
+	,m_jobsHead(0)
+	,m_jobsTail(0)
 	,m_ticks (0)
+	,m_steals (0)
+	,m_idles (0)
+	,m_spinTime (0)
+	,m_parkTime (0)
 	,m_myMutex()
 	,m_hive(NULL)
 	,m_allocator(NULL)
@@ -70,11 +110,13 @@ void dgThreadHive::dgThreadBee::SetPerfomanceCounter(OnGetPerformanceCountCallba
 
 void dgThreadHive::dgThreadBee::Execute (dgInt32 threadId)
 {
+	// bees get a private cache in the memory allocators, so that jobs can allocate without contention
+	m_memorySlot = dgMemoryAllocator::RegisterThread();
 	m_hive->OnBeginWorkerThread (threadId);
 
 	while (!m_terminate) {
 		dgInterlockedExchange(&m_isBusy, 0);
-		SuspendExecution(m_myMutex);
+		m_myMutex.Wait(m_hive->GetSpinCount(), m_spinTime, m_parkTime);
 		dgInterlockedExchange(&m_isBusy, 1);
 		if (!m_terminate) {
 			RunNextJobInQueue(threadId);
@@ -85,30 +127,66 @@ void dgThreadHive::dgThreadBee::Execute (dgInt32 threadId)
 	dgInterlockedExchange(&m_isBusy, 0);
 
 	m_hive->OnEndWorkerThread (threadId);
+	dgMemoryAllocator::UnregisterThread();
 }
 
 
+bool dgThreadHive::dgThreadBee::PushJob (const dgThreadJob& job)
+{
+	// only the master thread push jobs, and only while the bees are parked
+	dgAssert (m_jobsTail < DG_THREAD_BEE_JOB_SIZE);
+	m_jobsPool[m_jobsTail] = job;
+	m_jobsTail ++;
+	return m_jobsTail < DG_THREAD_BEE_JOB_SIZE;
+}
+
+bool dgThreadHive::dgThreadBee::PopJob (dgThreadJob& job)
+{
+	// the queue is read only while the bees are running, so the owner and the thieves can claim jobs with a single atomic add
+	if (m_jobsHead < m_jobsTail) {
+		dgInt32 index = dgAtomicExchangeAndAdd(&m_jobsHead, 1);
+		if (index < m_jobsTail) {
+			job = m_jobsPool[index];
+			return true;
+		}
+	}
+	return false;
+}
+
+void dgThreadHive::dgThreadBee::ResetJobs ()
+{
+	m_jobsHead = 0;
+	m_jobsTail = 0;
+}
+
 void dgThreadHive::dgThreadBee::RunNextJobInQueue(dgInt32 threadId)
 {
 	dgUnsigned32 ticks = m_getPerformanceCount();
 
-	bool isEmpty = false;
-	do {
-		dgThreadJob job;
-		dgAssert (threadId == m_id);
-		m_hive->m_jobsCriticalSection.Lock();
-		isEmpty = m_hive->m_jobsPool.IsEmpty();
-		if (!isEmpty) {
-			job = m_hive->m_jobsPool.GetHead();
-			m_hive->m_jobsPool.Pop();
-		}
-		m_hive->m_jobsCriticalSection.Unlock();
+	dgAssert (threadId == m_id);
+	dgThreadJob job;
 
-		if (!isEmpty) {
-			job.m_callback (job.m_context0, job.m_context1, m_id);
-		}
-	} while (!isEmpty);
+	// drain my own queue first
+	while (PopJob (job)) {
+		job.m_callback (job.m_context0, job.m_context1, m_id);
+	}
 
+	// then steal from the other bees until a full sweep finds all queues empty
+	const dgInt32 beesCount = m_hive->m_beesCount;
+	dgThreadBee* const bees = m_hive->m_workerBees;
+	for (bool stealing = true; stealing; ) {
+		stealing = false;
+		for (dgInt32 i = 1; i < beesCount; i ++) {
+			dgThreadBee* const victim = &bees[(threadId + i) % beesCount];
+			if (victim->PopJob (job)) {
+				m_steals ++;
+				stealing = true;
+				job.m_callback (job.m_context0, job.m_context1, m_id);
+			} else {
+				m_idles ++;
+			}
+		}
+	}
 	
 	m_ticks += (m_getPerformanceCount() - ticks);
 }
@@ -117,13 +195,23 @@ void dgThreadHive::dgThreadBee::RunNextJobInQueue(dgInt32 threadId)
 dgThreadHive::dgThreadHive(dgMemoryAllocator* const allocator)
 	:m_beesCount(0)
 	,m_currentIdleBee(0)
+	,m_spinCount(0)
+	,m_idlePolicy(m_idleBlocking)
+	,m_masterSpinTime(0)
+	,m_masterParkTime(0)
 	,m_workerBees(NULL)
 	,m_myMasterThread(NULL)
 	,m_allocator(allocator)
-	,m_jobsCriticalSection()
 	,m_globalCriticalSection()
-    ,m_jobsPool(allocator)
+	,m_profiler(allocator)
+	,m_graphJobsCount(0)
+	,m_graphEdgesCount(0)
+	,m_graphReadyHead(0)
+	,m_graphReadyTail(0)
 {
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		m_beeAffinity[i] = -1;
+	}
 }
 
 dgThreadHive::~dgThreadHive()
@@ -159,8 +247,107 @@ dgUnsigned32 dgThreadHive::GetPerfomanceTicks (dgUnsigned32 threadIndex) const
 	return (m_beesCount && (threadIndex < dgUnsigned32(m_beesCount))) ? m_workerBees[threadIndex].m_ticks : 0;
 }
 
+dgUnsigned32 dgThreadHive::GetStealCount (dgUnsigned32 threadIndex) const
+{
+	return (m_beesCount && (threadIndex < dgUnsigned32(m_beesCount))) ? m_workerBees[threadIndex].m_steals : 0;
+}
+
+dgUnsigned32 dgThreadHive::GetIdleCount (dgUnsigned32 threadIndex) const
+{
+	return (m_beesCount && (threadIndex < dgUnsigned32(m_beesCount))) ? m_workerBees[threadIndex].m_idles : 0;
+}
+
+dgInt32 dgThreadHive::GetThreadMemoryUsed (dgInt32 threadIndex) const
+{
+	return (m_beesCount && (threadIndex >= 0) && (threadIndex < m_beesCount)) ? dgGetThreadMemoryUsed (m_workerBees[threadIndex].m_memorySlot) : 0;
+}
+
+
 
 
+void dgThreadHive::SetIdlePolicy (dgIdlePolicy policy, dgInt32 spinCount)
+{
+	m_idlePolicy = policy;
+	m_spinCount = dgMax (spinCount, 0);
+	if ((policy == m_idleSpinThenPark) && !m_spinCount) {
+		m_spinCount = DG_THREAD_DEFAULT_SPIN_COUNT;
+	}
+}
+
+dgThreadHive::dgIdlePolicy dgThreadHive::GetIdlePolicy () const
+{
+	return m_idlePolicy;
+}
+
+dgInt32 dgThreadHive::GetSpinCount() const
+{
+	switch (m_idlePolicy)
+	{
+		case m_idleSpinThenPark:
+			return m_spinCount;
+		case m_idleBusyPoll:
+			return -1;
+		case m_idleBlocking:
+		default:
+			return 0;
+	}
+}
+
+// the master thread times are read with a thread index equal to the worker count
+dgUnsigned32 dgThreadHive::GetSpinTime (dgUnsigned32 threadIndex) const
+{
+	if (m_beesCount && (threadIndex < dgUnsigned32(m_beesCount))) {
+		return dgUnsigned32 (m_workerBees[threadIndex].m_spinTime);
+	}
+	return (threadIndex == dgUnsigned32(m_beesCount)) ? dgUnsigned32 (m_masterSpinTime) : 0;
+}
+
+dgUnsigned32 dgThreadHive::GetParkTime (dgUnsigned32 threadIndex) const
+{
+	if (m_beesCount && (threadIndex < dgUnsigned32(m_beesCount))) {
+		return dgUnsigned32 (m_workerBees[threadIndex].m_parkTime);
+	}
+	return (threadIndex == dgUnsigned32(m_beesCount)) ? dgUnsigned32 (m_masterParkTime) : 0;
+}
+
+void dgThreadHive::SetThreadAffinity (dgInt32 threadIndex, dgInt32 cpuIndex)
+{
+	if ((threadIndex >= 0) && (threadIndex < DG_MAX_THREADS_HIVE_COUNT)) {
+		// remember the cpu so that the affinity survives a change in the thread count
+		m_beeAffinity[threadIndex] = (cpuIndex >= 0) ? cpuIndex : -1;
+		if (threadIndex < m_beesCount) {
+			m_workerBees[threadIndex].SetAffinity (m_beeAffinity[threadIndex]);
+		}
+	}
+}
+
+dgInt32 dgThreadHive::GetThreadAffinity (dgInt32 threadIndex) const
+{
+	return ((threadIndex >= 0) && (threadIndex < DG_MAX_THREADS_HIVE_COUNT)) ? m_beeAffinity[threadIndex] : -1;
+}
+
+dgInt32 dgThreadHive::SetThreadsNumaNode (dgInt32 node)
+{
+	dgInt32 cpus[256];
+	dgInt32 count = (node >= 0) ? dgThread::GetNumaNodeCpus (node, cpus, sizeof (cpus) / sizeof (cpus[0])) : 0;
+	if (count) {
+		// deal the node cpus to the bees, wrap around if the node has fewer cpus than threads
+		for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+			SetThreadAffinity (i, cpus[i % count]);
+		}
+	}
+	return count;
+}
+
+bool dgThreadHive::HasThreadAffinity () const
+{
+	for (dgInt32 i = 0; i < m_beesCount; i ++) {
+		if (m_beeAffinity[i] >= 0) {
+			return true;
+		}
+	}
+	return false;
+}
 
 dgInt32 dgThreadHive::GetThreadCount() const
 {
@@ -171,7 +358,13 @@ void dgThreadHive::ClearTimers()
 {
 	for (dgInt32 i = 0; i < m_beesCount; i ++) {
 		m_workerBees[i].m_ticks = 0;
+		m_workerBees[i].m_steals = 0;
+		m_workerBees[i].m_idles = 0;
+		m_workerBees[i].m_spinTime = 0;
+		m_workerBees[i].m_parkTime = 0;
 	}
+	m_masterSpinTime = 0;
+	m_masterParkTime = 0;
 }
 
 dgInt32 dgThreadHive::GetMaxThreadCount() const
@@ -189,6 +382,7 @@ void dgThreadHive::SetThreadsCount (dgInt32 threads)
 		m_beesCount = 0;
 	}
 
+	m_currentIdleBee = 0;
 	if (m_beesCount) {
 		m_workerBees = new (m_allocator) dgThreadBee[dgUnsigned32 (m_beesCount)];
 
@@ -196,8 +390,31 @@ void dgThreadHive::SetThreadsCount (dgInt32 threads)
 			char name[256];
 			sprintf (name, "dgThreadBee%d", i);
 			m_workerBees[i].SetUp(m_allocator, name, i, this);
+			if (m_beeAffinity[i] >= 0) {
+				m_workerBees[i].SetAffinity (m_beeAffinity[i]);
+			}
 		}
 	}
+
+	if (m_profiler.IsCapturing()) {
+		// the tracks of the old threads are gone, start over with the new thread count
+		m_profiler.StartCapture (GetThreadCount());
+	}
+}
+
+void dgThreadHive::StartProfilerCapture ()
+{
+	m_profiler.StartCapture (GetThreadCount());
+}
+
+void dgThreadHive::StopProfilerCapture ()
+{
+	m_profiler.StopCapture ();
+}
+
+dgInt32 dgThreadHive::SaveProfilerTrace (const char* const fileName) const
+{
+	return m_profiler.SaveTrace (fileName);
 }
 
 
@@ -209,9 +426,11 @@ void dgThreadHive::QueueJob (dgWorkerThreadTaskCallback callback, void* const co
 		#ifdef DG_USE_THREAD_EMULATION
 			callback (context0, context1, 0);
 		#else 
+			// deal the jobs round robin, idle bees will steal from the busy ones
 			dgThreadJob job (context0, context1, callback);
-			m_jobsPool.Push(job);
-			if (m_jobsPool.IsFull()) {
+			bool hasRoom = m_workerBees[m_currentIdleBee].PushJob(job);
+			m_currentIdleBee = (m_currentIdleBee + 1) % m_beesCount;
+			if (!hasRoom) {
 				SynchronizationBarrier ();
 			}
 		#endif
@@ -235,9 +454,102 @@ void dgThreadHive::SynchronizationBarrier ()
 			m_workerBees[i].m_myMutex.Release();
 		}
 
-		m_myMasterThread->SuspendExecution(m_beesCount, m_myMutex);
-		dgAssert (m_jobsPool.IsEmpty());
+		const dgInt32 spinCount = GetSpinCount();
+		for (dgInt32 i = 0; i < m_beesCount; i ++) {
+			m_myMutex[i].Wait(spinCount, m_masterSpinTime, m_masterParkTime);
+		}
+		for (dgInt32 i = 0; i < m_beesCount; i ++) {
+			dgAssert (m_workerBees[i].m_jobsHead >= m_workerBees[i].m_jobsTail);
+			m_workerBees[i].ResetJobs();
+		}
+		m_currentIdleBee = 0;
+	}
+}
+
+
+dgInt32 dgThreadHive::AddGraphJob (dgWorkerThreadTaskCallback callback, void* const context0, void* const context1)
+{
+	dgAssert (m_graphJobsCount < DG_THREAD_GRAPH_JOB_SIZE);
+	dgThreadGraphJob& job = m_graphJobs[m_graphJobsCount];
+	job.m_job = dgThreadJob (context0, context1, callback);
+	job.m_dependencies = 0;
+	job.m_firstEdge = -1;
+	m_graphJobsCount ++;
+	return m_graphJobsCount - 1;
+}
+
+void dgThreadHive::AddGraphDependency (dgInt32 job, dgInt32 dependsOnJob)
+{
+	dgAssert (job < m_graphJobsCount);
+	dgAssert (dependsOnJob < m_graphJobsCount);
+	dgAssert (job != dependsOnJob);
+	dgAssert (m_graphEdgesCount < DG_THREAD_GRAPH_EDGE_SIZE);
+
+	dgThreadGraphEdge& edge = m_graphEdges[m_graphEdgesCount];
+	edge.m_job = job;
+	edge.m_next = m_graphJobs[dependsOnJob].m_firstEdge;
+	m_graphJobs[dependsOnJob].m_firstEdge = m_graphEdgesCount;
+	m_graphJobs[job].m_dependencies ++;
+	m_graphEdgesCount ++;
+}
+
+void dgThreadHive::ExecuteGraph ()
+{
+	if (m_graphJobsCount) {
+		m_graphReadyHead = 0;
+		m_graphReadyTail = 0;
+		for (dgInt32 i = 0; i < m_graphJobsCount; i ++) {
+			m_graphReady[i] = -1;
+		}
+		for (dgInt32 i = 0; i < m_graphJobsCount; i ++) {
+			if (!m_graphJobs[i].m_dependencies) {
+				m_graphReady[m_graphReadyTail] = i;
+				m_graphReadyTail ++;
+			}
+		}
+		dgAssert (m_graphReadyTail);
+
+		// every worker runs ready jobs until all the jobs in the graph had been claimed
+		const dgInt32 threadCount = GetThreadCount();
+		for (dgInt32 i = 0; i < threadCount; i ++) {
+			QueueJob (GraphKernel, this, NULL);
+		}
+		SynchronizationBarrier();
+		dgAssert (m_graphReadyTail == m_graphJobsCount);
 	}
+	m_graphJobsCount = 0;
+	m_graphEdgesCount = 0;
 }
 
+void dgThreadHive::GraphKernel (void* const context0, void* const context1, dgInt32 threadID)
+{
+	dgThreadHive* const me = (dgThreadHive*) context0;
+	me->RunGraphJobs (threadID);
+}
 
+void dgThreadHive::RunGraphJobs (dgInt32 threadID)
+{
+	// each job is posted to the ready list exactly once, so a worker that claims a slot 
+	// can spin until the job that will fill that slot has its last dependency resolved
+	const dgInt32 count = m_graphJobsCount;
+	for (dgInt32 slot = dgAtomicExchangeAndAdd(&m_graphReadyHead, 1); slot < count; slot = dgAtomicExchangeAndAdd(&m_graphReadyHead, 1)) {
+		dgInt32 index = dgAtomicExchangeAndAdd(&m_graphReady[slot], 0);
+		while (index < 0) {
+			dgThreadYield();
+			index = dgAtomicExchangeAndAdd(&m_graphReady[slot], 0);
+		}
+
+		dgThreadGraphJob& job = m_graphJobs[index];
+		if (job.m_job.m_callback) {
+			job.m_job.m_callback (job.m_job.m_context0, job.m_job.m_context1, threadID);
+		}
+
+		for (dgInt32 edge = job.m_firstEdge; edge >= 0; edge = m_graphEdges[edge].m_next) {
+			const dgInt32 next = m_graphEdges[edge].m_job;
+			if (dgAtomicExchangeAndAdd(&m_graphJobs[next].m_dependencies, -1) == 1) {
+				const dgInt32 readySlot = dgAtomicExchangeAndAdd(&m_graphReadyTail, 1);
+				dgInterlockedExchange(&m_graphReady[readySlot], next);
+			}
+		}
+	}
+}
@@ -25,12 +25,16 @@
 
 #include "dgThread.h"
 #include "dgMemory.h"
-#include "dgFastQueue.h"
+#include "dgThreadProfiler.h"
 
 
 
 //#define DG_THREAD_POOL_JOB_SIZE (512)
 #define DG_THREAD_POOL_JOB_SIZE (1024 * 8)
+#define DG_THREAD_BEE_JOB_SIZE	(DG_THREAD_POOL_JOB_SIZE / DG_MAX_THREADS_HIVE_COUNT)
+#define DG_THREAD_GRAPH_JOB_SIZE	(1024)
+#define DG_THREAD_GRAPH_EDGE_SIZE	(1024 * 4)
+#define DG_THREAD_DEFAULT_SPIN_COUNT	(1024 * 4)
 
 typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const context1, dgInt32 threadID);
 
@@ -38,6 +42,25 @@ class dgThreadHive
 {
 	public:
 
+	enum dgIdlePolicy
+	{
+		m_idleBlocking = 0,
+		m_idleSpinThenPark,
+		m_idleBusyPoll,
+	};
+
+	// semaphore that can spin on a token before parking the waiting thread in the kernel
+	class dgThreadSignal
+	{
+		public:
+		dgThreadSignal();
+		void Release();
+		void Wait(dgInt32 spinCount, dgUnsigned64& spinTime, dgUnsigned64& parkTime);
+
+		dgInt32 m_token;
+		dgThread::dgSemaphore m_semaphore;
+	};
+
 	class dgThreadJob
 	{
 		public:
@@ -57,6 +80,22 @@ class dgThreadHive
 	};
 
 
+	// a job in the task graph, it is ready to run when all the jobs it depends on are done
+	class dgThreadGraphJob
+	{
+		public:
+		dgThreadJob m_job;
+		dgInt32 m_dependencies;
+		dgInt32 m_firstEdge;
+	};
+
+	class dgThreadGraphEdge
+	{
+		public:
+		dgInt32 m_job;
+		dgInt32 m_next;
+	};
+
 	class dgThreadBee: public dgThread
 	{
 		public:
@@ -72,13 +111,25 @@ class dgThreadHive
 
 		void RunNextJobInQueue(dgInt32 threadId);
 
+		bool PushJob (const dgThreadJob& job);
+		bool PopJob (dgThreadJob& job);
+		void ResetJobs ();
+
 		dgInt32 m_isBusy;
+		dgInt32 m_memorySlot;
+		dgInt32 m_jobsHead;
+		dgInt32 m_jobsTail;
 
 		dgUnsigned32 m_ticks;
-		dgSemaphore m_myMutex;
+		dgUnsigned32 m_steals;
+		dgUnsigned32 m_idles;
+		dgUnsigned64 m_spinTime;
+		dgUnsigned64 m_parkTime;
+		dgThreadSignal m_myMutex;
 		dgThreadHive* m_hive;
 		dgMemoryAllocator* m_allocator; 
 		OnGetPerformanceCountCallback m_getPerformanceCount;	
+		dgThreadJob m_jobsPool[DG_THREAD_BEE_JOB_SIZE];
 	};
 
 	dgThreadHive(dgMemoryAllocator* const allocator);
@@ -104,24 +155,69 @@ class dgThreadHive
 	void QueueJob (dgWorkerThreadTaskCallback callback, void* const context0, void* const context1);
 	void SynchronizationBarrier ();
 
+	// task graph, jobs with a NULL callback can be used as join points
+	dgInt32 AddGraphJob (dgWorkerThreadTaskCallback callback, void* const context0, void* const context1);
+	void AddGraphDependency (dgInt32 job, dgInt32 dependsOnJob);
+	void ExecuteGraph ();
+
 	void SetPerfomanceCounter(OnGetPerformanceCountCallback callback);
 	dgUnsigned32 GetPerfomanceTicks (dgUnsigned32 threadIndex) const;
+	dgUnsigned32 GetStealCount (dgUnsigned32 threadIndex) const;
+	dgUnsigned32 GetIdleCount (dgUnsigned32 threadIndex) const;
+	dgInt32 GetThreadMemoryUsed (dgInt32 threadIndex) const;
+
+	void SetIdlePolicy (dgIdlePolicy policy, dgInt32 spinCount);
+	dgIdlePolicy GetIdlePolicy () const;
+	dgUnsigned32 GetSpinTime (dgUnsigned32 threadIndex) const;
+	dgUnsigned32 GetParkTime (dgUnsigned32 threadIndex) const;
+
+	// cpu pinning of the worker threads, a negative cpu index means the thread is not pinned
+	void SetThreadAffinity (dgInt32 threadIndex, dgInt32 cpuIndex);
+	dgInt32 GetThreadAffinity (dgInt32 threadIndex) const;
+	dgInt32 SetThreadsNumaNode (dgInt32 node);
+	bool HasThreadAffinity () const;
+
+	// per thread event capture, see DG_PROFILER_EVENT
+	dgThreadProfiler& GetProfiler ();
+	void StartProfilerCapture ();
+	void StopProfilerCapture ();
+	dgInt32 SaveProfilerTrace (const char* const fileName) const;
 
 	private:
 	void DestroyThreads();
+	dgInt32 GetSpinCount() const;
+	void RunGraphJobs (dgInt32 threadID);
+	static void GraphKernel (void* const context0, void* const context1, dgInt32 threadID);
 
 	dgInt32 m_beesCount;
 	dgInt32 m_currentIdleBee;
+	dgInt32 m_spinCount;
+	dgIdlePolicy m_idlePolicy;
+	dgUnsigned64 m_masterSpinTime;
+	dgUnsigned64 m_masterParkTime;
 	dgThreadBee* m_workerBees;
 	dgThread* m_myMasterThread;
 	dgMemoryAllocator* m_allocator;
-	dgThread::dgCriticalSection m_jobsCriticalSection;
 	mutable dgThread::dgCriticalSection m_globalCriticalSection;
-	dgThread::dgSemaphore m_myMutex[DG_MAX_THREADS_HIVE_COUNT];
-	dgFastQueue<dgThreadJob, DG_THREAD_POOL_JOB_SIZE> m_jobsPool;
+	dgThreadSignal m_myMutex[DG_MAX_THREADS_HIVE_COUNT];
+	dgInt32 m_beeAffinity[DG_MAX_THREADS_HIVE_COUNT];
+	dgThreadProfiler m_profiler;
+
+	dgInt32 m_graphJobsCount;
+	dgInt32 m_graphEdgesCount;
+	dgInt32 m_graphReadyHead;
+	dgInt32 m_graphReadyTail;
+	dgInt32 m_graphReady[DG_THREAD_GRAPH_JOB_SIZE];
+	dgThreadGraphJob m_graphJobs[DG_THREAD_GRAPH_JOB_SIZE];
+	dgThreadGraphEdge m_graphEdges[DG_THREAD_GRAPH_EDGE_SIZE];
 };
 
 
+inline dgThreadProfiler& dgThreadHive::GetProfiler ()
+{
+	return m_profiler;
+}
+
 inline void dgThreadHive::GlobalLock() const
 {
 	GetIndirectLock(&m_globalCriticalSection);
@@ -19,33 +19,193 @@
 * 3. This notice may not be removed or altered from any source distribution.
 */
 
+
 #ifndef __DG_THREAD_PROFILER_H__
 #define __DG_THREAD_PROFILER_H__
 
-#include "dgList.h"
+#include "dgStdafx.h"
+#include "dgMemory.h"
+
+// define DG_DISABLE_THREAD_PROFILER on the command line to compile the profiler out, the event macro then expands to nothing
+#ifndef DG_DISABLE_THREAD_PROFILER
+	#define DG_USE_THREAD_PROFILER
+#endif
+
+#define DG_PROFILER_RING_SIZE		(1024 * 8)
+#define DG_PROFILER_MASTER_TRACK	DG_MAX_THREADS_HIVE_COUNT
+
+#ifdef DG_USE_THREAD_PROFILER
+	#define DG_PROFILER_EVENT(hive,name,threadIndex) dgThreadProfiler::dgScopeEvent profilerScopeEvent (&(hive)->GetProfiler(), name, threadIndex)
+#else
+	#define DG_PROFILER_EVENT(hive,name,threadIndex)
+#endif
 
-#define DG_PROFILER_EVENT_NAME_SIZE  32
 
+// each hive thread records scoped events in its own ring buffer, so recording does not need locks.
+// when capture is off an event costs one load and one branch. 
+// rings wrap around, only the most recent DG_PROFILER_RING_SIZE events of each thread are kept.
 class dgThreadProfiler
 {
 	public:
 	class dgEvent
 	{
 		public:
-		char m_name[ DG_PROFILER_EVENT_NAME_SIZE];
-		dgUnsigned32 m_startTime;
-		dgUnsigned32 m_duration;
+		const char* m_name;
+		dgUnsigned64 m_startTime;
+		dgUnsigned64 m_endTime;
+	};
+
+	class dgTrack
+	{
+		public:
+		dgEvent* m_events;
+		dgUnsigned32 m_count;
+		dgInt8 m_padding[64 - sizeof (dgEvent*) - sizeof (dgUnsigned32)];
 	};
 
-	dgThreadProfiler ();
-	dgThreadProfiler (const char* const name, dgInt32 id);
-	virtual ~dgThreadProfiler ();
-	
-	dgUnsigned32 m_startTime;
-	dgUnsigned32 m_endTime;
-	dgList<dgEvent> m_events;
+	class dgScopeEvent
+	{
+		public:
+		dgScopeEvent (dgThreadProfiler* const profiler, const char* const name, dgInt32 threadIndex)
+			:m_profiler(profiler->m_capturing ? profiler : NULL)
+		{
+			if (m_profiler) {
+				m_name = name;
+				m_threadIndex = threadIndex;
+				m_startTime = dgGetTimeInMicrosenconds();
+			}
+		}
+
+		~dgScopeEvent ()
+		{
+			if (m_profiler) {
+				m_profiler->AddEvent (m_name, m_threadIndex, m_startTime, dgGetTimeInMicrosenconds());
+			}
+		}
+
+		dgThreadProfiler* m_profiler;
+		const char* m_name;
+		dgUnsigned64 m_startTime;
+		dgInt32 m_threadIndex;
+	};
+
+	dgThreadProfiler (dgMemoryAllocator* const allocator);
+	~dgThreadProfiler ();
+
+	void StartCapture (dgInt32 threadCount);
+	void StopCapture ();
+	bool IsCapturing () const;
+
+	void AddEvent (const char* const name, dgInt32 threadIndex, dgUnsigned64 startTime, dgUnsigned64 endTime);
+	dgInt32 SaveTrace (const char* const fileName) const;
+
+	private:
+	void ReleaseTracks ();
+
+	dgInt32 m_capturing;
+	dgUnsigned64 m_captureTime;
+	dgMemoryAllocator* m_allocator;
+	dgTrack m_tracks[DG_PROFILER_MASTER_TRACK + 1];
 };
 
 
+inline dgThreadProfiler::dgThreadProfiler (dgMemoryAllocator* const allocator)
+	:m_capturing(0)
+	,m_captureTime(0)
+	,m_allocator(allocator)
+{
+	memset (m_tracks, 0, sizeof (m_tracks));
+}
+
+inline dgThreadProfiler::~dgThreadProfiler ()
+{
+	ReleaseTracks ();
+}
+
+inline void dgThreadProfiler::ReleaseTracks ()
+{
+	for (dgInt32 i = 0; i <= DG_PROFILER_MASTER_TRACK; i ++) {
+		if (m_tracks[i].m_events) {
+			m_allocator->FreeLow (m_tracks[i].m_events);
+		}
+		m_tracks[i].m_events = NULL;
+		m_tracks[i].m_count = 0;
+	}
+}
 
+inline void dgThreadProfiler::StartCapture (dgInt32 threadCount)
+{
+#ifdef DG_USE_THREAD_PROFILER
+	m_capturing = 0;
+	ReleaseTracks ();
+	for (dgInt32 i = 0; i < dgMin (threadCount, DG_MAX_THREADS_HIVE_COUNT); i ++) {
+		m_tracks[i].m_events = (dgEvent*) m_allocator->MallocLow (DG_PROFILER_RING_SIZE * sizeof (dgEvent));
+	}
+	m_tracks[DG_PROFILER_MASTER_TRACK].m_events = (dgEvent*) m_allocator->MallocLow (DG_PROFILER_RING_SIZE * sizeof (dgEvent));
+	m_captureTime = dgGetTimeInMicrosenconds();
+	m_capturing = 1;
 #endif
+}
+
+inline void dgThreadProfiler::StopCapture ()
+{
+	m_capturing = 0;
+}
+
+inline bool dgThreadProfiler::IsCapturing () const
+{
+	return m_capturing ? true : false;
+}
+
+inline void dgThreadProfiler::AddEvent (const char* const name, dgInt32 threadIndex, dgUnsigned64 startTime, dgUnsigned64 endTime)
+{
+	dgAssert (threadIndex >= 0);
+	dgAssert (threadIndex <= DG_PROFILER_MASTER_TRACK);
+	dgTrack& track = m_tracks[threadIndex];
+	if (track.m_events) {
+		dgEvent& event = track.m_events[track.m_count & (DG_PROFILER_RING_SIZE - 1)];
+		event.m_name = name;
+		event.m_startTime = startTime;
+		event.m_endTime = endTime;
+		track.m_count ++;
+	}
+}
+
+// write the captured events in chrome trace event format, it loads in chrome://tracing and in perfetto  
+inline dgInt32 dgThreadProfiler::SaveTrace (const char* const fileName) const
+{
+	dgAssert (!m_capturing);
+	FILE* const file = fopen (fileName, "wb");
+	if (!file) {
+		return 0;
+	}
+
+	dgInt32 eventsCount = 0;
+	const char* separator = "";
+	fprintf (file, "{\"traceEvents\":[\n");
+	for (dgInt32 i = 0; i <= DG_PROFILER_MASTER_TRACK; i ++) {
+		const dgTrack& track = m_tracks[i];
+		if (track.m_events) {
+			if (i == DG_PROFILER_MASTER_TRACK) {
+				fprintf (file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"master\"}}", separator, i);
+			} else {
+				fprintf (file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}", separator, i, i);
+			}
+			separator = ",\n";
+
+			dgUnsigned32 first = (track.m_count > DG_PROFILER_RING_SIZE) ? track.m_count - DG_PROFILER_RING_SIZE : 0;
+			for (dgUnsigned32 j = first; j < track.m_count; j ++) {
+				const dgEvent& event = track.m_events[j & (DG_PROFILER_RING_SIZE - 1)];
+				dgUnsigned64 start = (event.m_startTime > m_captureTime) ? event.m_startTime - m_captureTime : 0;
+				fprintf (file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}", event.m_name, i, (unsigned long long) start, (unsigned long long) (event.m_endTime - event.m_startTime));
+				eventsCount ++;
+			}
+		}
+	}
+	fprintf (file, "\n]}\n");
+	fclose (file);
+	return eventsCount;
+}
+
+#endif
+
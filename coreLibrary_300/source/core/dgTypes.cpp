@@ -74,6 +74,37 @@ dgUnsigned64 dgGetTimeInMicrosenconds()
 #endif
 }
 
+// monotonic clock for the performance counters, it does not wrap in the life time of a program
+dgUnsigned64 dgGetTimeInNanoseconds()
+{
+#ifdef _MSC_VER
+	static LARGE_INTEGER frequency;
+	static LARGE_INTEGER baseCount;
+	if (!frequency.QuadPart) {
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter (&baseCount);
+	}
+
+	LARGE_INTEGER count;
+	QueryPerformanceCounter (&count);
+	count.QuadPart -= baseCount.QuadPart;
+	// split the conversion so that the multiplication does not overflow
+	dgUnsigned64 seconds = dgUnsigned64 (count.QuadPart / frequency.QuadPart);
+	dgUnsigned64 fraction = dgUnsigned64 (count.QuadPart % frequency.QuadPart);
+	return seconds * 1000000000 + fraction * 1000000000 / dgUnsigned64 (frequency.QuadPart);
+#endif
+
+#if (defined (_POSIX_VER) || defined (_POSIX_VER_64))
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return dgUnsigned64 (ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+
+#ifdef _MACOSX_VER
+	return dgGetTimeInMicrosenconds() * 1000;
+#endif
+}
+
 
 
 void GetMinMax (dgVector &minOut, dgVector &maxOut, const dgFloat32* const vertexArray, dgInt32 vCount, dgInt32 strideInBytes)
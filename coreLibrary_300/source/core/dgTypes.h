@@ -179,6 +179,12 @@
 	//#define DG_INLINE	 __attribute__((always_inline))
 #endif
 
+#if (defined (_WIN_32_VER) || defined (_WIN_64_VER))
+	#define DG_THREAD_LOCAL	__declspec(thread)
+#else 
+	#define DG_THREAD_LOCAL	__thread
+#endif
+
 
 #define DG_VECTOR_SIMD_SIZE		16
 
@@ -709,6 +715,7 @@ typedef dgUnsigned32 (dgApi *OnGetPerformanceCountCallback) ();
 
 
 dgUnsigned64 dgGetTimeInMicrosenconds();
+dgUnsigned64 dgGetTimeInNanoseconds();
 
 
 class dgFloatExceptions
@@ -820,6 +827,13 @@ DG_INLINE void dgThreadYield()
 #endif
 }
 
+DG_INLINE void dgSpinPause()
+{
+	#if !(defined (__ppc__) || defined (ANDROID) || defined (IOS))
+		_mm_pause();
+	#endif
+}
+
 DG_INLINE void dgPrefetchMem(const void* const mem)
 {
 	#if !(defined (__ppc__) || defined (ANDROID) || defined (IOS))
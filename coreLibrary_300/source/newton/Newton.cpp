@@ -121,6 +121,69 @@ int NewtonGetMemoryUsed()
 	return dgGetMemoryUsed();
 }
 
+// Name: NewtonGetThreadMemoryUsed 
+// Return the memory allocated by one of the worker threads.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* threadIndex - index of the worker thread
+// 
+// Return: bytes allocated minus bytes released by the thread, the value can be negative when the thread releases memory allocated by another thread.
+//
+// Remarks: worker threads allocate from a private cache that is refilled from, and returned to, the shared memory bins in batches, 
+// so contacts and other objects created during the update do not contend for a lock. 
+//
+// See also: NewtonGetMemoryUsed, NewtonSetThreadsCount
+int NewtonGetThreadMemoryUsed (const NewtonWorld* const newtonWorld, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetThreadMemoryUsed (threadIndex);
+}
+
+// Name: NewtonReserveFrameArena 
+// Preallocate the scratch memory used by a world update.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* sizeInBytes - bytes to reserve for each worker thread, and for the serial part of the update
+// 
+// Return: Nothing.
+//
+// Remarks: buffers that only live for one update are carved from a per step arena that is rewound at the beginning of each update.
+// The arena grows by itself to the largest size used by a previous update, so this function is only needed to avoid the heap allocations of the first few updates.
+// It must not be called from inside an update.
+//
+// See also: NewtonGetFrameArenaPeak, NewtonUpdate
+void NewtonReserveFrameArena (const NewtonWorld* const newtonWorld, int sizeInBytes)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+
+	Newton* const world = (Newton *)newtonWorld;
+	world->ReserveFrameArena (sizeInBytes);
+}
+
+// Name: NewtonGetFrameArenaPeak 
+// Return the largest amount of per step scratch memory used by an update.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* threadIndex - index of the worker thread, a value equal to the thread count selects the serial part of the update, a negative value returns the sum of all of them
+// 
+// Return: peak bytes used since the world was created.
+//
+// Remarks: a good value to pass to NewtonReserveFrameArena on the next run of the same scene. 
+//
+// See also: NewtonReserveFrameArena, NewtonGetThreadMemoryUsed
+int NewtonGetFrameArenaPeak (const NewtonWorld* const newtonWorld, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetFrameArenaPeak (threadIndex);
+}
+
 void NewtonSetMemorySystem (NewtonAllocMemory mallocFnt, NewtonFreeMemory mfreeFnt)
 {
 	dgMemFree _free;
@@ -222,6 +285,80 @@ void NewtonSelectBroadphaseAlgorithm (const NewtonWorld* const newtonWorld, int
 	world->GetBroadPhase()->SelectBroadPhaseType(algorithmType);
 }
 
+// Name: NewtonGetBroadphaseMaintenanceBudget
+// Return the time each update can spend rebuilding the broadphase tree.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+//
+// Return: the budget in microseconds, zero if the tree is maintained with the default rotations and full rebuilds.
+//
+// See also: NewtonSetBroadphaseMaintenanceBudget
+int NewtonGetBroadphaseMaintenanceBudget (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetBroadPhase()->GetMaintenanceBudget();
+}
+
+// Name: NewtonSetBroadphaseMaintenanceBudget
+// Select incremental maintenance of the broadphase tree.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* microseconds - time each update can spend rebuilding subtrees, zero restores the default maintenance
+//
+// Remarks: by default the tree is improved with rotations on one thread and fully rebuilt when its quality degrades, 
+// which shows up as a long update after thousands of bodies are added or removed. With a budget the node bounds are refit 
+// on all threads and the subtrees that lost the most quality are rebuilt in parallel, worst first, until the budget runs out. 
+// The rest wait for the next update, so the cost of a large change is spread over several updates.
+//
+// See also: NewtonGetBroadphaseMaintenanceBudget, NewtonSelectBroadphaseAlgorithm
+void NewtonSetBroadphaseMaintenanceBudget (const NewtonWorld* const newtonWorld, int microseconds)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->GetBroadPhase()->SetMaintenanceBudget(microseconds);
+}
+
+// Name: NewtonGetBroadphaseSnapshotState
+// Tell if the world publishes a read only copy of the broadphase after each update.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+//
+// Return: 1 when the snapshot is enabled, 0 otherwise.
+//
+// See also: NewtonSetBroadphaseSnapshotState
+int NewtonGetBroadphaseSnapshotState (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetBroadPhase()->IsSnapshotEnabled() ? 1 : 0;
+}
+
+// Name: NewtonSetBroadphaseSnapshotState
+// Enable or disable the read only copy of the broadphase used by the snapshot queries.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* state - 1 to publish a snapshot at the end of every update, 0 to release it
+//
+// Remarks: the snapshot is a copy of the broadphase trees with the box and the collision transform of every body, 
+// it is written at the end of each update into one of two buffers. NewtonWorldSnapshotRayCast and NewtonWorldSnapshotForEachBodyInAABBDo
+// read the last published buffer, so they can be called from any thread while NewtonUpdateAsync is running the next update.
+// Publishing costs a copy of the tree on the update thread, and it waits for queries that are still reading the older buffer.
+//
+// Remarks: this function must not be called while an update is running. When enabled the first snapshot is published immediately.
+//
+// See also: NewtonGetBroadphaseSnapshotState, NewtonWorldSnapshotRayCast, NewtonWorldSnapshotForEachBodyInAABBDo
+void NewtonSetBroadphaseSnapshotState (const NewtonWorld* const newtonWorld, int state)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->GetBroadPhase()->EnableSnapshot(state ? true : false);
+}
+
 dFloat NewtonGetContactMergeTolerance (const NewtonWorld* const newtonWorld)
 {
 	TRACE_FUNCTION(__FUNCTION__);
@@ -280,6 +417,83 @@ void NewtonDeserializeBodyArray (const NewtonWorld* const newtonWorld, NewtonOnB
 	world->DeserializeBodyArray (dgWorld::OnBodyDeserialize (deserializeBody), (dgDeserialize) serializeFunction, serializeHandle);
 }
 
+// Name: NewtonRecorderStart
+// Start recording the world to a binary log that can be replayed with NewtonReplay.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *const char* fileName - name of the log file
+//
+// Return: 1 if the file could be created, 0 otherwise.
+//
+// Remarks: the bodies already in the world are written at the next update. After that, the log gets the bodies created 
+// and destroyed between updates, the external force and torque of the bodies that changed in each update and a crc of the state of all bodies after each update. 
+// Only the changes are written, so bodies under a constant force like gravity cost nothing after the first update.
+//
+// Remarks: joints, materials and changes made to the bodies outside the force and torque callback are not recorded, 
+// neither are the bodies created or destroyed inside an update. For exact replays start recording right after 
+// creating the world, bodies that were already simulated lose their contact cache.
+//
+// See also: NewtonRecorderStop, NewtonReplay
+int NewtonRecorderStart (const NewtonWorld* const newtonWorld, const char* const fileName)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->StartRecording (fileName) ? 1 : 0;
+}
+
+// Name: NewtonRecorderStop
+// Close the log started with NewtonRecorderStart. Destroying the world also closes it.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+//
+// See also: NewtonRecorderStart, NewtonReplay
+void NewtonRecorderStop (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->StopRecording ();
+}
+
+// Name: NewtonReplay
+// Run a log written by NewtonRecorderStart and compare the state of the bodies after each update with the recorded one.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to an empty Newton world
+// *const char* fileName - name of the log file
+// *NewtonReplayFrameCallback* callback - called after each update with the frame index, the update time in milliseconds and both crcs, can be NULL
+// *void* *userData - passed to the callback
+//
+// Return: the index of the first frame which state does not match the recording, -1 if all frames match, and -2 if the file can't be read.
+//
+// Remarks: the replay uses the thread count of the world, so replaying the same log with different thread counts 
+// tells if the update is deterministic. Replayed bodies get an internal force and torque callback, their user data is not set.
+//
+// See also: NewtonRecorderStart, NewtonWorldGetStateCRC
+int NewtonReplay (const NewtonWorld* const newtonWorld, const char* const fileName, NewtonReplayFrameCallback callback, void* const userData)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->Replay (fileName, (dgWorldRecorder::OnReplayStep) callback, userData);
+}
+
+// Name: NewtonWorldGetStateCRC
+// Calculate a crc of the matrix, velocity and angular velocity of all bodies in the world.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+//
+// Return: the crc of the state of the world.
+//
+// See also: NewtonReplay
+unsigned NewtonWorldGetStateCRC (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->CalculateStateCRC ();
+}
+
 
 
 int NewtonGetCurrentDevice (const NewtonWorld* const newtonWorld)
@@ -468,6 +682,95 @@ int NewtonGetMaxThreadsCount(const NewtonWorld* const newtonWorld)
 	return world->GetMaxThreadCount();
 }
 
+// Name: NewtonSetThreadIdlePolicy 
+// Set how the worker threads wait for work, and how the calling thread waits for the worker threads to finish.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* policy - NEWTON_THREAD_IDLE_BLOCKING, NEWTON_THREAD_IDLE_SPIN_THEN_PARK or NEWTON_THREAD_IDLE_BUSY_POLL
+// *int* spinCount - number of spin iterations before parking a thread, zero selects the default. Only used by NEWTON_THREAD_IDLE_SPIN_THEN_PARK
+// 
+// Return: Nothing
+//
+// Remarks: NEWTON_THREAD_IDLE_BLOCKING (the default) parks the threads on a semaphore each time they run out of work.
+// NEWTON_THREAD_IDLE_SPIN_THEN_PARK spins for a while before parking, this saves the kernel wake up cost when updates are small and frequent.
+// NEWTON_THREAD_IDLE_BUSY_POLL never parks the threads, use it only when each thread has a dedicated core.
+//
+// See also: NewtonReadThreadSpinTime, NewtonReadThreadParkedTime, NewtonSetThreadsCount
+void NewtonSetThreadIdlePolicy (const NewtonWorld* const newtonWorld, int policy, int spinCount)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetIdlePolicy (dgThreadHive::dgIdlePolicy (dgClamp (policy, NEWTON_THREAD_IDLE_BLOCKING, NEWTON_THREAD_IDLE_BUSY_POLL)), spinCount);
+}
+
+int NewtonGetThreadIdlePolicy (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetIdlePolicy ();
+}
+
+// Name: NewtonSetThreadAffinity 
+// Pin a worker thread to one logical cpu.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* threadIndex - index of the worker thread
+// *int* cpuIndex - logical cpu index, a negative value removes the pin.
+// 
+// Return: Nothing
+//
+// Remarks: the affinity is kept when the thread count changes. After the call a pinned worker reallocates the Jacobian 
+// and right side buffers, so that on NUMA systems that memory is placed on the node of the pinned thread.
+// Affinity is only supported on linux, on other platforms the function only records the value.
+//
+// See also: NewtonSetThreadsNumaNode, NewtonGetThreadAffinity, NewtonSetThreadsCount
+void NewtonSetThreadAffinity (const NewtonWorld* const newtonWorld, int threadIndex, int cpuIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetThreadAffinity (threadIndex, cpuIndex);
+	world->BindThreadMemory ();
+}
+
+int NewtonGetThreadAffinity (const NewtonWorld* const newtonWorld, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetThreadAffinity (threadIndex);
+}
+
+// Name: NewtonSetThreadsNumaNode 
+// Pin all worker threads to the cpus of one NUMA node.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* node - index of the NUMA node
+// 
+// Return: number of cpus found in the node, zero if the node does not exist, in which case the affinity is not changed.
+//
+// Remarks: the cpus of the node are dealt to the worker threads in order, wrapping around if there are more threads than cpus. 
+// Keeping all workers on one node prevents the OS from migrating them across sockets in the middle of an update, and 
+// places the Jacobian buffers in the node local memory. 
+//
+// See also: NewtonSetThreadAffinity, NewtonSetThreadsCount
+int NewtonSetThreadsNumaNode (const NewtonWorld* const newtonWorld, int node)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+
+	Newton* const world = (Newton *)newtonWorld;
+	int count = world->SetThreadsNumaNode (node);
+	if (count) {
+		world->BindThreadMemory ();
+	}
+	return count;
+}
+
 
 
 /*
@@ -546,6 +849,113 @@ int NewtonGetMultiThreadSolverOnSingleIsland(const NewtonWorld* const newtonWorl
 	return world->GetThreadOnSingleIsland();
 }
 
+// Name: NewtonSetMultiThreadSolverSimdBlocks 
+// Select the row layout used by the multi threaded island solver. Mode is disabled by default.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* mode - 1 solve the rows of four joints of the same color batch with one vector instruction, 0 solve one row at a time
+// 
+// Return: Nothing
+//
+// Remarks: the joints of each color batch are packed in blocks of four, sorted by row count, and the Jacobian rows of a block are 
+// stored as structure of arrays, with the inverse mass times Jacobian terms calculated once per update instead of on each iteration.
+//
+// Remarks: this option only has effect on islands solved with the multi threaded solver, see NewtonSetMultiThreadSolverOnSingleIsland. 
+// The result is not bit identical to the one row at a time solver because the row dot products are summed in a different order.
+//
+// See also: NewtonGetMultiThreadSolverSimdBlocks, NewtonSetMultiThreadSolverOnSingleIsland 
+void NewtonSetMultiThreadSolverSimdBlocks(const NewtonWorld* const newtonWorld, int mode)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetParallelSolverSimdBlocks (mode);
+}
+
+int NewtonGetMultiThreadSolverSimdBlocks(const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetParallelSolverSimdBlocks();
+}
+
+// Name: NewtonSetSolverAdaptiveIterations 
+// Let each island stop iterating as soon as its joints meet an acceleration residual. Disabled by default.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *dFloat* residual - largest joint acceleration error an island can leave unsolved, zero disables the adaptive iterations
+// *int* minIterations - passes each island runs in an update before it is allowed to stop
+// *int* maxIterations - passes an island can run in an update, spread over the solver substeps
+// 
+// Return: Nothing
+//
+// Remarks: by default each substep of the solver runs up to four passes over the joints of an island, and stops early only 
+// when the island is already below a fixed internal error. With a residual the passes of each substep stop at the given residual, 
+// and once the forces carried from the previous substep need no correction the island skips the passes of the remaining substeps. 
+// Islands at rest pay for a single pass, while islands that need more can take up to maxIterations.
+//
+// Remarks: this option has no effect on the exact solver model, or on islands with joints that request the exact solver, see NewtonSetSolverModel. 
+// The passes of each island are reported by NewtonReadWorldCounters.
+//
+// See also: NewtonGetSolverAdaptiveIterations, NewtonSetSolverModel, NewtonReadWorldCounters
+void NewtonSetSolverAdaptiveIterations (const NewtonWorld* const newtonWorld, dFloat residual, int minIterations, int maxIterations)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetSolverAdaptiveIterations (residual, minIterations, maxIterations);
+}
+
+// Name: NewtonGetSolverAdaptiveIterations 
+// Get the residual and the pass limits of the adaptive solver iterations.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *dFloat* residual - receives the residual, zero when the adaptive iterations are disabled
+// *int* minIterations - receives the passes each island runs before it is allowed to stop
+// *int* maxIterations - receives the passes an island can run in an update
+//
+// See also: NewtonSetSolverAdaptiveIterations
+void NewtonGetSolverAdaptiveIterations (const NewtonWorld* const newtonWorld, dFloat* const residual, int* const minIterations, int* const maxIterations)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	dgFloat32 tolerance;
+	dgInt32 minCount;
+	dgInt32 maxCount;
+	world->GetSolverAdaptiveIterations (tolerance, minCount, maxCount);
+	*residual = tolerance;
+	*minIterations = minCount;
+	*maxIterations = maxCount;
+}
+
+
+// Name: NewtonSetTaskGraphStepMode 
+// Enable or disable the task graph update of the collision pipeline. Mode is disabled by default.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *int* mode - 1 enable the task graph update, 0 use a synchronization barrier between each update phase
+// 
+// Return: Nothing
+//
+// Remarks: In task graph mode each worker thread collects colliding pairs into its own buffer, and the contact calculation 
+// of a buffer starts as soon as the thread that fills it is done, instead of waiting for all threads to finish the pair search.
+//
+// See also: NewtonGetTaskGraphStepMode, NewtonSetThreadsCount 
+void NewtonSetTaskGraphStepMode(const NewtonWorld* const newtonWorld, int mode)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetTaskGraphStepMode (mode);
+}
+
+int NewtonGetTaskGraphStepMode(const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetTaskGraphStepMode();
+}
 
 // Name: NewtonSetSolverModel 
 // Set the solver precision mode.
@@ -678,6 +1088,178 @@ unsigned NewtonReadThreadPerformanceTicks (const NewtonWorld* newtonWorld, unsig
 	return world->GetThreadPerfomanceTicks (threadIndex);
 }
 
+// Name: NewtonReadWorldCounters
+// Get all the performance counters of the last update in one call.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *NewtonWorldCounters* counters - pointer to the structure that receives the counters
+//
+// Remarks: times are 64 bit nanoseconds from a monotonic clock, so they do not depend on *NewtonSetPerformanceClock* and do not wrap. 
+// Each worker thread has its own row with the time it spent in the phases it took part of, force callbacks, broad phase, narrow phase, 
+// and solving the islands. The last row is the thread that called the update, it holds the time of the whole update, the collision and 
+// dynamics updates, building the islands, the soft bodies and the listeners. 
+//
+// Remarks: the solver passes, the early exits and the histogram of passes per island only count the islands solved with a non exact solver model.
+//
+// Remarks: the counters are copied at the end of each update, they do not change until the next update finishes.
+//
+// See also: NewtonReadPerformanceTicks, NewtonReadThreadPerformanceTicks, NewtonUpdate
+void NewtonReadWorldCounters (const NewtonWorld* const newtonWorld, NewtonWorldCounters* const counters)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	dgAssert (NEWTON_MAX_THREADS_COUNT == DG_WORLD_COUNTERS_MASTER_ROW);
+	dgAssert (NEWTON_PROFILER_COUNTERS_COUNT == m_counterSize);
+	dgAssert (NEWTON_SOLVER_ITERATIONS_HISTOGRAM_SIZE == DG_SOLVER_ITERATIONS_HISTOGRAM_SIZE);
+
+	const dgWorldCounters& worldCounters = world->GetCounters();
+	memset (counters, 0, sizeof (NewtonWorldCounters));
+	for (dgInt32 i = 0; i <= DG_WORLD_COUNTERS_MASTER_ROW; i ++) {
+		for (dgInt32 j = 0; j < m_counterSize; j ++) {
+			counters->m_ticks[i][j] = (dLong) worldCounters.m_ticks[i][j];
+		}
+		const dgInt32* const counts = worldCounters.m_counts[i];
+		counters->m_pairsTested += counts[m_pairsTestedCount];
+		counters->m_contactPoints += counts[m_contactPointsCount];
+		counters->m_islands += counts[m_islandsCount];
+		counters->m_solverRows += counts[m_solverRowsCount];
+		counters->m_solverIterations += counts[m_solverIterationsCount];
+		counters->m_sleepingBodies += counts[m_sleepingBodiesCount];
+		counters->m_solverEarlyExitIslands += counts[m_solverEarlyExitIslandsCount];
+		for (dgInt32 j = 0; j < DG_SOLVER_ITERATIONS_HISTOGRAM_SIZE; j ++) {
+			counters->m_solverIslandIterations[j] += counts[m_solverIslandIterationsCount + j];
+		}
+	}
+	counters->m_threadCount = world->GetThreadCount();
+}
+
+// Name: NewtonReadThreadStealCount
+// Get the number of jobs a worker thread took from the queue of other worker threads during the last update.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *unsigned* threadIndex - index of the worker thread.
+//
+// Return: number of stolen jobs, zero when the engine is running in single thread mode.
+//
+// See also: NewtonReadThreadIdleCount, NewtonReadThreadPerformanceTicks
+unsigned NewtonReadThreadStealCount (const NewtonWorld* const newtonWorld, unsigned threadIndex)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	return world->GetStealCount (threadIndex);
+}
+
+// Name: NewtonReadThreadIdleCount
+// Get the number of times a worker thread looked for work in the queue of another worker thread and found it empty during the last update.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *unsigned* threadIndex - index of the worker thread.
+//
+// Return: number of failed steal attempts, zero when the engine is running in single thread mode.
+//
+// See also: NewtonReadThreadStealCount, NewtonReadThreadPerformanceTicks
+unsigned NewtonReadThreadIdleCount (const NewtonWorld* const newtonWorld, unsigned threadIndex)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	return world->GetIdleCount (threadIndex);
+}
+
+// Name: NewtonReadThreadSpinTime
+// Get the time in microseconds a thread spent spinning while waiting during the last update.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *unsigned* threadIndex - index of the worker thread, a value equal to the thread count reads the thread that called the update.
+//
+// See also: NewtonReadThreadParkedTime, NewtonSetThreadIdlePolicy
+unsigned NewtonReadThreadSpinTime (const NewtonWorld* const newtonWorld, unsigned threadIndex)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	return world->GetSpinTime (threadIndex);
+}
+
+// Name: NewtonReadThreadParkedTime
+// Get the time in microseconds a thread spent parked on a semaphore during the last update.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *unsigned* threadIndex - index of the worker thread, a value equal to the thread count reads the thread that called the update.
+//
+// See also: NewtonReadThreadSpinTime, NewtonSetThreadIdlePolicy
+unsigned NewtonReadThreadParkedTime (const NewtonWorld* const newtonWorld, unsigned threadIndex)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	return world->GetParkTime (threadIndex);
+}
+
+// Name: NewtonProfilerStartCapture
+// Start recording the engine events of each thread.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+//
+// Remarks: each worker thread records the start and end time of the jobs it runs in its own ring buffer, 
+// the thread that calls the update records the serial parts of the update and the listeners. 
+// Only the most recent events of each thread are kept. Events recorded by a previous capture are discarded.
+//
+// Remarks: this function must be called outside of a Newton Update. When the engine is built without the profiler it does nothing.
+//
+// See also: NewtonProfilerStopCapture, NewtonProfilerSaveTrace
+void NewtonProfilerStartCapture (const NewtonWorld* const newtonWorld)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	world->StartProfilerCapture ();
+}
+
+// Name: NewtonProfilerStopCapture
+// Stop recording engine events, the recorded events are kept until the next capture.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+//
+// See also: NewtonProfilerStartCapture, NewtonProfilerSaveTrace
+void NewtonProfilerStopCapture (const NewtonWorld* const newtonWorld)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	world->StopProfilerCapture ();
+}
+
+// Name: NewtonProfilerSaveTrace
+// Save the events of the last capture to a file in chrome trace event format.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world
+// *const char* fileName - name of the json file to write
+//
+// Return: the number of events written.
+//
+// Remarks: the file can be loaded in chrome://tracing or in the perfetto trace viewer, time stamps are in microseconds from the start of the capture. 
+// The capture must be stopped before saving.
+//
+// See also: NewtonProfilerStartCapture, NewtonProfilerStopCapture
+int NewtonProfilerSaveTrace (const NewtonWorld* const newtonWorld, const char* const fileName)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	return world->SaveProfilerTrace (fileName);
+}
+
 
 // Name: NewtonUpdate 
 // Advance the simulation by an amount of time.
@@ -988,6 +1570,63 @@ void NewtonWorldForEachBodyInAABBDo(const NewtonWorld* const newtonWorld, const
 	world->GetBroadPhase()->ForEachBodyInAABB (q0, q1, (OnBodiesInAABB) callback, userData);
 }
 
+// Name: NewtonWorldSnapshotForEachBodyInAABBDo 
+// Iterate thought every body in the last published broadphase snapshot that intersect the AABB calling the function callback.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world.
+// *const dFloat* *p0 - pointer to an array of at least three floats to hold minimum value for the AABB.
+// *const dFloat* *p1 - pointer to an array of at least three floats to hold maximum value for the AABB.
+// *NewtonBodyIterator* callback - application define callback 
+// *void* callback - application define userdata 
+//
+// Return: nothing
+// 
+// Remarks: same as NewtonWorldForEachBodyInAABBDo but the boxes are the ones of the end of the last update, and the function 
+// can be called from any thread while NewtonUpdateAsync is running. It does nothing if the snapshot is not enabled.
+//
+// Remarks: the callback can read the body handle but it should not read or change the body state, the update could be writing it.
+// Bodies destroyed after the snapshot was published are not reported. Destroying a body waits for the snapshot queries that are running,
+// so the callback must not destroy bodies.
+//
+// See also: NewtonSetBroadphaseSnapshotState, NewtonWorldSnapshotRayCast, NewtonWorldForEachBodyInAABBDo
+void NewtonWorldSnapshotForEachBodyInAABBDo (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonBodyIterator callback, void* const userData)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+
+	Newton* const world = (Newton *) newtonWorld;
+	dgVector q0 (p0[0], p0[1], p0[2], dgFloat32 (0.0f));
+	dgVector q1 (p1[0], p1[1], p1[2], dgFloat32 (0.0f));
+
+	world->GetBroadPhase()->SnapshotForEachBodyInAABB (q0, q1, (OnBodiesInAABB) callback, userData);
+}
+
+// Name: NewtonWorldBodiesInAABBBatch 
+// Find the bodies overlapping each box of an array of boxes.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the world.
+// *const dFloat* *p0Array - pointer to the first float of the minimum corner of the first box in global space.
+// *const dFloat* *p1Array - pointer to the first float of the maximum corner of the first box in global space.
+// *int* strideInBytes - distance in bytes from one box corner to the next in both arrays.
+// *int* boxesCount - number of boxes.
+// *NewtonBody** *bodyArray - array of boxesCount * maxBodiesPerBox bodies, the bodies found in box i are written starting at bodyArray[i * maxBodiesPerBox].
+// *int* maxBodiesPerBox - maximum number of bodies reported for each box.
+// *int* bodiesCountArray - receives the number of bodies written for each box.
+//
+// Return: nothing
+//
+// Remarks: each box reports the same bodies as NewtonWorldForEachBodyInAABBDo would, the search of a box stops once its slice of 
+// the array is full. When called outside the simulation step the boxes are split among all the world threads.
+//
+// See also: NewtonWorldForEachBodyInAABBDo
+void NewtonWorldBodiesInAABBBatch (const NewtonWorld* const newtonWorld, const dFloat* const p0Array, const dFloat* const p1Array, int strideInBytes, int boxesCount, NewtonBody** const bodyArray, int maxBodiesPerBox, int* const bodiesCountArray)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->GetBroadPhase()->BodiesInAABBBatch (p0Array, p1Array, strideInBytes, boxesCount, (dgBody**) bodyArray, maxBodiesPerBox, bodiesCountArray);
+}
+
 
 // Name: NewtonWorldGetVersion 
 // Return the current library version number.
@@ -1221,7 +1860,7 @@ int NewtonWorldGetConstraintCount(const NewtonWorld* const newtonWorld)
 // collision for 1000 pairs in much, much less that the 1000 times the cost of one pair. Therefore this function must be used with care, 
 // as excessive use of it can degrade performance.
 //
-// See also: NewtonWorldConvexCast  
+// See also: NewtonWorldConvexCast, NewtonWorldRayCastBatch, NewtonWorldRayCastCached
 void NewtonWorldRayCast(const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonWorldRayFilterCallback filter, void* const userData, NewtonWorldRayPrefilterCallback prefilter, int threadIndex)
 {
 	TRACE_FUNCTION(__FUNCTION__);
@@ -1233,6 +1872,153 @@ void NewtonWorldRayCast(const NewtonWorld* const newtonWorld, const dFloat* cons
 	}
 }
 
+// Name: NewtonWorldSnapshotRayCast 
+// Shoot a ray from p0 to p1 against the last published broadphase snapshot and call the application callback with each ray intersection.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the world.
+// *const dFloat* *p0 - pointer to an array of at least three floats containing the beginning of the ray in global space.
+// *const dFloat* *p1 - pointer to an array of at least three floats containing the end of the ray in global space.
+// *NewtonWorldRayFilterCallback* filter - user define function to be called for each body hit during the ray scan.
+// *void* *userData - user data to be passed to the filter functions.
+// *NewtonWorldRayPrefilterCallback* prefilter - user define function to be called for each body before intersection.
+//
+// Return: nothing
+// 
+// Remarks: the callbacks work as in NewtonWorldRayCast, but the bodies are tested at their position at the end of the last update. 
+// The function can be called from any thread while NewtonUpdateAsync is running, and it does nothing if the snapshot is not enabled.
+//
+// Remarks: the callbacks can read the body handle and the collision shape but they should not read or change the body state, 
+// the update could be writing it. Bodies destroyed after the snapshot was published are not reported. Destroying a body waits 
+// for the snapshot queries that are running, so the callback must not destroy bodies.
+//
+// See also: NewtonSetBroadphaseSnapshotState, NewtonWorldSnapshotForEachBodyInAABBDo, NewtonWorldRayCast
+void NewtonWorldSnapshotRayCast (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonWorldRayFilterCallback filter, void* const userData, NewtonWorldRayPrefilterCallback prefilter)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	if (filter) {
+		dgVector pp0 (p0[0], p0[1], p0[2], dgFloat32 (0.0f));
+		dgVector pp1 (p1[0], p1[1], p1[2], dgFloat32 (0.0f));
+		Newton* const world = (Newton *) newtonWorld;
+		world->GetBroadPhase()->SnapshotRayCast (pp0, pp1, (OnRayCastAction) filter, (OnRayPrecastAction) prefilter, userData);
+	}
+}
+
+// Name: NewtonWorldRayCastBatch 
+// Cast many line segments against the world in one call.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the world.
+// *const dFloat* *p0Array - pointer to the first float of the beginning of the first ray in global space.
+// *const dFloat* *p1Array - pointer to the first float of the end of the first ray in global space.
+// *int* strideInBytes - distance in bytes from one ray point to the next in both arrays.
+// *int* raysCount - number of rays to cast.
+// *int* mode - NEWTON_RAY_CAST_CLOSEST_HIT reports the nearest body along each ray, NEWTON_RAY_CAST_ANY_HIT stops each ray at the first body it finds.
+// *NewtonWorldRayHitInfo* *hitArray - receives one hit for each ray, m_hitBody is NULL when the ray did not hit anything.
+//
+// Return: nothing
+// 
+// Remarks: the rays are tested four at the time against the broadphase boxes, rays that are next to each other in the arrays 
+// and go in similar directions share most of the traversal, so the application should keep coherent rays together.
+// There are no user callbacks, every body in the world can be hit.
+//
+// Remarks: when called outside the simulation step the rays are split among all the world threads. 
+// Called from inside the step, for example from a listener or a force callback, all the rays are cast by the calling thread.
+//
+// See also: NewtonWorldRayCast
+void NewtonWorldRayCastBatch (const NewtonWorld* const newtonWorld, const dFloat* const p0Array, const dFloat* const p1Array, int strideInBytes, int raysCount, int mode, NewtonWorldRayHitInfo* const hitArray)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->GetBroadPhase()->RayCastBatch (p0Array, p1Array, strideInBytes, raysCount, (mode == NEWTON_RAY_CAST_ANY_HIT), (dgRayHitInfo*) hitArray);
+}
+
+// Name: NewtonWorldRayCastCached 
+// Find the closest body hit by a ray that is cast again and again with small changes, like a sensor on a moving vehicle.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the world.
+// *dLong* cacheKey - application defined key of the cache entry that belongs to this ray.
+// *const dFloat* *p0 - pointer to an array of at least three floats containing the beginning of the ray in global space.
+// *const dFloat* *p1 - pointer to an array of at least three floats containing the end of the ray in global space.
+// *dFloat* tolerance - distance each end point, and each body near the ray, can move and still reuse the last answer.
+// *NewtonWorldRayPrefilterCallback* prefilter - user define function to be called for each body before intersection, can be NULL.
+// *void* *userData - user data passed to the prefilter function.
+// *NewtonWorldRayHitInfo* *hitInfo - receives the closest hit, m_hitBody is NULL when the ray did not hit anything.
+//
+// Return: nothing
+// 
+// Remarks: the cache entry remembers the last ray, the last body it hit and the boxes of the bodies the ray crossed. The entry stays valid 
+// across updates until a body is added or removed, one of those bodies moves more than the tolerance, or any other body moves to within 
+// the tolerance of the ray. While it is valid and both end points are within the tolerance of the last ray, the last hit is returned 
+// without any test. With zero tolerance that answer is exact. Otherwise the subtree around the last body hit is tested first and its hit 
+// clips the ray, so the traversal of the rest of the broadphase skips most nodes when the answer did not change much.
+//
+// Remarks: the key can be any value, for example the address of the object that owns the ray. Different threads can use 
+// different keys at the same time, but one key must not be used by two threads at the same time. The cached answer does not depend 
+// on the prefilter, so the application should use a new key when the prefilter changes. The world keeps up to 1024 entries,
+// when a new key does not fit the least recently used entry is released.
+//
+// See also: NewtonWorldRemoveQueryCache, NewtonWorldBodiesInAABBCached, NewtonWorldRayCast
+void NewtonWorldRayCastCached (const NewtonWorld* const newtonWorld, dLong cacheKey, const dFloat* const p0, const dFloat* const p1, dFloat tolerance, NewtonWorldRayPrefilterCallback prefilter, void* const userData, NewtonWorldRayHitInfo* const hitInfo)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	dgVector pp0 (p0[0], p0[1], p0[2], dgFloat32 (0.0f));
+	dgVector pp1 (p1[0], p1[1], p1[2], dgFloat32 (0.0f));
+	world->GetBroadPhase()->RayCastCached (dgUnsigned64 (cacheKey), pp0, pp1, dgFloat32 (tolerance), (OnRayPrecastAction) prefilter, userData, (dgRayHitInfo*) hitInfo);
+}
+
+// Name: NewtonWorldBodiesInAABBCached 
+// Get the bodies that overlap a box that is queried again and again with small changes.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the world.
+// *dLong* cacheKey - application defined key of the cache entry that belongs to this box.
+// *const dFloat* *p0 - pointer to an array of at least three floats to hold minimum value for the AABB.
+// *const dFloat* *p1 - pointer to an array of at least three floats to hold maximum value for the AABB.
+// *dFloat* tolerance - distance the box is grown by when the bodies are collected from the broadphase.
+// *NewtonBody** *bodyArray - receives the bodies.
+// *int* maxBodies - size of the body array.
+//
+// Return: the number of bodies written to the array.
+// 
+// Remarks: the cache entry keeps the bodies that overlap the box grown by the tolerance. The entry stays valid across updates until 
+// a body is added or removed, one of those bodies moves more than the tolerance, or any other body moves into the grown box. While it 
+// is valid, a box that is inside the grown box is answered from that list, otherwise the broadphase is queried again.
+// The answer is always the same as NewtonWorldForEachBodyInAABBDo for the box.
+//
+// Remarks: the rules for the keys are the same as in NewtonWorldRayCastCached.
+//
+// See also: NewtonWorldRemoveQueryCache, NewtonWorldRayCastCached, NewtonWorldForEachBodyInAABBDo
+int NewtonWorldBodiesInAABBCached (const NewtonWorld* const newtonWorld, dLong cacheKey, const dFloat* const p0, const dFloat* const p1, dFloat tolerance, NewtonBody** const bodyArray, int maxBodies)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	dgVector q0 (p0[0], p0[1], p0[2], dgFloat32 (0.0f));
+	dgVector q1 (p1[0], p1[1], p1[2], dgFloat32 (0.0f));
+	return world->GetBroadPhase()->BodiesInAABBCached (dgUnsigned64 (cacheKey), q0, q1, dgFloat32 (tolerance), (dgBody**) bodyArray, maxBodies);
+}
+
+// Name: NewtonWorldRemoveQueryCache 
+// Release the cache entry of a cached query.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the world.
+// *dLong* cacheKey - key of the cache entry.
+//
+// Return: nothing
+// 
+// Remarks: entries are also released when the world is destroyed, or when they are the least recently used and the cache is full.
+//
+// See also: NewtonWorldRayCastCached, NewtonWorldBodiesInAABBCached
+void NewtonWorldRemoveQueryCache (const NewtonWorld* const newtonWorld, dLong cacheKey)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->GetBroadPhase()->RemoveQueryCache (dgUnsigned64 (cacheKey));
+}
+
 void NewtonWorldConvexRayCast (const NewtonWorld* const newtonWorld, const NewtonCollision* const shape, const dFloat* const matrix, const dFloat* const p1, NewtonWorldRayFilterCallback filter, void* const userData, NewtonWorldRayPrefilterCallback prefilter, int threadIndex)
 {
 	TRACE_FUNCTION(__FUNCTION__);
@@ -1281,7 +2067,7 @@ void NewtonWorldConvexRayCast (const NewtonWorld* const newtonWorld, const Newto
 // The application can use this callback to implement faster or smarter filters when implementing complex logic, otherwise for normal all ray cast
 // this parameter could be NULL.
 //
-// See also: NewtonWorldRayCast  
+// See also: NewtonWorldRayCast, NewtonWorldConvexCastBatch
 int NewtonWorldConvexCast(const NewtonWorld* const newtonWorld, const dFloat* const matrix, const dFloat* const target, 
 						  const NewtonCollision* const shape, dFloat* const hitParam, void* const userData, 
 						  NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, 
@@ -1294,6 +2080,40 @@ int NewtonWorldConvexCast(const NewtonWorld* const newtonWorld, const dFloat* co
 }
 
 
+// Name: NewtonWorldConvexCastBatch 
+// Cast many convex shapes in one call.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the world.
+// *const NewtonCollision* const* *shapeArray - one convex shape for each cast, the same shape can be repeated.
+// *const dFloat* *matrixArray - castsCount matrices of 16 floats each, with the start position and orientation of each shape in global space.
+// *const dFloat* *targetArray - pointer to the first float of the end of the first cast in global space.
+// *int* targetStrideInBytes - distance in bytes from one target to the next.
+// *int* castsCount - number of casts.
+// *NewtonWorldRayPrefilterCallback* prefilter - user define function to be called for each body before intersection, can be NULL.
+// *void* const* *userDataArray - one user data for each cast passed to the prefilter, can be NULL.
+// *dFloat* *hitParamArray - receives the time of impact of each cast, 1.0 when the shape did not hit anything.
+// *int* *contactsCountArray - receives the number of contacts of each cast, can be NULL.
+// *NewtonWorldConvexCastReturnInfo* *infoArray - array of castsCount * maxContactsPerCast contacts, the contacts of cast i start at infoArray[i * maxContactsPerCast], can be NULL.
+// *int* maxContactsPerCast - maximum number of contacts reported for each cast, zero to only calculate the time of impact.
+// *int* threadIndex - thread index from where this function is called, zero if called from outside a newton update.
+//
+// Return: nothing
+//
+// Remarks: each cast returns the same result as NewtonWorldConvexCast would. When called outside the simulation step the casts are split 
+// among all the world threads, and the prefilter can then be called from several threads at the same time. 
+// Called from inside the step, for example from a listener, all the casts are done by the calling thread.
+//
+// See also: NewtonWorldConvexCast
+void NewtonWorldConvexCastBatch (const NewtonWorld* const newtonWorld, const NewtonCollision* const* const shapeArray, const dFloat* const matrixArray, const dFloat* const targetArray, int targetStrideInBytes, int castsCount, 
+								 NewtonWorldRayPrefilterCallback prefilter, void* const* const userDataArray, dFloat* const hitParamArray, int* const contactsCountArray, 
+								 NewtonWorldConvexCastReturnInfo* const infoArray, int maxContactsPerCast, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->GetBroadPhase()->ConvexCastBatch ((const dgCollisionInstance* const*) shapeArray, matrixArray, targetArray, targetStrideInBytes, castsCount, (OnRayPrecastAction) prefilter, userDataArray, hitParamArray, contactsCountArray, (dgConvexCastReturnInfo*) infoArray, infoArray ? maxContactsPerCast : 0, threadIndex);
+}
+
 int NewtonWorldCollide (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const NewtonCollision* const shape, void* const userData,  
 					   NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex)
 {
@@ -4504,6 +5324,57 @@ NewtonBody* NewtonCreateDeformableBody (const NewtonWorld* const newtonWorld, co
 	return (NewtonBody*) world->CreateDeformableBody (collision, matrix);
 }
 
+// Name: NewtonCreateBodiesBatch 
+// Create many rigid bodies in one call.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world.
+// *int* count - number of bodies to create.
+// *int* bodyType - NEWTON_DYNAMIC_BODY, NEWTON_KINEMATIC_BODY or NEWTON_DEFORMABLE_BODY, all bodies are of the same type.
+// *const NewtonCollision* const* *collisionArray - one collision per body, the same collision can be repeated.
+// *const dFloat* *matrixArray - count matrices of 16 floats each.
+// *const dFloat* *massArray - the mass of each body, or NULL. Bodies with zero mass are static.
+// *NewtonBody** *bodyArray - receives the count new bodies, in the same order as the collisions.
+//
+// Return: Nothing.
+//
+// Remarks: each body is the same as one made by the create function of its type, but the collision boxes are calculated 
+// by all the world threads and the new bodies are added to the broadphase as one subtree built in parallel, 
+// which is much faster than adding them one at the time when loading thousands of bodies.
+// Called from inside a simulation step, or for deformable bodies, the bodies are created one at the time.
+// The mass and inertia of each body are set as *NewtonBodySetMassProperties* does, before the bodies enter the broadphase. 
+// Bodies that get their mass later are moved out of the static broadphase tree one at the time, 
+// so the application should pass the masses here when it creates many dynamic bodies.
+//
+// See also: NewtonCreateDynamicBody, NewtonDestroyBodiesBatch, NewtonBodySetMassProperties
+void NewtonCreateBodiesBatch (const NewtonWorld* const newtonWorld, int count, int bodyType, const NewtonCollision* const* const collisionArray, const dFloat* const matrixArray, const dFloat* const massArray, NewtonBody** const bodyArray)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+
+	dgBody::dgRTTI rtti = dgBody::m_dynamicBodyRTTI;
+	if (bodyType == NEWTON_KINEMATIC_BODY) {
+		rtti = dgBody::m_kinematicBodyRTTI;
+	} else if (bodyType == NEWTON_DEFORMABLE_BODY) {
+		rtti = dgBody::m_deformableBodyRTTI;
+	}
+
+	if (count > 0) {
+		dgStack<dgMatrix> matrices (count);
+		dgStack<dgFloat32> masses (count);
+		for (dgInt32 i = 0; i < count; i ++) {
+			masses[i] = massArray ? dgFloat32 (massArray[i]) : dgFloat32 (0.0f);
+			dgMatrix matrix (&matrixArray[i * 16]);
+			matrix.m_front.m_w = dgFloat32 (0.0f);
+			matrix.m_up.m_w    = dgFloat32 (0.0f);
+			matrix.m_right.m_w = dgFloat32 (0.0f);
+			matrix.m_posit.m_w = dgFloat32 (1.0f);
+			matrices[i] = matrix;
+		}
+		world->CreateBodiesBatch ((dgBody**) bodyArray, count, rtti, (dgCollisionInstance* const*) collisionArray, &matrices[0], &masses[0]);
+	}
+}
+
 // Name: NewtonDestroyBody 
 // Destroy a rigid body.
 //
@@ -4526,6 +5397,34 @@ void NewtonDestroyBody (const NewtonBody* const bodyPtr)
 	world->DestroyBody(body);
 }
 
+// Name: NewtonDestroyBodiesBatch 
+// Destroy many rigid bodies in one call.
+//
+// Parameters:
+// *const NewtonWorld* *newtonWorld - is the pointer to the Newton world.
+// *NewtonBody* const* *bodyArray - the bodies to be destroyed, all must belong to this world.
+// *int* count - number of bodies in the array.
+//
+// Return: Nothing.
+//
+// Remarks: the callbacks are the same as for NewtonDestroyBody. When at least half of the bodies in the world are destroyed 
+// the broadphase tree is rebuilt in parallel from the bodies that are left instead of being unlinked one body at the time.
+// Called from inside a simulation step the bodies are destroyed one at the time.
+//
+// See also: NewtonDestroyBody, NewtonCreateBodiesBatch
+void NewtonDestroyBodiesBatch (const NewtonWorld* const newtonWorld, NewtonBody* const* const bodyArray, int count)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	if (count > 0) {
+		dgStack<dgBody*> bodies (count);
+		for (dgInt32 i = 0; i < count; i ++) {
+			bodies[i] = (dgBody*) bodyArray[i];
+		}
+		world->DestroyBodiesBatch (&bodies[0], count);
+	}
+}
+
 void NewtonBodyEnableSimulation(const NewtonBody* const bodyPtr)
 {
 	TRACE_FUNCTION(__FUNCTION__);
@@ -92,13 +92,24 @@ extern "C" {
 
 	#define NEWTON_PRE_LISTERNER_CALLBACK_UPDATE			9
 	#define NEWTON_POST_LISTERNER_CALLBACK_UPDATE			10
+	#define NEWTON_PROFILER_COUNTERS_COUNT					11
 
+	#define NEWTON_MAX_THREADS_COUNT						16
+	#define NEWTON_SOLVER_ITERATIONS_HISTOGRAM_SIZE		6
 
 
+
+	#define NEWTON_THREAD_IDLE_BLOCKING						0
+	#define NEWTON_THREAD_IDLE_SPIN_THEN_PARK				1
+	#define NEWTON_THREAD_IDLE_BUSY_POLL					2
+
 	#define NEWTON_DYNAMIC_BODY								0
 	#define NEWTON_KINEMATIC_BODY							1
 	#define NEWTON_DEFORMABLE_BODY							2
 
+	#define NEWTON_RAY_CAST_CLOSEST_HIT						0
+	#define NEWTON_RAY_CAST_ANY_HIT							1
+
 	#define SERIALIZE_ID_SPHERE								0
 	#define SERIALIZE_ID_CAPSULE							1
 	#define SERIALIZE_ID_CHAMFERCYLINDER					2
@@ -312,6 +323,15 @@ extern "C" {
 		const NewtonBody* m_hitBody;			// body hit at contact point
 		dFloat m_penetration;                   // contact penetration at collision point
 	} NewtonWorldConvexCastReturnInfo;
+
+	typedef struct NewtonWorldRayHitInfo
+	{
+		dFloat m_point[4];						// hit point in global space
+		dFloat m_normal[4];						// surface normal at the hit point in global space
+		dLong m_contactID;						// collision ID at the hit point
+		const NewtonBody* m_hitBody;			// body hit by the ray, NULL when the ray did not hit anything
+		dFloat m_intersectParam;				// fraction of the segment at the hit point, 1.0 when the ray did not hit anything
+	} NewtonWorldRayHitInfo;
 	
 	typedef struct NewtonUserMeshCollisionRayHitDesc
 	{
@@ -336,6 +356,20 @@ extern "C" {
 		dFloat m_stiffness;
 	} NewtonClothPatchMaterial;
 
+	typedef struct NewtonWorldCounters
+	{
+		dLong m_ticks[NEWTON_MAX_THREADS_COUNT + 1][NEWTON_PROFILER_COUNTERS_COUNT];	// nanoseconds each thread spent in each NEWTON_PROFILER_ phase, the last row is the thread that called the update 
+		int m_pairsTested;						// colliding pairs that went through the narrow phase
+		int m_contactPoints;					// contact points generated by the narrow phase
+		int m_islands;							// islands solved
+		int m_solverRows;						// constraint rows of all islands
+		int m_solverIterations;					// solver passes summed over all islands
+		int m_sleepingBodies;					// dynamics bodies sleeping at the beginning of the update
+		int m_solverEarlyExitIslands;			// islands that met the residual before running all the passes they were allowed
+		int m_solverIslandIterations[NEWTON_SOLVER_ITERATIONS_HISTOGRAM_SIZE];	// islands by solver passes, slot i counts the islands of up to 2^(i+1) passes, the last slot all the rest
+		int m_threadCount;						// worker threads, rows past this value and before the last row are zero
+	} NewtonWorldCounters;
+
 
 	// Newton callback functions
 	typedef void* (*NewtonAllocMemory) (int sizeInBytes);
@@ -357,6 +391,7 @@ extern "C" {
 	typedef void (*NewtonOnBodyDeserializationCallback) (NewtonBody* const body, NewtonDeserializeCallback function, void* const serializeHandle);
 
 	typedef void (*NewtonOnUserCollisionSerializationCallback) (void* const userData, NewtonSerializeCallback function, void* const serializeHandle);
+	typedef void (*NewtonReplayFrameCallback) (void* const userData, int frame, dFloat milliseconds, unsigned recordedCRC, unsigned replayCRC);
 
 	
 	// user collision callbacks	
@@ -428,6 +463,9 @@ extern "C" {
 	NEWTON_API int NewtonWorldFloatSize ();
 
 	NEWTON_API int NewtonGetMemoryUsed ();
+	NEWTON_API int NewtonGetThreadMemoryUsed (const NewtonWorld* const newtonWorld, int threadIndex);
+	NEWTON_API void NewtonReserveFrameArena (const NewtonWorld* const newtonWorld, int sizeInBytes);
+	NEWTON_API int NewtonGetFrameArenaPeak (const NewtonWorld* const newtonWorld, int threadIndex);
 	NEWTON_API void NewtonSetMemorySystem (NewtonAllocMemory malloc, NewtonFreeMemory free);
 
 	NEWTON_API NewtonWorld* NewtonCreate ();
@@ -453,12 +491,23 @@ extern "C" {
 
 	NEWTON_API void NewtonSetMultiThreadSolverOnSingleIsland (const NewtonWorld* const newtonWorld, int mode);
 	NEWTON_API int NewtonGetMultiThreadSolverOnSingleIsland (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonSetMultiThreadSolverSimdBlocks (const NewtonWorld* const newtonWorld, int mode);
+	NEWTON_API int NewtonGetMultiThreadSolverSimdBlocks (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonSetSolverAdaptiveIterations (const NewtonWorld* const newtonWorld, dFloat residual, int minIterations, int maxIterations);
+	NEWTON_API void NewtonGetSolverAdaptiveIterations (const NewtonWorld* const newtonWorld, dFloat* const residual, int* const minIterations, int* const maxIterations);
+
+	NEWTON_API void NewtonSetTaskGraphStepMode (const NewtonWorld* const newtonWorld, int mode);
+	NEWTON_API int NewtonGetTaskGraphStepMode (const NewtonWorld* const newtonWorld);
 
 	NEWTON_API void NewtonSetPerformanceClock (const NewtonWorld* const newtonWorld, NewtonGetTicksCountCallback callback);
 	NEWTON_API unsigned NewtonReadPerformanceTicks (const NewtonWorld* const newtonWorld, unsigned performanceEntry);
 
 	NEWTON_API int NewtonGetBroadphaseAlgorithm (const NewtonWorld* const newtonWorld);
 	NEWTON_API void NewtonSelectBroadphaseAlgorithm (const NewtonWorld* const newtonWorld, int algorithmType);
+	NEWTON_API int NewtonGetBroadphaseMaintenanceBudget (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonSetBroadphaseMaintenanceBudget (const NewtonWorld* const newtonWorld, int microseconds);
+	NEWTON_API int NewtonGetBroadphaseSnapshotState (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonSetBroadphaseSnapshotState (const NewtonWorld* const newtonWorld, int state);
 	
 	NEWTON_API void NewtonUpdate (const NewtonWorld* const newtonWorld, dFloat timestep);
 	NEWTON_API void NewtonUpdateAsync (const NewtonWorld* const newtonWorld, dFloat timestep);
@@ -468,8 +517,22 @@ extern "C" {
 	NEWTON_API void NewtonSerializeBodyArray (const NewtonWorld* const newtonWorld, NewtonBody** const bodyArray, int bodyCount, NewtonOnBodySerializationCallback serializeBody, NewtonSerializeCallback serializeFunction, void* const serializeHandle);
 	NEWTON_API void NewtonDeserializeBodyArray (const NewtonWorld* const newtonWorld, NewtonOnBodyDeserializationCallback deserializeBody, NewtonDeserializeCallback serializeFunction, void* const serializeHandle);
 
+	NEWTON_API int NewtonRecorderStart (const NewtonWorld* const newtonWorld, const char* const fileName);
+	NEWTON_API void NewtonRecorderStop (const NewtonWorld* const newtonWorld);
+	NEWTON_API int NewtonReplay (const NewtonWorld* const newtonWorld, const char* const fileName, NewtonReplayFrameCallback callback, void* const userData);
+	NEWTON_API unsigned NewtonWorldGetStateCRC (const NewtonWorld* const newtonWorld);
+
 
 	NEWTON_API unsigned NewtonReadThreadPerformanceTicks (const NewtonWorld* newtonWorld, unsigned threadIndex);
+	NEWTON_API void NewtonReadWorldCounters (const NewtonWorld* const newtonWorld, NewtonWorldCounters* const counters);
+	NEWTON_API unsigned NewtonReadThreadStealCount (const NewtonWorld* const newtonWorld, unsigned threadIndex);
+	NEWTON_API unsigned NewtonReadThreadIdleCount (const NewtonWorld* const newtonWorld, unsigned threadIndex);
+	NEWTON_API unsigned NewtonReadThreadSpinTime (const NewtonWorld* const newtonWorld, unsigned threadIndex);
+	NEWTON_API unsigned NewtonReadThreadParkedTime (const NewtonWorld* const newtonWorld, unsigned threadIndex);
+
+	NEWTON_API void NewtonProfilerStartCapture (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonProfilerStopCapture (const NewtonWorld* const newtonWorld);
+	NEWTON_API int NewtonProfilerSaveTrace (const NewtonWorld* const newtonWorld, const char* const fileName);
 
 	// multi threading interface 
 	NEWTON_API void NewtonWorldCriticalSectionLock (const NewtonWorld* const newtonWorld, int threadIndex);
@@ -477,6 +540,11 @@ extern "C" {
 	NEWTON_API void NewtonSetThreadsCount (const NewtonWorld* const newtonWorld, int threads);
 	NEWTON_API int NewtonGetThreadsCount(const NewtonWorld* const newtonWorld);
 	NEWTON_API int NewtonGetMaxThreadsCount(const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonSetThreadIdlePolicy (const NewtonWorld* const newtonWorld, int policy, int spinCount);
+	NEWTON_API int NewtonGetThreadIdlePolicy (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonSetThreadAffinity (const NewtonWorld* const newtonWorld, int threadIndex, int cpuIndex);
+	NEWTON_API int NewtonGetThreadAffinity (const NewtonWorld* const newtonWorld, int threadIndex);
+	NEWTON_API int NewtonSetThreadsNumaNode (const NewtonWorld* const newtonWorld, int node);
 	NEWTON_API void NewtonDispachThreadJob(const NewtonWorld* const newtonWorld, NewtonJobTask task, void* const usedData);
 	NEWTON_API void NewtonSyncThreadJobs(const NewtonWorld* const newtonWorld);
 
@@ -493,6 +561,8 @@ extern "C" {
 //	NEWTON_API void NewtonWorldForEachBodyDo (const NewtonWorld* const newtonWorld, NewtonBodyIterator callback);
 	NEWTON_API void NewtonWorldForEachJointDo (const NewtonWorld* const newtonWorld, NewtonJointIterator callback, void* const userData);
 	NEWTON_API void NewtonWorldForEachBodyInAABBDo (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonBodyIterator callback, void* const userData);
+	NEWTON_API void NewtonWorldSnapshotForEachBodyInAABBDo (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonBodyIterator callback, void* const userData);
+	NEWTON_API void NewtonWorldBodiesInAABBBatch (const NewtonWorld* const newtonWorld, const dFloat* const p0Array, const dFloat* const p1Array, int strideInBytes, int boxesCount, NewtonBody** const bodyArray, int maxBodiesPerBox, int* const bodiesCountArray);
 
 	
 	NEWTON_API void NewtonWorldSetUserData (const NewtonWorld* const newtonWorld, void* const userData);
@@ -520,12 +590,20 @@ extern "C" {
 	}
 
 	NEWTON_API void NewtonWorldRayCast (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonWorldRayFilterCallback filter, void* const userData, NewtonWorldRayPrefilterCallback prefilter, int threadIndex);
+	NEWTON_API void NewtonWorldSnapshotRayCast (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonWorldRayFilterCallback filter, void* const userData, NewtonWorldRayPrefilterCallback prefilter);
+	NEWTON_API void NewtonWorldRayCastBatch (const NewtonWorld* const newtonWorld, const dFloat* const p0Array, const dFloat* const p1Array, int strideInBytes, int raysCount, int mode, NewtonWorldRayHitInfo* const hitArray);
+	NEWTON_API void NewtonWorldRayCastCached (const NewtonWorld* const newtonWorld, dLong cacheKey, const dFloat* const p0, const dFloat* const p1, dFloat tolerance, NewtonWorldRayPrefilterCallback prefilter, void* const userData, NewtonWorldRayHitInfo* const hitInfo);
+	NEWTON_API int NewtonWorldBodiesInAABBCached (const NewtonWorld* const newtonWorld, dLong cacheKey, const dFloat* const p0, const dFloat* const p1, dFloat tolerance, NewtonBody** const bodyArray, int maxBodies);
+	NEWTON_API void NewtonWorldRemoveQueryCache (const NewtonWorld* const newtonWorld, dLong cacheKey);
 	NEWTON_API void NewtonWorldConvexRayCast (const NewtonWorld* const newtonWorld, const NewtonCollision* const shape, const dFloat* const matrix, const dFloat* const p1, NewtonWorldRayFilterCallback filter, void* const userData, NewtonWorldRayPrefilterCallback prefilter, int threadIndex);
 
 	NEWTON_API int NewtonWorldCollide (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const NewtonCollision* const shape, void* const userData,  
 									   NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex);
 	NEWTON_API int NewtonWorldConvexCast (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const dFloat* const target, const NewtonCollision* const shape, dFloat* const hitParam, void* const userData,  
 										  NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex);
+	NEWTON_API void NewtonWorldConvexCastBatch (const NewtonWorld* const newtonWorld, const NewtonCollision* const* const shapeArray, const dFloat* const matrixArray, const dFloat* const targetArray, int targetStrideInBytes, int castsCount, 
+												NewtonWorldRayPrefilterCallback prefilter, void* const* const userDataArray, dFloat* const hitParamArray, int* const contactsCountArray, 
+												NewtonWorldConvexCastReturnInfo* const infoArray, int maxContactsPerCast, int threadIndex);
 
 
 	// world utility functions
@@ -857,8 +935,10 @@ extern "C" {
 	NEWTON_API NewtonBody* NewtonCreateDynamicBody (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision, const dFloat* const matrix);
 	NEWTON_API NewtonBody* NewtonCreateKinematicBody (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision, const dFloat* const matrix);
 	NEWTON_API NewtonBody* NewtonCreateDeformableBody (const NewtonWorld* const newtonWorld, const NewtonCollision* const deformableMesh, const dFloat* const matrix);
+	NEWTON_API void NewtonCreateBodiesBatch (const NewtonWorld* const newtonWorld, int count, int bodyType, const NewtonCollision* const* const collisionArray, const dFloat* const matrixArray, const dFloat* const massArray, NewtonBody** const bodyArray);
 
 	NEWTON_API void NewtonDestroyBody(const NewtonBody* const body);
+	NEWTON_API void NewtonDestroyBodiesBatch (const NewtonWorld* const newtonWorld, NewtonBody* const* const bodyArray, int count);
 
 	NEWTON_DEPRECATED_API void NewtonBodyEnableSimulation(const NewtonBody* const body);
 	NEWTON_DEPRECATED_API void NewtonBodyDisableSimulation(const NewtonBody* const body);
@@ -77,6 +77,8 @@ dgBody::dgBody()
 	m_collidable = true;
 	m_collideWithLinkedBodies = true;
 	m_invWorldInertiaMatrix[3][3] = dgFloat32 (1.0f);
+	m_snapshotIndex[0] = -1;
+	m_snapshotIndex[1] = -1;
 }
 
 dgBody::dgBody (dgWorld* const world, const dgTree<const dgCollision*, dgInt32>* const collisionCashe, dgDeserialize serializeCallback, void* const userData)
@@ -115,6 +117,8 @@ dgBody::dgBody (dgWorld* const world, const dgTree<const dgCollision*, dgInt32>*
 	m_collidable = true;
 	m_collideWithLinkedBodies = true;
 	m_invWorldInertiaMatrix[3][3] = dgFloat32 (1.0f);
+	m_snapshotIndex[0] = -1;
+	m_snapshotIndex[1] = -1;
 
 	serializeCallback (userData, &m_rotation, sizeof (m_rotation));
 	serializeCallback (userData, &m_matrix.m_posit, sizeof (m_matrix.m_posit));
@@ -521,6 +525,10 @@ void dgBody::SetMassMatrix(dgFloat32 mass, dgFloat32 Ixx, dgFloat32 Iyy, dgFloat
 		SetAparentMassMatrix (dgVector (Ixx, Iyy, Izz, mass));
 	}
 
+	if (m_collisionCell) {
+		CheckStaticState ();
+	}
+
 #ifdef _DEBUG
 	dgBodyMasterList& me = *m_world;
 	for (dgBodyMasterList::dgListNode* refNode = me.GetFirst(); refNode; refNode = refNode->GetNext()) {
@@ -539,6 +547,12 @@ void dgBody::SetMassMatrix(dgFloat32 mass, dgFloat32 Ixx, dgFloat32 Iyy, dgFloat
 }
 
 
+// a body that gains or loses its mass, or a kinematic body that starts or stops moving, is flagged to move to the other broadphase tree
+void dgBody::CheckStaticState ()
+{
+	m_world->GetBroadPhase()->CheckStaticState (this);
+}
+
 void dgBody::SetMassProperties (dgFloat32 mass, const dgCollisionInstance* const collision)
 {
 	// using general central theorem, to extract the Inertia relative to the center of mass 
@@ -191,6 +191,7 @@ class dgBody
 	void UpdateWorlCollisionMatrix() const;
 	void UpdateMatrix (dgFloat32 timestep, dgInt32 threadIndex);
 	void UpdateCollisionMatrix (dgFloat32 timestep, dgInt32 threadIndex);
+	void CheckStaticState ();
 
 		
 	// member variables:
@@ -221,6 +222,7 @@ class dgBody
 	dgInt32 m_type;
 	dgUnsigned32 m_dynamicsLru;	
 	dgUnsigned32 m_genericLRUMark;
+	dgInt32 m_snapshotIndex[2];
 	
 	dgThread::dgCriticalSection m_criticalSectionLock;
 	union 
@@ -262,6 +264,7 @@ class dgBody
 	friend class dgCollisionConvex;
 	friend class dgCollisionCompound;
 	friend class dgCollisionUserMesh;
+	friend class dgWorldRecorder;
 	friend class dgWorldDynamicUpdate;
 	friend class dgBilateralConstraint;
 	friend class dgCollisionConvexPolygon;
@@ -359,6 +362,9 @@ DG_INLINE void dgBody::SetOmega (const dgVector& omega)
 {
 	m_omega = omega;
 	m_equilibrium = false;
+	if (m_collisionCell && IsRTTIType (m_kinematicBodyRTTI)) {
+		CheckStaticState ();
+	}
 }
 
 DG_INLINE dgVector dgBody::GetVelocityAtPoint (const dgVector& point) const
@@ -370,6 +376,9 @@ DG_INLINE void dgBody::SetVelocity (const dgVector& velocity)
 {
 	m_veloc = velocity;
 	m_equilibrium = false;
+	if (m_collisionCell && IsRTTIType (m_kinematicBodyRTTI)) {
+		CheckStaticState ();
+	}
 }
 
 DG_INLINE const dgMatrix& dgBody::GetMatrix() const
@@ -24,6 +24,7 @@
 #include "dgWorld.h"
 #include "dgContact.h"
 #include "dgBroadPhase.h"
+#include "dgBroadPhaseSnapshot.h"
 #include "dgDynamicBody.h"
 #include "dgCollisionConvex.h"
 #include "dgCollisionInstance.h"
@@ -35,6 +36,15 @@
 #define DG_BROADPHASE_MAX_STACK_DEPTH	256
 #define DG_BROADPHASE_AABB_SCALE		dgFloat32 (8.0f)
 #define DG_BROADPHASE_AABB_INV_SCALE	(dgFloat32 (1.0f) / DG_BROADPHASE_AABB_SCALE)
+#define DG_BROADPHASE_SUBTREE_LEAFS		512
+#define DG_BROADPHASE_SUBTREE_DECAY		dgFloat32 (1.25f)
+#define DG_BROADPHASE_PARALLEL_BUILD_LEAFS	1024
+#define DG_BROADPHASE_SAH_BINS			16
+#define DG_BROADPHASE_RAY_BATCH_JOB		64
+#define DG_BROADPHASE_CONVEX_BATCH_JOB	2
+#define DG_BROADPHASE_AABB_BATCH_JOB	16
+#define DG_BROADPHASE_QUERY_CACHE_LEVELS	2
+#define DG_BROADPHASE_QUERY_CACHE_SIZE		1024
 
 dgVector dgBroadPhase::m_conservativeRotAngle (45.0f * 3.14159f / 180.0f);
 
@@ -53,6 +63,12 @@ class dgBroadPhase::dgNode
 		,m_right(NULL)
 		,m_parent(NULL)
 		,m_fitnessNode(NULL) 
+		,m_staticStateNode(NULL)
+		,m_leafCount(1)
+		,m_refitVisits(0)
+		,m_subtreeCost(dgFloat32 (0.0f))
+		,m_buildCost(dgFloat32 (0.0f))
+		,m_isStatic(false)
 	{
 		SetAABB(body->m_minAABB, body->m_maxAABB);
 		m_body->m_collisionCell = this;
@@ -64,6 +80,11 @@ class dgBroadPhase::dgNode
 		,m_right(myNode)
 		,m_parent(sibling->m_parent)
 		,m_fitnessNode(NULL)  
+		,m_staticStateNode(NULL)
+		,m_leafCount(sibling->m_leafCount + myNode->m_leafCount)
+		,m_refitVisits(0)
+		,m_buildCost(dgFloat32 (0.0f))
+		,m_isStatic(false)
 	{
 		if (m_parent) {
 			if (m_parent->m_left == sibling) {
@@ -83,6 +104,7 @@ class dgBroadPhase::dgNode
 		m_maxBox = left->m_maxBox.GetMax(right->m_maxBox);
 		dgVector side0 (m_maxBox - m_minBox);
 		m_surfaceArea = side0.DotProduct4(side0.ShiftTripleRight()).m_x;
+		m_subtreeCost = m_surfaceArea + left->m_subtreeCost + right->m_subtreeCost;
 	}
 
 	dgNode (dgNode* const parent, const dgVector& minBox, const dgVector& maxBox)
@@ -93,6 +115,12 @@ class dgBroadPhase::dgNode
 		,m_right(NULL)
 		,m_parent(parent)
 		,m_fitnessNode(NULL) 
+		,m_staticStateNode(NULL)
+		,m_leafCount(0)
+		,m_refitVisits(0)
+		,m_subtreeCost(dgFloat32 (0.0f))
+		,m_buildCost(dgFloat32 (0.0f))
+		,m_isStatic(false)
 	{
 	}
 
@@ -133,6 +161,24 @@ class dgBroadPhase::dgNode
 		m_surfaceArea = side0.DotProduct4(side0.ShiftTripleRight()).m_x;
 	}
 
+	// small nodes are rebuilt as a unit, but a leaf larger than its whole sibling subtree (a floor or a terrain) 
+	// is lifted to the top of the tree, otherwise every node above it in the subtree pays for its area 
+	bool IsSubtreeRoot () const
+	{
+		if (m_body) {
+			return true;
+		}
+		if (m_leafCount > DG_BROADPHASE_SUBTREE_LEAFS) {
+			return false;
+		}
+		if (m_left->m_body && !m_right->m_body && (m_left->m_surfaceArea > m_right->m_surfaceArea)) {
+			return false;
+		}
+		if (m_right->m_body && !m_left->m_body && (m_right->m_surfaceArea > m_left->m_surfaceArea)) {
+			return false;
+		}
+		return true;
+	}
 
 	dgVector m_minBox;
 	dgVector m_maxBox;
@@ -142,6 +188,18 @@ class dgBroadPhase::dgNode
 	dgNode* m_right;
 	dgNode* m_parent;
 	dgList<dgNode*>::dgListNode* m_fitnessNode;
+
+	// set while the leaf waits in the list of bodies that must move to the other tree
+	dgList<dgNode*>::dgListNode* m_staticStateNode;
+
+	// maintained by the incremental refit, the cost is the sum of the surface area of the internal nodes of the subtree
+	dgInt32 m_leafCount;
+	dgInt32 m_refitVisits;
+	dgFloat32 m_subtreeCost;
+	dgFloat32 m_buildCost;
+
+	// set on the leafs of the static tree
+	bool m_isStatic;
 	static dgVector m_broadPhaseScale;
 	static dgVector m_broadInvPhaseScale;
 
@@ -155,6 +213,105 @@ dgVector dgBroadPhase::dgNode::m_broadPhaseScale (DG_BROADPHASE_AABB_SCALE, DG_B
 dgVector dgBroadPhase::dgNode::m_broadInvPhaseScale (DG_BROADPHASE_AABB_INV_SCALE, DG_BROADPHASE_AABB_INV_SCALE, DG_BROADPHASE_AABB_INV_SCALE, dgFloat32 (0.0f));
 
 
+// four children of the tree packed in one node, the boxes are stored by axis so that 
+// one vector compare tests the four children at once.
+// a child is either the index of another wide node or -(leaf index + 1)
+DG_MSC_VECTOR_ALIGMENT
+class dgBroadPhase::dgWideNode
+{
+	public: 
+	void Init (dgNode* const source)
+	{
+		m_minX = dgVector (dgFloat32 (1.0e15f));
+		m_minY = m_minX;
+		m_minZ = m_minX;
+		m_maxX = dgVector (dgFloat32 (-1.0e15f));
+		m_maxY = m_maxX;
+		m_maxZ = m_maxX;
+		m_child[0] = 0;
+		m_child[1] = 0;
+		m_child[2] = 0;
+		m_child[3] = 0;
+		m_count = 0;
+		m_source = source;
+	}
+
+	void SetBox (dgInt32 index, const dgVector& minBox, const dgVector& maxBox)
+	{
+		m_minX[index] = minBox.m_x;
+		m_minY[index] = minBox.m_y;
+		m_minZ[index] = minBox.m_z;
+		m_maxX[index] = maxBox.m_x;
+		m_maxY[index] = maxBox.m_y;
+		m_maxZ[index] = maxBox.m_z;
+	}
+
+	void GetBox (dgVector& minBox, dgVector& maxBox) const
+	{
+		minBox = dgVector (dgMin (dgMin (m_minX.m_x, m_minX.m_y), dgMin (m_minX.m_z, m_minX.m_w)), 
+						   dgMin (dgMin (m_minY.m_x, m_minY.m_y), dgMin (m_minY.m_z, m_minY.m_w)), 
+						   dgMin (dgMin (m_minZ.m_x, m_minZ.m_y), dgMin (m_minZ.m_z, m_minZ.m_w)), dgFloat32 (0.0f));
+		maxBox = dgVector (dgMax (dgMax (m_maxX.m_x, m_maxX.m_y), dgMax (m_maxX.m_z, m_maxX.m_w)), 
+						   dgMax (dgMax (m_maxY.m_x, m_maxY.m_y), dgMax (m_maxY.m_z, m_maxY.m_w)), 
+						   dgMax (dgMax (m_maxZ.m_x, m_maxZ.m_y), dgMax (m_maxZ.m_z, m_maxZ.m_w)), dgFloat32 (0.0f));
+	}
+
+	// bit i is set if child i overlaps the box, the box components are splat in each vector
+	DG_INLINE dgInt32 OverlapMask (const dgVector& minX, const dgVector& minY, const dgVector& minZ, const dgVector& maxX, const dgVector& maxY, const dgVector& maxZ) const
+	{
+		dgVector test (((m_minX < maxX) & (m_maxX > minX)) & ((m_minY < maxY) & (m_maxY > minY)) & ((m_minZ < maxZ) & (m_maxZ > minZ)));
+		return test.GetSignMask() & ((1 << m_count) - 1);
+	}
+
+	// same as dgFastRayTest::BoxIntersect for the four children, a distance of 1.2 means no hit
+	DG_INLINE dgVector RayDistance (const dgFastRayTest& ray) const
+	{
+		const dgVector p0x (ray.m_p0.BroadcastX());
+		const dgVector p0y (ray.m_p0.BroadcastY());
+		const dgVector p0z (ray.m_p0.BroadcastZ());
+		const dgVector invX (ray.m_dpInv.BroadcastX());
+		const dgVector invY (ray.m_dpInv.BroadcastY());
+		const dgVector invZ (ray.m_dpInv.BroadcastZ());
+
+		dgVector outside ((((p0x <= m_minX) | (p0x >= m_maxX)) & ray.m_isParallel.BroadcastX()) | 
+						  (((p0y <= m_minY) | (p0y >= m_maxY)) & ray.m_isParallel.BroadcastY()) |
+						  (((p0z <= m_minZ) | (p0z >= m_maxZ)) & ray.m_isParallel.BroadcastZ()));
+
+		dgVector tx0 ((m_minX - p0x).CompProduct4(invX));
+		dgVector tx1 ((m_maxX - p0x).CompProduct4(invX));
+		dgVector ty0 ((m_minY - p0y).CompProduct4(invY));
+		dgVector ty1 ((m_maxY - p0y).CompProduct4(invY));
+		dgVector tz0 ((m_minZ - p0z).CompProduct4(invZ));
+		dgVector tz1 ((m_maxZ - p0z).CompProduct4(invZ));
+
+		dgVector t0 (ray.m_minT.GetMax(tx0.GetMin(tx1)).GetMax(ty0.GetMin(ty1)).GetMax(tz0.GetMin(tz1)));
+		dgVector t1 (ray.m_maxT.GetMin(tx0.GetMax(tx1)).GetMin(ty0.GetMax(ty1)).GetMin(tz0.GetMax(tz1)));
+
+		dgVector mask ((t0 < t1).AndNot(outside));
+		dgVector maxDist (dgFloat32 (1.2f));
+		return (t0 & mask) | maxDist.AndNot(mask);
+	}
+
+	dgVector m_minX;
+	dgVector m_minY;
+	dgVector m_minZ;
+	dgVector m_maxX;
+	dgVector m_maxY;
+	dgVector m_maxZ;
+	dgInt32 m_child[4];
+	dgInt32 m_count;
+	dgNode* m_source;
+} DG_GCC_VECTOR_ALIGMENT;
+
+
+
+class dgBroadphasePairSlot
+{
+	public:
+	dgBroadphaseSyncDescriptor* m_descriptor;
+	dgInt32 m_slot;
+	dgInt32 m_pairsAtomicCounter;
+};
 
 class dgBroadphaseSyncDescriptor
 {
@@ -164,6 +321,7 @@ class dgBroadphaseSyncDescriptor
 		,m_pairsCount(0)
 		,m_pairsAtomicCounter(0)
 		,m_jointsAtomicCounter(0)
+		,m_wideLeafsAtomicCounter(0)
 		,m_timestep(dgFloat32 (0.0f))
 		,m_collindPairBodyNode(NULL)
 		,m_forceAndTorqueBodyNode(NULL)
@@ -172,16 +330,27 @@ class dgBroadphaseSyncDescriptor
 	{
 	}
 
-	void CreatePairsJobs (dgBroadPhase::dgNode* const rootNode)
+	void CreatePairsJobs (dgBroadPhase::dgNode* const rootNode, dgBroadPhase::dgNode* const staticRootNode)
 	{
 		dgBroadPhase::dgNode* pool[ DG_BROADPHASE_MAX_STACK_DEPTH];		
 		
+		// the dynamic tree is tested against itself and against the static tree, static bodies never collide with each other
+		dgInt32 stack = 0; 
+		m_pairsCount = 0;
+		if (!rootNode) {
+			return;
+		}
 		pool[0] = rootNode;
 		pool[1] = rootNode;
+		stack = 2;
+		if (staticRootNode && dgOverlapTest (rootNode->m_minBox, rootNode->m_maxBox, staticRootNode->m_minBox, staticRootNode->m_maxBox)) {
+			pool[2] = rootNode;
+			pool[3] = staticRootNode;
+			stack = 4;
+		}
+
 
-		dgInt32 stack = 2; 
 		dgInt32 stackDpeth = 4 * 2;
-		m_pairsCount = 0;
 		while (stack && (m_pairsCount < dgInt32 (sizeof (m_pairs) / (2 * sizeof (m_pairs[0]))))) {
 
 			while (stack >= stackDpeth) {
@@ -273,15 +442,235 @@ class dgBroadphaseSyncDescriptor
 	dgInt32 m_pairsCount;
 	dgInt32 m_pairsAtomicCounter;
 	dgInt32 m_jointsAtomicCounter;
+	dgInt32 m_wideLeafsAtomicCounter;
 	dgFloat32 m_timestep;
 	dgBodyMasterList::dgListNode* m_collindPairBodyNode;
 	dgBodyMasterList::dgListNode* m_forceAndTorqueBodyNode;
 	dgList<dgBody*>::dgListNode* m_newBodiesNodes;
 	dgBroadPhase::dgType m_broadPhaseType;
+	dgBroadphasePairSlot m_pairSlots[DG_MAX_THREADS_HIVE_COUNT];
 	dgBroadPhase::dgNode* m_pairs[1024 * 4];	
 };
 
 
+class dgBroadphaseMaintenanceDescriptor
+{
+	public:
+	dgBroadphaseMaintenanceDescriptor (dgBroadPhase::dgNode** const nodes, dgInt32 count, dgUnsigned64 deadline)
+		:m_nodes(nodes)
+		,m_count(count)
+		,m_atomicIndex(0)
+		,m_deadline(deadline)
+	{
+	}
+
+	dgBroadPhase::dgNode** m_nodes;
+	dgInt32 m_count;
+	dgInt32 m_atomicIndex;
+	dgUnsigned64 m_deadline;
+};
+
+class dgBroadphaseBuildJob
+{
+	public:
+	dgBroadPhase::dgNode** m_primitives;
+	dgBroadPhase::dgNode** m_internalNodes;
+	dgBroadPhase::dgNode* m_parent;
+	dgInt32 m_count;
+	bool m_isLeft;
+};
+
+class dgBroadphaseBuildDescriptor
+{
+	public:
+	dgBroadphaseBuildDescriptor (dgBroadphaseBuildJob* const jobs, dgInt32 count)
+		:m_jobs(jobs)
+		,m_count(count)
+		,m_atomicIndex(0)
+	{
+	}
+
+	dgBroadphaseBuildJob* m_jobs;
+	dgInt32 m_count;
+	dgInt32 m_atomicIndex;
+};
+
+class dgBroadphaseRayBatchDescriptor
+{
+	public:
+	dgBroadphaseRayBatchDescriptor (const dgFloat32* const p0, const dgFloat32* const p1, dgInt32 stride, dgInt32 count, bool anyHit, dgRayHitInfo* const hits)
+		:m_p0(p0)
+		,m_p1(p1)
+		,m_hits(hits)
+		,m_stride(stride)
+		,m_count(count)
+		,m_atomicIndex(0)
+		,m_anyHit(anyHit)
+	{
+	}
+
+	const dgFloat32* m_p0;
+	const dgFloat32* m_p1;
+	dgRayHitInfo* m_hits;
+	dgInt32 m_stride;
+	dgInt32 m_count;
+	dgInt32 m_atomicIndex;
+	bool m_anyHit;
+};
+
+class dgBroadphaseConvexCastBatchDescriptor
+{
+	public:
+	const dgCollisionInstance* const* m_shapes;
+	const dgFloat32* m_matrices;
+	const dgFloat32* m_targets;
+	OnRayPrecastAction m_prefilter;
+	void* const* m_userData;
+	dgFloat32* m_timeToImpact;
+	dgInt32* m_contactsCount;
+	dgConvexCastReturnInfo* m_info;
+	dgInt32 m_maxContacts;
+	dgInt32 m_targetStride;
+	dgInt32 m_count;
+	dgInt32 m_atomicIndex;
+};
+
+class dgBroadphaseAABBBatchDescriptor
+{
+	public:
+	const dgFloat32* m_p0;
+	const dgFloat32* m_p1;
+	dgBody** m_bodies;
+	dgInt32* m_bodiesCount;
+	dgInt32 m_maxBodies;
+	dgInt32 m_stride;
+	dgInt32 m_count;
+	dgInt32 m_atomicIndex;
+};
+
+class dgBroadphaseAABBCollector
+{
+	public:
+	dgBody** m_bodies;
+	dgInt32 m_count;
+	dgInt32 m_maxCount;
+};
+
+DG_MSC_VECTOR_ALIGMENT
+class dgBroadphaseCachedBody
+{
+	public:
+	dgVector m_minBox;
+	dgVector m_maxBox;
+	dgBody* m_body;
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_MSC_VECTOR_ALIGMENT
+class dgBroadphaseQueryCacheEntry
+{
+	public:
+	DG_CLASS_ALLOCATOR(allocator)
+
+	dgBroadphaseQueryCacheEntry (dgMemoryAllocator* const allocator, dgUnsigned64 key)
+		:m_p0(dgFloat32 (0.0f))
+		,m_p1(dgFloat32 (0.0f))
+		,m_bodies(64, allocator)
+		,m_key(key)
+		,m_lruNode(NULL)
+		,m_tolerance(dgFloat32 (0.0f))
+		,m_bodiesCount(0)
+		,m_queryStamp(0)
+		,m_removeStamp(0)
+		,m_isRay(false)
+		,m_valid(false)
+	{
+		memset (&m_hit, 0, sizeof (m_hit));
+	}
+
+	void AddBody (dgBody* const body)
+	{
+		// a body is reported once per shape of a compound, only the first one is kept
+		if (!m_bodiesCount || (m_bodies[m_bodiesCount - 1].m_body != body)) {
+			dgBroadphaseCachedBody& entry = m_bodies[m_bodiesCount];
+			body->GetAABB (entry.m_minBox, entry.m_maxBox);
+			entry.m_body = body;
+			m_bodiesCount ++;
+		}
+	}
+
+	bool IsAffectedBy (const dgBody* const body, const dgVector& minBox, const dgVector& maxBox) const
+	{
+		// a body the answer depends on can move up to the tolerance, any other body must stay out of the query
+		const dgVector tol (dgVector (m_tolerance) & dgVector::m_triplexMask);
+		for (dgInt32 i = 0; i < m_bodiesCount; i ++) {
+			const dgBroadphaseCachedBody& cached = m_bodies[i];
+			if (cached.m_body == body) {
+				const dgVector error (((minBox - cached.m_minBox).Abs() > tol) | ((maxBox - cached.m_maxBox).Abs() > tol));
+				return (error.GetSignMask() & 0x07) ? true : false;
+			}
+		}
+		if (m_isRay) {
+			// the next ray can be up to the tolerance away from this one
+			dgFastRayTest ray (m_p0, m_p1);
+			return ray.BoxTest (minBox - tol, maxBox + tol) ? true : false;
+		}
+		return dgOverlapTest (minBox, maxBox, m_p0, m_p1) ? true : false;
+	}
+
+	// the ray end points, or the box of the overlap query grown by the tolerance
+	dgVector m_p0;
+	dgVector m_p1;
+	dgRayHitInfo m_hit;
+	// the bodies the answer depends on with their boxes at the time of the query, the bodies tested by the ray or the bodies in the grown box 
+	dgArray<dgBroadphaseCachedBody> m_bodies;
+	dgUnsigned64 m_key;
+	dgList<dgBroadphaseQueryCacheEntry*>::dgListNode* m_lruNode;
+	dgFloat32 m_tolerance;
+	dgInt32 m_bodiesCount;
+	dgUnsigned32 m_queryStamp;
+	dgUnsigned32 m_removeStamp;
+	bool m_isRay;
+	bool m_valid;
+} DG_GCC_VECTOR_ALIGMENT;
+
+class dgBroadphaseQueryCache: public dgTree<dgBroadphaseQueryCacheEntry*, dgUnsigned64>
+{
+	public:
+	dgBroadphaseQueryCache (dgMemoryAllocator* const allocator)
+		:dgTree<dgBroadphaseQueryCacheEntry*, dgUnsigned64>(allocator)
+		,m_lruList(allocator)
+	{
+	}
+
+	~dgBroadphaseQueryCache ()
+	{
+		Iterator iter (*this);
+		for (iter.Begin(); iter; iter ++) {
+			delete iter.GetNode()->GetInfo();
+		}
+	}
+
+	void RemoveEntry (dgTreeNode* const node)
+	{
+		dgBroadphaseQueryCacheEntry* const entry = node->GetInfo();
+		m_lruList.Remove (entry->m_lruNode);
+		Remove (node);
+		delete entry;
+	}
+
+	// least recently used entries are at the front, the cache is much larger than the threads count so an entry in use is never the oldest 
+	dgList<dgBroadphaseQueryCacheEntry*> m_lruList;
+};
+
+class dgBroadphaseCachedRay: public dgRayHitInfo
+{
+	public:
+	OnRayPrecastAction m_prefilter;
+	void* m_userData;
+	dgBroadphaseQueryCacheEntry* m_entry;
+};
+
+
 class dgBroadPhase::dgSpliteInfo
 {
 	public:
@@ -384,19 +773,59 @@ dgBroadPhase::dgBroadPhase(dgWorld* const world)
 	,m_treeEntropy(dgFloat32 (0.0f))
 	,m_lru(0)
 	,m_fitness(world->GetAllocator())
+	,m_staticRootNode(NULL)
+	,m_staticFitness(world->GetAllocator())
+	,m_staticBuildCost(dgFloat32 (0.0f))
+	,m_staticTreeChanged(false)
+	,m_staticStateChanges(world->GetAllocator())
 	,m_generatedBodies(world->GetAllocator())
 	,m_broadPhaseType(m_generic)
-	,m_contacJointLock()
 	,m_criticalSectionLock()
+	,m_wideNodes(256, world->GetAllocator())
+	,m_wideLeafs(256, world->GetAllocator())
+	,m_wideNodesCount(0)
+	,m_wideLeafsCount(0)
+	,m_wideTreeBuilt(false)
+	,m_wideTreeFitted(false)
+	,m_fitnessArray(256, world->GetAllocator())
+	,m_fitnessArrayCount(0)
+	,m_maintenanceBudget(0)
+	,m_topBuildCost(dgFloat32 (0.0f))
+	,m_refitDeferred(0)
+	,m_fitnessArrayDirty(true)
 	,m_recursiveChunks(false)
+	,m_snapshot(NULL)
+	,m_queryCache(NULL)
+	,m_queryCacheLock()
+	,m_movedBodies(256, world->GetAllocator())
+	,m_movedBodiesCount(0)
+	,m_movedRemoveStamp(0)
+	,m_queryStamp(0)
+	,m_removeStamp(0)
 {
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		m_newContacts[i] = new (world->GetAllocator()) dgArray<dgContact*> (256, world->GetAllocator());
+		m_newContactsCount[i] = 0;
+	}
 }
 
 dgBroadPhase::~dgBroadPhase()
 {
+	if (m_snapshot) {
+		delete m_snapshot;
+	}
+	if (m_queryCache) {
+		delete m_queryCache;
+	}
 	if (m_rootNode) {
 		delete m_rootNode;
 	}
+	if (m_staticRootNode) {
+		delete m_staticRootNode;
+	}
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		delete m_newContacts[i];
+	}
 }
 
 
@@ -445,10 +874,19 @@ void dgBroadPhase::GetWorldSize (dgVector& p0, dgVector& p1) const
 
 void dgBroadPhase::ForEachBodyInAABB (const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
 {
-	if (m_rootNode) {
+	if (m_wideTreeFitted) {
+		ForEachBodyInAABBWide (minBox, maxBox, callback, userData);
+	} else if (m_rootNode || m_staticRootNode) {
 		const dgNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
-		dgInt32 stack = 1;
-		stackPool[0] = m_rootNode;
+		dgInt32 stack = 0;
+		if (m_rootNode) {
+			stackPool[stack] = m_rootNode;
+			stack ++;
+		}
+		if (m_staticRootNode) {
+			stackPool[stack] = m_staticRootNode;
+			stack ++;
+		}
 
 		dgBody* const sentinel = m_world->GetSentinelBody();
 		while (stack) {
@@ -482,18 +920,185 @@ void dgBroadPhase::ForEachBodyInAABB (const dgVector& minBox, const dgVector& ma
 }
 
 
+void dgBroadPhase::ForEachBodyInAABBWide (const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
+{
+	if (m_wideNodesCount) {
+		dgInt32 stackPool[DG_BROADPHASE_MAX_STACK_DEPTH * 2];
+		const dgWideNode* const nodes = &m_wideNodes[0];
+		dgNode* const* const leafs = &m_wideLeafs[0];
+
+		const dgVector minX (minBox.BroadcastX());
+		const dgVector minY (minBox.BroadcastY());
+		const dgVector minZ (minBox.BroadcastZ());
+		const dgVector maxX (maxBox.BroadcastX());
+		const dgVector maxY (maxBox.BroadcastY());
+		const dgVector maxZ (maxBox.BroadcastZ());
+
+		dgInt32 stack = 1;
+		stackPool[0] = 0;
+		dgBody* const sentinel = m_world->GetSentinelBody();
+		while (stack) {
+			stack --;
+			const dgWideNode& node = nodes[stackPool[stack]];
+			dgInt32 mask = node.OverlapMask (minX, minY, minZ, maxX, maxY, maxZ);
+			for (dgInt32 j = 0; mask; j ++) {
+				if (mask & 1) {
+					const dgInt32 child = node.m_child[j];
+					if (child >= 0) {
+						stackPool[stack] = child;
+						stack ++;
+						dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
+					} else {
+						dgBody* const body = leafs[-1 - child]->m_body;
+						if (dgOverlapTest (body->m_minAABB, body->m_maxAABB, minBox, maxBox)) {
+							if (body != sentinel) {
+								if (!callback (body, userData)) {
+									return;
+								}
+							}
+						}
+					}
+				}
+				mask >>= 1;
+			}
+		}
+	}
+}
+
+
 dgInt32 dgBroadPhase::GetBroadPhaseType () const
 {
 	return m_broadPhaseType;
 }
 
+dgInt32 dgBroadPhase::GetMaintenanceBudget () const
+{
+	return m_maintenanceBudget;
+}
+
+void dgBroadPhase::SetMaintenanceBudget (dgInt32 microseconds)
+{
+	if (!m_maintenanceBudget) {
+		m_topBuildCost = dgFloat32 (0.0f);
+	}
+	m_maintenanceBudget = dgMax (microseconds, 0);
+}
+
+bool dgBroadPhase::IsSnapshotEnabled () const
+{
+	return m_snapshot ? true : false;
+}
+
+void dgBroadPhase::EnableSnapshot (bool state)
+{
+	dgAssert (!m_world->m_inUpdate);
+	if (state && !m_snapshot) {
+		m_snapshot = new (m_world->GetAllocator()) dgBroadPhaseSnapshot (m_world->GetAllocator());
+		PublishSnapshot ();
+	} else if (!state && m_snapshot) {
+		delete m_snapshot;
+		m_snapshot = NULL;
+	}
+}
+
+void dgBroadPhase::RemoveFromSnapshot (dgBody* const body)
+{
+	if (m_snapshot) {
+		m_snapshot->RemoveBody (body, body->m_snapshotIndex);
+	}
+}
+
+void dgBroadPhase::SnapshotRayCast (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+{
+	if (m_snapshot) {
+		m_snapshot->RayCast (p0, p1, filter, prefilter, userData);
+	}
+}
+
+void dgBroadPhase::SnapshotForEachBodyInAABB (const dgVector& q0, const dgVector& q1, OnBodiesInAABB callback, void* const userData) const
+{
+	if (m_snapshot) {
+		m_snapshot->ForEachBodyInAABB (q0, q1, callback, userData);
+	}
+}
+
+void dgBroadPhase::PublishSnapshot ()
+{
+	if (m_snapshot) {
+		DG_PROFILER_EVENT (m_world, "PublishSnapshot", DG_PROFILER_MASTER_TRACK);
+
+		dgInt32 bufferIndex;
+		dgBroadPhaseSnapshot::dgBuffer& buffer = m_snapshot->BeginPublish (bufferIndex);
+
+		const dgBody* const sentinel = m_world->GetSentinelBody();
+		dgNode* const roots[] = {m_rootNode, m_staticRootNode};
+		for (dgInt32 i = 0; i < 2; i ++) {
+			if (roots[i]) {
+				// depth first, the left child is written next to its parent and the right child sets the parent index when it is popped
+				dgNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+				dgInt32 parentPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+				stackPool[0] = roots[i];
+				parentPool[0] = -1;
+				dgInt32 stack = 1;
+				buffer.m_roots[i] = buffer.m_nodesCount;
+				while (stack) {
+					stack --;
+					dgNode* const node = stackPool[stack];
+					const dgInt32 index = buffer.m_nodesCount;
+					buffer.m_nodesCount ++;
+					if (parentPool[stack] >= 0) {
+						buffer.m_nodes[parentPool[stack]].m_right = index;
+					}
+
+					dgBroadPhaseSnapshot::dgSnapshotNode& snapNode = buffer.m_nodes[index];
+					snapNode.m_minBox = node->m_minBox;
+					snapNode.m_maxBox = node->m_maxBox;
+					snapNode.m_right = -1;
+					if (node->m_body) {
+						snapNode.m_left = -1;
+						dgBody* const body = node->m_body;
+						if (body != sentinel) {
+							const dgInt32 entryIndex = buffer.m_bodiesCount;
+							dgBroadPhaseSnapshot::dgSnapshotBody& entry = buffer.m_bodies[entryIndex];
+							entry.m_matrix = body->m_collision->GetGlobalMatrix();
+							entry.m_minBox = body->m_minAABB;
+							entry.m_maxBox = body->m_maxAABB;
+							entry.m_body = body;
+							entry.m_collision = body->m_collision->AddRef();
+							body->m_snapshotIndex[bufferIndex] = entryIndex;
+							snapNode.m_right = entryIndex;
+							buffer.m_bodiesCount ++;
+						}
+					} else {
+						snapNode.m_left = index + 1;
+
+						stackPool[stack] = node->m_right;
+						parentPool[stack] = index;
+						stack ++;
+						stackPool[stack] = node->m_left;
+						parentPool[stack] = -1;
+						stack ++;
+						dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
+					}
+				}
+			}
+		}
+
+		m_snapshot->EndPublish ();
+	}
+}
+
 void dgBroadPhase::SelectBroadPhaseType (dgInt32 algorthmType)
 {
 	if (algorthmType == 0) {
 		m_broadPhaseType = m_generic;
+	} else if (algorthmType == 2) {
+		m_broadPhaseType = m_wide;
 	} else {
 		m_broadPhaseType = m_persistent;
 	}
+	m_wideTreeBuilt = false;
+	m_wideTreeFitted = false;
 }
 
 
@@ -507,12 +1112,12 @@ DG_INLINE dgFloat32 dgBroadPhase::CalculateSurfaceArea (const dgNode* const node
 
 
 
-dgBroadPhase::dgNode* dgBroadPhase::InsertNode (dgNode* const node)
+dgBroadPhase::dgNode* dgBroadPhase::InsertNode (dgNode* const root, dgNode* const node, dgFitnessList& fitness)
 {
 	dgVector p0;
 	dgVector p1;
 
-	dgNode* sibling = m_rootNode;
+	dgNode* sibling = root;
 	dgFloat32 surfaceArea = CalculateSurfaceArea (node, sibling, p0, p1);
 	while(sibling->m_left && sibling->m_right) {
 		if (surfaceArea > sibling->m_surfaceArea) {
@@ -545,23 +1150,61 @@ dgBroadPhase::dgNode* dgBroadPhase::InsertNode (dgNode* const node)
 	} 
 
 	dgNode* const parent = new (m_world->GetAllocator()) dgNode (sibling, node);
-	parent->m_fitnessNode = m_fitness.Append (parent);
+	parent->m_fitnessNode = fitness.Append (parent);
 
 	return parent;
 }
 
+bool dgBroadPhase::IsStaticBody (const dgBody* const body) const
+{
+	// kinematic bodies are static only while they are at rest
+	if ((body->m_invMass.m_w != dgFloat32 (0.0f)) || body->IsRTTIType (dgBody::m_deformableBodyRTTI)) {
+		return false;
+	}
+	if (body->IsRTTIType (dgBody::m_kinematicBodyRTTI)) {
+		dgVector speed (body->m_veloc.Abs() + body->m_omega.Abs());
+		return (speed.m_x == dgFloat32 (0.0f)) && (speed.m_y == dgFloat32 (0.0f)) && (speed.m_z == dgFloat32 (0.0f));
+	}
+	return true;
+}
+
+// called by the mass and the kinematic velocity setters, possibly from several threads, the body moves to the other tree on the next update
+void dgBroadPhase::CheckStaticState (dgBody* const body)
+{
+	dgNode* const leaf = body->m_collisionCell;
+	if (leaf && !leaf->m_staticStateNode && (leaf->m_isStatic != IsStaticBody (body))) {
+		m_criticalSectionLock.Lock();
+		if (!leaf->m_staticStateNode) {
+			leaf->m_staticStateNode = m_staticStateChanges.Append (leaf);
+		}
+		m_criticalSectionLock.Unlock();
+	}
+}
+
 void dgBroadPhase::Add (dgBody* const body)
 {
+	m_queryStamp ++;
+	m_wideTreeBuilt = false;
+	m_wideTreeFitted = false;
+
 	// create a new leaf node;
 	dgNode* const newNode = new (m_world->GetAllocator()) dgNode (body);
+	newNode->m_isStatic = IsStaticBody (body);
 
-	if (!m_rootNode) {
-		m_rootNode = newNode;
+	dgNode*& root = newNode->m_isStatic ? m_staticRootNode : m_rootNode;
+	if (newNode->m_isStatic) {
+		m_staticTreeChanged = true;
 	} else {
-		dgNode* const node = InsertNode(newNode);
+		m_fitnessArrayDirty = true;
+	}
+
+	if (!root) {
+		root = newNode;
+	} else {
+		dgNode* const node = InsertNode(root, newNode, newNode->m_isStatic ? m_staticFitness : m_fitness);
 
 		if (!node->m_parent) {
-			m_rootNode = node;
+			root = node;
 		}
 	}
 }
@@ -569,9 +1212,25 @@ void dgBroadPhase::Add (dgBody* const body)
 
 void dgBroadPhase::Remove (dgBody* const body)
 {
-	dgNode* const node = body->m_collisionCell;
+	m_queryStamp ++;
+	m_removeStamp ++;
+	m_wideTreeBuilt = false;
+	m_wideTreeFitted = false;
 
+	dgNode* const node = body->m_collisionCell;
 	dgAssert (!node->m_fitnessNode);
+	if (node->m_staticStateNode) {
+		m_staticStateChanges.Remove (node->m_staticStateNode);
+		node->m_staticStateNode = NULL;
+	}
+
+	dgNode*& root = node->m_isStatic ? m_staticRootNode : m_rootNode;
+	dgFitnessList& fitness = node->m_isStatic ? m_staticFitness : m_fitness;
+	if (node->m_isStatic) {
+		m_staticTreeChanged = true;
+	} else {
+		m_fitnessArrayDirty = true;
+	}
 
 	if (node->m_parent) {
 		dgNode* const grandParent = node->m_parent->m_parent;
@@ -603,22 +1262,22 @@ void dgBroadPhase::Remove (dgBody* const body)
 			}
 		} else {
 			if (node->m_parent->m_right == node) {
-				m_rootNode = node->m_parent->m_left;
-				m_rootNode->m_parent = NULL;
+				root = node->m_parent->m_left;
+				root->m_parent = NULL;
 				node->m_parent->m_left = NULL;
 			} else {
-				m_rootNode = node->m_parent->m_right;
-				m_rootNode->m_parent = NULL;
+				root = node->m_parent->m_right;
+				root->m_parent = NULL;
 				node->m_parent->m_right = NULL;
 			}
 		}
 
 		dgAssert (node->m_parent->m_fitnessNode);
-		m_fitness.Remove(node->m_parent->m_fitnessNode);
+		fitness.Remove(node->m_parent->m_fitnessNode);
 		delete node->m_parent;
 	} else {
 		delete node;
-		m_rootNode = NULL;
+		root = NULL;
 	}
 }
 
@@ -788,19 +1447,24 @@ dgBroadPhase::dgNode* dgBroadPhase::BuildTopDown (dgNode** const leafArray, dgIn
 void dgBroadPhase::ResetEntropy ()
 {
 	m_treeEntropy = dgFloat32 (0.0f);
+	m_staticBuildCost = dgFloat32 (0.0f);
+	m_staticTreeChanged = true;
 }
 
 void dgBroadPhase::ImproveFitness()
 {
+	// the tree rotations change the shape of the tree
+	m_wideTreeBuilt = false;
+	m_wideTreeFitted = false;
+
 	dgFloat64 entropy = CalculateEmptropy();
 	if ((entropy > m_treeEntropy * dgFloat32 (2.0f)) || (entropy < m_treeEntropy * dgFloat32 (0.5f))) {
 		if (m_fitness.GetFirst()) {
 			dgWorld* const world = m_world;
 			dgInt32 count = m_fitness.GetCount() * 2 + 12;
-			world->m_pairMemoryBuffer.ExpandCapacityIfNeessesary (count, sizeof (dgNode*));
 
 			dgInt32 leafNodesCount = 0;
-			dgNode** const leafArray = (dgNode**)&world->m_pairMemoryBuffer[0];
+			dgNode** const leafArray = (dgNode**) world->m_frameArena.Alloc (count * sizeof (dgNode*));
 			for (dgFitnessList::dgListNode* nodePtr = m_fitness.GetFirst(); nodePtr; nodePtr = nodePtr->GetNext()) {
 				dgNode* const node = nodePtr->GetInfo();
 				dgNode* const leftNode = node->m_left;
@@ -820,39 +1484,865 @@ void dgBroadPhase::ImproveFitness()
 			dgFitnessList::dgListNode* nodePtr = m_fitness.GetFirst();
 			m_rootNode = BuildTopDown (leafArray, 0, leafNodesCount - 1, &nodePtr);
 			m_treeEntropy = CalculateEmptropy();
+			if (!world->m_inUpdate) {
+				// called from outside the update, rewind the arena so that repeated calls do not pile up
+				world->m_frameArena.Reset();
+			}
 		} else {
 			m_treeEntropy = entropy;
 		}
 	}
 }
 
-void dgBroadPhase::AddPair (dgBody* const body0, dgBody* const body1, const dgVector& timestep2, dgInt32 threadID)
+void dgBroadPhase::UpdateTreeBounds ()
 {
-	dgAssert ((body0->GetInvMass().m_w != dgFloat32 (0.0f)) || (body1->GetInvMass().m_w != dgFloat32 (0.0f)) || (body0->IsRTTIType(dgBody::m_kinematicBodyRTTI | dgBody::m_deformableBodyRTTI)) || (body1->IsRTTIType(dgBody::m_kinematicBodyRTTI | dgBody::m_deformableBodyRTTI)));
+	UpdateQueryCache ();
+	if (m_refitDeferred) {
+		RefitTree ();
+		m_refitDeferred = 0;
+		m_wideTreeFitted = false;
+	}
+	RefitWideTree ();
+}
 
-	// add all pairs 
-	const dgBodyMaterialList* const materialList = m_world;  
-	dgCollidingPairCollector* const contactPairs = m_world;
+void dgBroadPhase::RefitTreeKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBroadphaseMaintenanceDescriptor* const descriptor = (dgBroadphaseMaintenanceDescriptor*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "RefitTreeKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_broadPhaceTicks, threadID);
+	world->GetBroadPhase()->RefitTreeNodes (descriptor, threadID);
+}
 
-	bool isCollidable = true;
-	dgContact* contact = NULL;
-	if ((body0->IsRTTIType(dgBody::m_kinematicBodyRTTI | dgBody::m_deformableBodyRTTI)) || (body0->GetInvMass().m_w != dgFloat32 (0.0f))) {
-		dgThreadHiveScopeLock lock (m_world, &m_contacJointLock);
-		for (dgBodyMasterListRow::dgListNode* link = body0->m_masterNode->GetInfo().GetFirst(); link; link = link->GetNext()) {
-			dgConstraint* const constraint = link->GetInfo().m_joint;
-			if (constraint->GetId() != dgConstraint::m_contactConstraint) {
-				break;
-			}
-			if (link->GetInfo().m_bodyNode == body1) {
-				contact = (dgContact*)constraint;
-				isCollidable = true;
-				break;
+void dgBroadPhase::RebuildSubtreesKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBroadphaseMaintenanceDescriptor* const descriptor = (dgBroadphaseMaintenanceDescriptor*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "RebuildSubtreesKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_broadPhaceTicks, threadID);
+	world->GetBroadPhase()->RebuildSubtrees (descriptor, threadID);
+}
+
+void dgBroadPhase::RefitTree ()
+{
+	if (m_fitness.GetCount()) {
+		if (m_fitnessArrayDirty) {
+			m_fitnessArrayCount = 0;
+			for (dgFitnessList::dgListNode* node = m_fitness.GetFirst(); node; node = node->GetNext()) {
+				m_fitnessArray[m_fitnessArrayCount] = node->GetInfo();
+				m_fitnessArrayCount ++;
 			}
+			m_fitnessArrayDirty = false;
 		}
 
-		for (dgBodyMasterListRow::dgListNode* link = body0->m_masterNode->GetInfo().GetLast(); link; link = link->GetPrev()) {
-			dgConstraint* const constraint = link->GetInfo().m_joint;
-			if (constraint->GetId() == dgConstraint::m_contactConstraint) {
+		dgBroadphaseMaintenanceDescriptor descriptor (&m_fitnessArray[0], m_fitnessArrayCount, 0);
+		const dgInt32 threadsCount = m_world->GetThreadCount();
+		for (dgInt32 i = 0; i < threadsCount; i ++) {
+			m_world->QueueJob (RefitTreeKernel, &descriptor, m_world);
+		}
+		m_world->SynchronizationBarrier();
+	}
+}
+
+void dgBroadPhase::RefitTreeNodes (dgBroadphaseMaintenanceDescriptor* const descriptor, dgInt32 threadID)
+{
+	// each node is fit by the thread that brings in its second child, 
+	// the leafs start the walk so every node gets there exactly twice.
+	dgNode** const nodes = descriptor->m_nodes;
+	const dgInt32 count = descriptor->m_count;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1)) {
+		dgNode* node = nodes[i];
+		dgInt32 arrivals = (node->m_left->m_body ? 1 : 0) + (node->m_right->m_body ? 1 : 0);
+		while (arrivals && node) {
+			if ((dgAtomicExchangeAndAdd(&node->m_refitVisits, arrivals) + arrivals) < 2) {
+				break;
+			}
+			node->m_refitVisits = 0;
+
+			const dgNode* const left = node->m_left;
+			const dgNode* const right = node->m_right;
+			node->m_surfaceArea = CalculateSurfaceArea (left, right, node->m_minBox, node->m_maxBox);
+			node->m_leafCount = left->m_leafCount + right->m_leafCount;
+			node->m_subtreeCost = node->m_surfaceArea + left->m_subtreeCost + right->m_subtreeCost;
+
+			node = node->m_parent;
+			arrivals = 1;
+		}
+	}
+}
+
+dgInt32 dgBroadPhase::CompareSubtreeDecay (dgNode* const* const nodeA, dgNode* const* const nodeB, void* const notUsed)
+{
+	// the subtrees that were never rebuilt go first, then the ones that lost the most quality
+	dgFloat32 decayA = ((*nodeA)->m_buildCost > dgFloat32 (0.0f)) ? (*nodeA)->m_subtreeCost / (*nodeA)->m_buildCost : dgFloat32 (1.0e10f);
+	dgFloat32 decayB = ((*nodeB)->m_buildCost > dgFloat32 (0.0f)) ? (*nodeB)->m_subtreeCost / (*nodeB)->m_buildCost : dgFloat32 (1.0e10f);
+	if (decayA > decayB) {
+		return -1;
+	} else if (decayA < decayB) {
+		return 1;
+	}
+	return 0;
+}
+
+dgInt32 dgBroadPhase::CompareBodiesUniqueID (dgBody* const* const bodyA, dgBody* const* const bodyB, void* const notUsed)
+{
+	if ((*bodyA)->m_uniqueID < (*bodyB)->m_uniqueID) {
+		return -1;
+	} else if ((*bodyA)->m_uniqueID > (*bodyB)->m_uniqueID) {
+		return 1;
+	}
+	return 0;
+}
+
+void dgBroadPhase::RebuildDirtySubtrees ()
+{
+	if (!m_rootNode || m_rootNode->m_body) {
+		return;
+	}
+
+	const dgUnsigned64 deadline = dgGetTimeInNanoseconds() + dgUnsigned64 (m_maintenanceBudget) * 1000;
+
+	if ((m_topBuildCost == dgFloat32 (0.0f)) && !m_rootNode->IsSubtreeRoot()) {
+		// subtrees made by insertions and rotations overlap each other and rebuilding them one at the time can not fix that, 
+		// so the first maintenance pass rebuilds the whole tree
+		RebuildSubtree (m_rootNode, DG_FRAME_ARENA_SERIAL);
+		m_wideTreeBuilt = false;
+		m_wideTreeFitted = false;
+	}
+
+	// the tree is split in subtrees of up to DG_BROADPHASE_SUBTREE_LEAFS leafs, the nodes above them are the top of the tree
+	const dgInt32 maxCount = m_fitness.GetCount() + 1;
+	dgNode** const stackPool = (dgNode**) m_world->m_frameArena.Alloc (maxCount * sizeof (dgNode*));
+	dgNode** const subtrees = (dgNode**) m_world->m_frameArena.Alloc (maxCount * sizeof (dgNode*));
+	dgNode** const topNodes = (dgNode**) m_world->m_frameArena.Alloc (maxCount * sizeof (dgNode*));
+
+	dgInt32 stack = 1;
+	dgInt32 topCount = 0;
+	dgInt32 dirtyCount = 0;
+	dgFloat32 topCost = dgFloat32 (0.0f);
+	stackPool[0] = m_rootNode;
+	while (stack) {
+		stack --;
+		dgNode* const node = stackPool[stack];
+		if (node->IsSubtreeRoot()) {
+			if (!node->m_body && ((node->m_buildCost == dgFloat32 (0.0f)) || (node->m_subtreeCost > node->m_buildCost * DG_BROADPHASE_SUBTREE_DECAY))) {
+				subtrees[dirtyCount] = node;
+				dirtyCount ++;
+			}
+		} else {
+			topNodes[topCount] = node;
+			topCount ++;
+			topCost += node->m_surfaceArea;
+			stackPool[stack] = node->m_left;
+			stack ++;
+			stackPool[stack] = node->m_right;
+			stack ++;
+		}
+	}
+
+	if (dirtyCount) {
+		// the worst subtrees are rebuilt first, each thread stops taking subtrees once the budget is spent
+		dgSort (subtrees, dirtyCount, CompareSubtreeDecay);
+		dgBroadphaseMaintenanceDescriptor descriptor (subtrees, dirtyCount, deadline);
+		const dgInt32 threadsCount = m_world->GetThreadCount();
+		for (dgInt32 i = 0; i < threadsCount; i ++) {
+			m_world->QueueJob (RebuildSubtreesKernel, &descriptor, m_world);
+		}
+		m_world->SynchronizationBarrier();
+		m_wideTreeBuilt = false;
+		m_wideTreeFitted = false;
+	}
+
+	if (topCount && ((m_topBuildCost == dgFloat32 (0.0f)) || (topCost > m_topBuildCost * DG_BROADPHASE_SUBTREE_DECAY)) && (dgGetTimeInNanoseconds() < deadline)) {
+		// rebuild the top using the subtrees as primitives, the same nodes are reused so it is not more than a few hundred boxes
+		dgInt32 primitivesCount = 0;
+		dgNode** const primitives = subtrees;
+		stack = 1;
+		stackPool[0] = m_rootNode;
+		while (stack) {
+			stack --;
+			dgNode* const node = stackPool[stack];
+			if (node->IsSubtreeRoot()) {
+				primitives[primitivesCount] = node;
+				primitivesCount ++;
+			} else {
+				stackPool[stack] = node->m_left;
+				stack ++;
+				stackPool[stack] = node->m_right;
+				stack ++;
+			}
+		}
+		dgAssert (primitivesCount == (topCount + 1));
+
+		dgInt32 index = 0;
+		m_rootNode = BuildBinned (primitives, primitivesCount, topNodes, index);
+		m_rootNode->m_parent = NULL;
+		dgAssert (index == topCount);
+
+		m_topBuildCost = dgFloat32 (0.0f);
+		for (dgInt32 i = 0; i < topCount; i ++) {
+			m_topBuildCost += topNodes[i]->m_surfaceArea;
+		}
+		m_wideTreeBuilt = false;
+		m_wideTreeFitted = false;
+	}
+}
+
+void dgBroadPhase::RebuildSubtrees (dgBroadphaseMaintenanceDescriptor* const descriptor, dgInt32 threadID)
+{
+	// the first subtree is always rebuilt so that the tree improves even when the refit alone takes the whole budget
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1); i < descriptor->m_count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1)) {
+		if (i && (dgGetTimeInNanoseconds() > descriptor->m_deadline)) {
+			break;
+		}
+		RebuildSubtree (descriptor->m_nodes[i], threadID);
+	}
+}
+
+void dgBroadPhase::RebuildSubtree (dgNode* const root, dgInt32 threadID)
+{
+	const dgInt32 leafCount = root->m_leafCount;
+	dgNode** const leafs = (dgNode**) m_world->m_frameArena.Alloc (leafCount * sizeof (dgNode*), threadID);
+	dgNode** const nodes = (dgNode**) m_world->m_frameArena.Alloc (leafCount * sizeof (dgNode*), threadID);
+	dgNode** const stackPool = (dgNode**) m_world->m_frameArena.Alloc (leafCount * sizeof (dgNode*), threadID);
+
+	dgInt32 stack = 1;
+	dgInt32 leafsCount = 0;
+	dgInt32 nodesCount = 0;
+	stackPool[0] = root;
+	while (stack) {
+		stack --;
+		dgNode* const node = stackPool[stack];
+		if (node->m_body) {
+			leafs[leafsCount] = node;
+			leafsCount ++;
+		} else {
+			nodes[nodesCount] = node;
+			nodesCount ++;
+			stackPool[stack] = node->m_left;
+			stack ++;
+			stackPool[stack] = node->m_right;
+			stack ++;
+			dgAssert (stack <= leafCount);
+		}
+	}
+	dgAssert (leafsCount == leafCount);
+	dgAssert (nodesCount == (leafCount - 1));
+
+	// the new subtree covers the same leafs, so the boxes of the nodes above do not change. 
+	// sibling subtrees can be swapped in at the same time since each one writes a different side of the parent
+	dgNode* const parent = root->m_parent;
+	const bool isLeft = parent && (parent->m_left == root);
+
+	dgInt32 index = 0;
+	dgNode* const newRoot = BuildBinned (leafs, leafsCount, nodes, index);
+	dgAssert (index == nodesCount);
+
+	newRoot->m_parent = parent;
+	if (!parent) {
+		m_rootNode = newRoot;
+	} else if (isLeft) {
+		parent->m_left = newRoot;
+	} else {
+		parent->m_right = newRoot;
+	}
+}
+
+dgInt32 dgBroadPhase::SplitBinned (dgNode** const primitives, dgInt32 count, dgVector& minBox, dgVector& maxBox) const
+{
+	dgAssert (count > 1);
+	dgInt32 largest = 0;
+	minBox = primitives[0]->m_minBox;
+	maxBox = primitives[0]->m_maxBox;
+	dgVector minCenter (primitives[0]->m_minBox + primitives[0]->m_maxBox);
+	dgVector maxCenter (minCenter);
+	for (dgInt32 i = 1; i < count; i ++) {
+		const dgNode* const node = primitives[i];
+		dgVector center (node->m_minBox + node->m_maxBox);
+		minBox = minBox.GetMin (node->m_minBox);
+		maxBox = maxBox.GetMax (node->m_maxBox);
+		minCenter = minCenter.GetMin (center);
+		maxCenter = maxCenter.GetMax (center);
+		if (node->m_surfaceArea > primitives[largest]->m_surfaceArea) {
+			largest = i;
+		}
+	}
+
+	dgInt32 split = 1;
+	if (count > 2) {
+		// a box much larger than the rest, like the floor, lands in a bin with the small boxes next to its center, 
+		// so splitting it off by itself is also a candidate
+		dgVector p0 (dgFloat32 (1.0e15f));
+		dgVector p1 (dgFloat32 (-1.0e15f));
+		for (dgInt32 i = 0; i < count; i ++) {
+			if (i != largest) {
+				p0 = p0.GetMin (primitives[i]->m_minBox);
+				p1 = p1.GetMax (primitives[i]->m_maxBox);
+			}
+		}
+		dgVector restSide (p1 - p0);
+		dgFloat32 bestCost = primitives[largest]->m_surfaceArea + restSide.DotProduct4(restSide.ShiftTripleRight()).m_x * (count - 1);
+
+		// bin the box centers along the longest axis and take the bin boundary with the lowest surface area heuristic
+		dgInt32 bestBin = -1;
+		dgVector extend (maxCenter - minCenter);
+		dgInt32 axis = (extend.m_x >= extend.m_y) ? ((extend.m_x >= extend.m_z) ? 0 : 2) : ((extend.m_y >= extend.m_z) ? 1 : 2);
+		const dgFloat32 origin = minCenter[axis];
+		const dgFloat32 scale = (extend[axis] > dgFloat32 (1.0e-6f)) ? dgFloat32 (DG_BROADPHASE_SAH_BINS) * dgFloat32 (0.999f) / extend[axis] : dgFloat32 (0.0f);
+		if (scale > dgFloat32 (0.0f)) {
+			dgInt32 binCount[DG_BROADPHASE_SAH_BINS];
+			dgVector binMin[DG_BROADPHASE_SAH_BINS];
+			dgVector binMax[DG_BROADPHASE_SAH_BINS];
+			for (dgInt32 i = 0; i < DG_BROADPHASE_SAH_BINS; i ++) {
+				binCount[i] = 0;
+				binMin[i] = dgVector (dgFloat32 (1.0e15f));
+				binMax[i] = dgVector (dgFloat32 (-1.0e15f));
+			}
+
+			for (dgInt32 i = 0; i < count; i ++) {
+				const dgNode* const node = primitives[i];
+				dgInt32 bin = dgInt32 ((node->m_minBox[axis] + node->m_maxBox[axis] - origin) * scale);
+				bin = dgClamp (bin, 0, DG_BROADPHASE_SAH_BINS - 1);
+				binCount[bin] ++;
+				binMin[bin] = binMin[bin].GetMin (node->m_minBox);
+				binMax[bin] = binMax[bin].GetMax (node->m_maxBox);
+			}
+
+			dgInt32 rightCount[DG_BROADPHASE_SAH_BINS];
+			dgFloat32 rightArea[DG_BROADPHASE_SAH_BINS];
+			p0 = dgVector (dgFloat32 (1.0e15f));
+			p1 = dgVector (dgFloat32 (-1.0e15f));
+			dgInt32 accumulated = 0;
+			for (dgInt32 i = DG_BROADPHASE_SAH_BINS - 1; i > 0; i --) {
+				p0 = p0.GetMin (binMin[i]);
+				p1 = p1.GetMax (binMax[i]);
+				accumulated += binCount[i];
+				dgVector side (p1 - p0);
+				rightCount[i] = accumulated;
+				rightArea[i] = accumulated ? side.DotProduct4(side.ShiftTripleRight()).m_x : dgFloat32 (0.0f);
+			}
+
+			p0 = dgVector (dgFloat32 (1.0e15f));
+			p1 = dgVector (dgFloat32 (-1.0e15f));
+			accumulated = 0;
+			for (dgInt32 i = 0; i < DG_BROADPHASE_SAH_BINS - 1; i ++) {
+				p0 = p0.GetMin (binMin[i]);
+				p1 = p1.GetMax (binMax[i]);
+				accumulated += binCount[i];
+				if (accumulated && rightCount[i + 1]) {
+					dgVector side (p1 - p0);
+					dgFloat32 cost = side.DotProduct4(side.ShiftTripleRight()).m_x * accumulated + rightArea[i + 1] * rightCount[i + 1];
+					if (cost < bestCost) {
+						bestCost = cost;
+						bestBin = i;
+					}
+				}
+			}
+		}
+
+		if (bestBin >= 0) {
+			dgInt32 i0 = 0;
+			dgInt32 i1 = count - 1;
+			while (i0 <= i1) {
+				const dgNode* const node = primitives[i0];
+				dgInt32 bin = dgInt32 ((node->m_minBox[axis] + node->m_maxBox[axis] - origin) * scale);
+				if (dgClamp (bin, 0, DG_BROADPHASE_SAH_BINS - 1) <= bestBin) {
+					i0 ++;
+				} else {
+					dgSwap (primitives[i0], primitives[i1]);
+					i1 --;
+				}
+			}
+			split = i0;
+			dgAssert ((split > 0) && (split < count));
+		} else {
+			dgSwap (primitives[0], primitives[largest]);
+		}
+	}
+
+	return split;
+}
+
+dgBroadPhase::dgNode* dgBroadPhase::BuildBinned (dgNode** const primitives, dgInt32 count, dgNode** const internalNodes, dgInt32& index) const
+{
+	if (count == 1) {
+		return primitives[0];
+	}
+
+	dgVector minBox;
+	dgVector maxBox;
+	const dgInt32 split = SplitBinned (primitives, count, minBox, maxBox);
+
+	dgNode* const parent = internalNodes[index];
+	index ++;
+
+	dgNode* const left = BuildBinned (primitives, split, internalNodes, index);
+	dgNode* const right = BuildBinned (&primitives[split], count - split, internalNodes, index);
+	parent->m_left = left;
+	parent->m_right = right;
+	left->m_parent = parent;
+	right->m_parent = parent;
+
+	dgVector side (maxBox - minBox);
+	parent->m_minBox = minBox;
+	parent->m_maxBox = maxBox;
+	parent->m_surfaceArea = side.DotProduct4(side.ShiftTripleRight()).m_x;
+	parent->m_leafCount = left->m_leafCount + right->m_leafCount;
+	parent->m_subtreeCost = parent->m_surfaceArea + left->m_subtreeCost + right->m_subtreeCost;
+	parent->m_buildCost = parent->m_subtreeCost;
+	return parent;
+}
+
+dgBroadPhase::dgNode* dgBroadPhase::BuildBinnedTop (dgNode** const primitives, dgInt32 count, dgNode** const internalNodes, dgInt32& index, dgNode* const parent, bool isLeft, dgInt32 jobLeafs, dgBroadphaseBuildJob* const jobs, dgInt32& jobsCount, dgNode** const topNodes, dgInt32& topCount) const
+{
+	if (count <= jobLeafs) {
+		// the job builds this range into the next count - 1 internal nodes and links it to the parent
+		dgBroadphaseBuildJob& job = jobs[jobsCount];
+		job.m_primitives = primitives;
+		job.m_internalNodes = &internalNodes[index];
+		job.m_parent = parent;
+		job.m_count = count;
+		job.m_isLeft = isLeft;
+		jobsCount ++;
+		index += count - 1;
+		return NULL;
+	}
+
+	dgVector minBox;
+	dgVector maxBox;
+	const dgInt32 split = SplitBinned (primitives, count, minBox, maxBox);
+
+	dgNode* const node = internalNodes[index];
+	index ++;
+	topNodes[topCount] = node;
+	topCount ++;
+
+	dgVector side (maxBox - minBox);
+	node->m_parent = parent;
+	node->m_minBox = minBox;
+	node->m_maxBox = maxBox;
+	node->m_surfaceArea = side.DotProduct4(side.ShiftTripleRight()).m_x;
+	node->m_leafCount = count;
+	node->m_left = BuildBinnedTop (primitives, split, internalNodes, index, node, true, jobLeafs, jobs, jobsCount, topNodes, topCount);
+	node->m_right = BuildBinnedTop (&primitives[split], count - split, internalNodes, index, node, false, jobLeafs, jobs, jobsCount, topNodes, topCount);
+	return node;
+}
+
+dgBroadPhase::dgNode* dgBroadPhase::BuildBinnedParallel (dgNode** const primitives, dgInt32 count, dgNode** const internalNodes)
+{
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	if ((threadsCount == 1) || (count < DG_BROADPHASE_PARALLEL_BUILD_LEAFS)) {
+		dgInt32 index = 0;
+		return BuildBinned (primitives, count, internalNodes, index);
+	}
+
+	// split the top levels on this thread until the ranges are small enough to give each thread a few of them, 
+	// every range owns its own slice of the internal nodes so the jobs do not share any data
+	const dgInt32 jobLeafs = dgMax (count / (threadsCount * 4), DG_BROADPHASE_PARALLEL_BUILD_LEAFS / 4);
+	dgAssert (jobLeafs < count);
+	const dgInt32 maxJobs = 2 * count / jobLeafs + 2;
+	dgBroadphaseBuildJob* const jobs = (dgBroadphaseBuildJob*) m_world->m_frameArena.Alloc (maxJobs * sizeof (dgBroadphaseBuildJob));
+	dgNode** const topNodes = (dgNode**) m_world->m_frameArena.Alloc (maxJobs * sizeof (dgNode*));
+
+	dgInt32 index = 0;
+	dgInt32 jobsCount = 0;
+	dgInt32 topCount = 0;
+	dgNode* const root = BuildBinnedTop (primitives, count, internalNodes, index, NULL, true, jobLeafs, jobs, jobsCount, topNodes, topCount);
+	dgAssert (root);
+	dgAssert (index == (count - 1));
+	dgAssert (jobsCount <= maxJobs);
+
+	dgBroadphaseBuildDescriptor descriptor (jobs, jobsCount);
+	for (dgInt32 i = 0; i < threadsCount; i ++) {
+		m_world->QueueJob (BuildBinnedKernel, &descriptor, m_world);
+	}
+	m_world->SynchronizationBarrier();
+
+	// the top nodes were made parents first, so going backward the children costs are always ready
+	for (dgInt32 i = topCount - 1; i >= 0; i --) {
+		dgNode* const node = topNodes[i];
+		node->m_subtreeCost = node->m_surfaceArea + node->m_left->m_subtreeCost + node->m_right->m_subtreeCost;
+		node->m_buildCost = node->m_subtreeCost;
+	}
+	root->m_parent = NULL;
+	return root;
+}
+
+void dgBroadPhase::BuildBinnedKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBroadphaseBuildDescriptor* const descriptor = (dgBroadphaseBuildDescriptor*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "BuildBinnedKernel", threadID);
+
+	const dgBroadPhase* const broadPhase = world->GetBroadPhase();
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1); i < descriptor->m_count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1)) {
+		dgBroadphaseBuildJob& job = descriptor->m_jobs[i];
+		dgInt32 index = 0;
+		dgNode* const node = broadPhase->BuildBinned (job.m_primitives, job.m_count, job.m_internalNodes, index);
+		dgAssert (index == (job.m_count - 1));
+		node->m_parent = job.m_parent;
+		if (job.m_isLeft) {
+			job.m_parent->m_left = node;
+		} else {
+			job.m_parent->m_right = node;
+		}
+	}
+}
+
+void dgBroadPhase::InsertLeafs (dgNode** const leafs, dgInt32 count, bool isStatic)
+{
+	dgNode*& root = isStatic ? m_staticRootNode : m_rootNode;
+	dgFitnessList& fitness = isStatic ? m_staticFitness : m_fitness;
+
+	dgNode** const nodes = (dgNode**) m_world->m_frameArena.Alloc ((count + 1) * sizeof (dgNode*));
+	for (dgInt32 i = 0; i < count; i ++) {
+		leafs[i]->m_isStatic = isStatic;
+	}
+	for (dgInt32 i = 0; i < count - 1; i ++) {
+		dgNode* const node = new (m_world->GetAllocator()) dgNode (NULL, dgVector (dgFloat32 (0.0f)), dgVector (dgFloat32 (0.0f)));
+		node->m_fitnessNode = fitness.Append (node);
+		nodes[i] = node;
+	}
+
+	// build the new bodies in a subtree of their own and graft it where a single body with its box would go
+	dgNode* const subtree = BuildBinnedParallel (leafs, count, nodes);
+	if (!root) {
+		root = subtree;
+	} else {
+		dgNode* const node = InsertNode (root, subtree, fitness);
+		if (!node->m_parent) {
+			root = node;
+		}
+	}
+}
+
+void dgBroadPhase::AddBodies (dgBody** const bodies, dgInt32 count)
+{
+	if (!count) {
+		return;
+	}
+
+	m_queryStamp ++;
+	m_wideTreeBuilt = false;
+	m_wideTreeFitted = false;
+
+	// static bodies go to the front of the array and dynamic bodies to the back
+	dgNode** const leafs = (dgNode**) m_world->m_frameArena.Alloc (count * sizeof (dgNode*));
+	dgInt32 staticCount = 0;
+	dgInt32 dynamicIndex = count;
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgNode* const leaf = new (m_world->GetAllocator()) dgNode (bodies[i]);
+		if (IsStaticBody (bodies[i])) {
+			leafs[staticCount] = leaf;
+			staticCount ++;
+		} else {
+			dynamicIndex --;
+			leafs[dynamicIndex] = leaf;
+		}
+	}
+
+	if (staticCount) {
+		m_staticTreeChanged = true;
+		InsertLeafs (leafs, staticCount, true);
+	}
+	if (staticCount < count) {
+		m_fitnessArrayDirty = true;
+		InsertLeafs (&leafs[staticCount], count - staticCount, false);
+		// the grafted subtree is already well built, take the new tree as the reference so that it is not rebuilt again on the next update
+		m_treeEntropy = m_fitness.TotalCost();
+	}
+
+	if (!m_world->m_inUpdate) {
+		m_world->m_frameArena.Reset();
+	}
+}
+
+void dgBroadPhase::RemoveBodies (dgBody** const bodies, dgInt32 count)
+{
+	m_queryStamp ++;
+	m_removeStamp ++;
+
+	// the static tree is rebuilt by the update when it degrades, so static bodies are always unlinked one at the time
+	dgBody** const dynamicBodies = (dgBody**) m_world->m_frameArena.Alloc ((count + 1) * sizeof (dgBody*));
+	dgInt32 dynamicCount = 0;
+	for (dgInt32 i = 0; i < count; i ++) {
+		if (bodies[i]->m_collisionCell->m_isStatic) {
+			Remove (bodies[i]);
+		} else {
+			dynamicBodies[dynamicCount] = bodies[i];
+			dynamicCount ++;
+		}
+	}
+	RemoveDynamicBodies (dynamicBodies, dynamicCount);
+
+	if (!m_world->m_inUpdate) {
+		m_world->m_frameArena.Reset();
+	}
+}
+
+void dgBroadPhase::RemoveDynamicBodies (dgBody** const bodies, dgInt32 count)
+{
+	const dgInt32 leafsCount = m_rootNode ? m_fitness.GetCount() + 1 : 0;
+	if ((count * 2) < leafsCount) {
+		// unlinking leafs one at the time leaves most of the tree as it is
+		for (dgInt32 i = 0; i < count; i ++) {
+			Remove (bodies[i]);
+		}
+		return;
+	}
+
+	m_wideTreeBuilt = false;
+	m_wideTreeFitted = false;
+	m_fitnessArrayDirty = true;
+
+	// when most bodies go away rebuild the tree from the remaining leafs, first cut the leafs of the removed bodies off their parents
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgNode* const node = bodies[i]->m_collisionCell;
+		dgAssert (node && !node->m_fitnessNode);
+		if (node->m_staticStateNode) {
+			m_staticStateChanges.Remove (node->m_staticStateNode);
+			node->m_staticStateNode = NULL;
+		}
+		dgNode* const parent = node->m_parent;
+		if (!parent) {
+			m_rootNode = NULL;
+		} else if (parent->m_left == node) {
+			parent->m_left = NULL;
+		} else {
+			dgAssert (parent->m_right == node);
+			parent->m_right = NULL;
+		}
+		delete node;
+	}
+
+	const dgInt32 remainCount = leafsCount - count;
+	dgNode** const leafs = (dgNode**) m_world->m_frameArena.Alloc ((remainCount + 1) * sizeof (dgNode*));
+	dgNode** const nodes = (dgNode**) m_world->m_frameArena.Alloc ((remainCount + 1) * sizeof (dgNode*));
+	dgInt32 remainLeafs = 0;
+	for (dgFitnessList::dgListNode* nodePtr = m_fitness.GetFirst(); nodePtr; nodePtr = nodePtr->GetNext()) {
+		dgNode* const node = nodePtr->GetInfo();
+		if (node->m_left && node->m_left->m_body) {
+			leafs[remainLeafs] = node->m_left;
+			remainLeafs ++;
+		}
+		if (node->m_right && node->m_right->m_body) {
+			leafs[remainLeafs] = node->m_right;
+			remainLeafs ++;
+		}
+		node->m_left = NULL;
+		node->m_right = NULL;
+	}
+	if (m_rootNode && m_rootNode->m_body) {
+		leafs[remainLeafs] = m_rootNode;
+		remainLeafs ++;
+	}
+	dgAssert (remainLeafs == remainCount);
+
+	// one internal node goes away with each leaf
+	dgInt32 nodesCount = 0;
+	for (dgFitnessList::dgListNode* nodePtr = m_fitness.GetFirst(); nodePtr; ) {
+		dgNode* const node = nodePtr->GetInfo();
+		nodePtr = nodePtr->GetNext();
+		if (nodesCount < (remainCount - 1)) {
+			nodes[nodesCount] = node;
+			nodesCount ++;
+		} else {
+			m_fitness.Remove (node->m_fitnessNode);
+			delete node;
+		}
+	}
+
+	m_rootNode = NULL;
+	if (remainCount) {
+		m_rootNode = BuildBinnedParallel (leafs, remainCount, nodes);
+		m_rootNode->m_parent = NULL;
+	}
+	m_treeEntropy = m_fitness.TotalCost();
+}
+
+void dgBroadPhase::UpdateStaticTree ()
+{
+	// bodies that changed mass, or kinematic bodies that started or stopped moving, were flagged by their setters and move to the other tree.
+	// the setters can run on several threads, so the bodies are moved in the order of their unique id and the tree does not depend on the thread count
+	const dgInt32 changedCount = m_staticStateChanges.GetCount();
+	if (changedCount) {
+		dgBody** const changedBodies = (dgBody**) m_world->m_frameArena.Alloc (changedCount * sizeof (dgBody*));
+		dgInt32 count = 0;
+		for (dgList<dgNode*>::dgListNode* node = m_staticStateChanges.GetFirst(); node; node = node->GetNext()) {
+			dgNode* const leaf = node->GetInfo();
+			leaf->m_staticStateNode = NULL;
+			changedBodies[count] = leaf->m_body;
+			count ++;
+		}
+		m_staticStateChanges.RemoveAll();
+		dgSort (changedBodies, count, CompareBodiesUniqueID);
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgBody* const body = changedBodies[i];
+			if (body->m_collisionCell->m_isStatic != IsStaticBody (body)) {
+				Remove (body);
+				Add (body);
+			}
+		}
+	}
+
+	if (!m_staticTreeChanged || !m_staticRootNode || m_staticRootNode->m_body) {
+		return;
+	}
+	m_staticTreeChanged = false;
+
+	// the static tree is never rotated, rebuild it only when its cost drifts far from the last build
+	const dgFloat64 cost = m_staticFitness.TotalCost();
+	if ((m_staticBuildCost > dgFloat64 (0.0f)) && (cost < m_staticBuildCost * dgFloat64 (2.0f)) && (cost > m_staticBuildCost * dgFloat64 (0.5f))) {
+		return;
+	}
+
+	m_wideTreeBuilt = false;
+	m_wideTreeFitted = false;
+
+	const dgInt32 leafsCount = m_staticFitness.GetCount() + 1;
+	dgNode** const leafs = (dgNode**) m_world->m_frameArena.Alloc (leafsCount * sizeof (dgNode*));
+	dgNode** const nodes = (dgNode**) m_world->m_frameArena.Alloc (leafsCount * sizeof (dgNode*));
+	dgInt32 index = 0;
+	dgInt32 nodesCount = 0;
+	for (dgFitnessList::dgListNode* nodePtr = m_staticFitness.GetFirst(); nodePtr; nodePtr = nodePtr->GetNext()) {
+		dgNode* const node = nodePtr->GetInfo();
+		if (node->m_left->m_body) {
+			leafs[index] = node->m_left;
+			index ++;
+		}
+		if (node->m_right->m_body) {
+			leafs[index] = node->m_right;
+			index ++;
+		}
+		nodes[nodesCount] = node;
+		nodesCount ++;
+	}
+	for (dgInt32 i = 0; i < nodesCount; i ++) {
+		nodes[i]->m_left = NULL;
+		nodes[i]->m_right = NULL;
+	}
+	dgAssert (index == leafsCount);
+
+	m_staticRootNode = BuildBinnedParallel (leafs, leafsCount, nodes);
+	m_staticRootNode->m_parent = NULL;
+	m_staticBuildCost = m_staticFitness.TotalCost();
+}
+
+void dgBroadPhase::BuildWideTree ()
+{
+	m_wideNodesCount = 0;
+	m_wideLeafsCount = 0;
+	if (m_rootNode || m_staticRootNode) {
+		// collapse the tree breadth first, each wide node takes the four largest descendants of its tree node, 
+		// so children are always stored after their parent
+		// when both trees exist the root wide node has no source and starts with the two tree roots as its children
+		m_wideNodes[0].Init ((m_rootNode && m_staticRootNode) ? NULL : (m_rootNode ? m_rootNode : m_staticRootNode));
+		m_wideNodesCount = 1;
+		for (dgInt32 i = 0; i < m_wideNodesCount; i ++) {
+			dgNode* children[4];
+			dgInt32 count = 0;
+			dgNode* const source = m_wideNodes[i].m_source;
+			if (source && source->m_body) {
+				children[0] = source;
+				count = 1;
+			} else {
+				children[0] = source ? source->m_left : m_rootNode;
+				children[1] = source ? source->m_right : m_staticRootNode;
+				count = 2;
+				while (count < 4) {
+					dgInt32 index = -1;
+					dgFloat32 maxArea = dgFloat32 (-1.0f);
+					for (dgInt32 j = 0; j < count; j ++) {
+						if (!children[j]->m_body && (children[j]->m_surfaceArea > maxArea)) {
+							index = j;
+							maxArea = children[j]->m_surfaceArea;
+						}
+					}
+					if (index < 0) {
+						break;
+					}
+					dgNode* const node = children[index];
+					children[index] = node->m_left;
+					children[count] = node->m_right;
+					count ++;
+				}
+			}
+
+			// the array can grow while adding the children, do not hold references to the nodes
+			for (dgInt32 j = 0; j < count; j ++) {
+				dgNode* const child = children[j];
+				if (child->m_body) {
+					m_wideLeafs[m_wideLeafsCount] = child;
+					m_wideNodes[i].m_child[j] = -(m_wideLeafsCount + 1);
+					m_wideLeafsCount ++;
+				} else {
+					m_wideNodes[m_wideNodesCount].Init (child);
+					m_wideNodes[i].m_child[j] = m_wideNodesCount;
+					m_wideNodesCount ++;
+				}
+			}
+			m_wideNodes[i].m_count = count;
+		}
+	}
+
+	m_wideTreeBuilt = true;
+	m_wideTreeFitted = false;
+	RefitWideTree ();
+}
+
+void dgBroadPhase::RefitWideTree ()
+{
+	if (m_wideTreeBuilt && !m_wideTreeFitted) {
+		// children are after their parent, one backward pass refits the whole tree
+		dgWideNode* const nodes = &m_wideNodes[0];
+		dgNode* const* const leafs = &m_wideLeafs[0];
+		for (dgInt32 i = m_wideNodesCount - 1; i >= 0; i --) {
+			dgWideNode& node = nodes[i];
+			for (dgInt32 j = 0; j < node.m_count; j ++) {
+				const dgInt32 child = node.m_child[j];
+				if (child < 0) {
+					const dgNode* const leaf = leafs[-1 - child];
+					node.SetBox (j, leaf->m_minBox, leaf->m_maxBox);
+				} else {
+					dgVector minBox;
+					dgVector maxBox;
+					nodes[child].GetBox (minBox, maxBox);
+					node.SetBox (j, minBox, maxBox);
+				}
+			}
+		}
+		m_wideTreeFitted = true;
+	}
+}
+
+
+void dgBroadPhase::AddPair (dgBody* const body0, dgBody* const body1, const dgVector& timestep2, dgInt32 threadID)
+{
+	dgAssert ((body0->GetInvMass().m_w != dgFloat32 (0.0f)) || (body1->GetInvMass().m_w != dgFloat32 (0.0f)) || (body0->IsRTTIType(dgBody::m_kinematicBodyRTTI | dgBody::m_deformableBodyRTTI)) || (body1->IsRTTIType(dgBody::m_kinematicBodyRTTI | dgBody::m_deformableBodyRTTI)));
+
+	// add all pairs 
+	const dgBodyMaterialList* const materialList = m_world;  
+	dgCollidingPairCollector* const contactPairs = m_world;
+
+	// the joint lists of the bodies do not change until all the pairs are found, so they are read without a lock
+	bool isCollidable = true;
+	dgContact* contact = NULL;
+	if ((body0->IsRTTIType(dgBody::m_kinematicBodyRTTI | dgBody::m_deformableBodyRTTI)) || (body0->GetInvMass().m_w != dgFloat32 (0.0f))) {
+		for (dgBodyMasterListRow::dgListNode* link = body0->m_masterNode->GetInfo().GetFirst(); link; link = link->GetNext()) {
+			dgConstraint* const constraint = link->GetInfo().m_joint;
+			if (constraint->GetId() != dgConstraint::m_contactConstraint) {
+				break;
+			}
+			if (link->GetInfo().m_bodyNode == body1) {
+				contact = (dgContact*)constraint;
+				isCollidable = true;
+				break;
+			}
+		}
+
+		for (dgBodyMasterListRow::dgListNode* link = body0->m_masterNode->GetInfo().GetLast(); link; link = link->GetPrev()) {
+			dgConstraint* const constraint = link->GetInfo().m_joint;
+			if (constraint->GetId() == dgConstraint::m_contactConstraint) {
 				break;
 			}
 			if (link->GetInfo().m_bodyNode == body1) {
@@ -861,7 +2351,6 @@ void dgBroadPhase::AddPair (dgBody* const body0, dgBody* const body1, const dgVe
 			}
 		}
 	} else {
-		dgThreadHiveScopeLock lock (m_world, &m_contacJointLock);
 		dgAssert ((body1->GetInvMass().m_w != dgFloat32 (0.0f)) || (body1->IsRTTIType(dgBody::m_kinematicBodyRTTI | dgBody::m_deformableBodyRTTI)));
 		for (dgBodyMasterListRow::dgListNode* link = body1->m_masterNode->GetInfo().GetFirst(); link; link = link->GetNext()) {
 			dgConstraint* const constraint = link->GetInfo().m_joint;
@@ -901,14 +2390,18 @@ void dgBroadPhase::AddPair (dgBody* const body0, dgBody* const body1, const dgVe
 
 			if (material->m_flags & dgContactMaterial::m_collisionEnable) {
 				newContact = true;
-				dgThreadHiveScopeLock lock (m_world, &m_contacJointLock);
 				if (body0->IsRTTIType (dgBody::m_deformableBodyRTTI) || body1->IsRTTIType (dgBody::m_deformableBodyRTTI)) {
 					contact = new (m_world->m_allocator) dgDeformableContact (m_world, material);
 				} else {
 					contact = new (m_world->m_allocator) dgContact (m_world, material);
 				}
-				contact->AppendToActiveList();
-				m_world->AttachConstraint (contact, body0, body1);
+
+				// the narrow phase only needs the bodies, AttachNewContacts links the contact to the body graph later
+				contact->m_body0 = body0;
+				contact->m_body1 = body1;
+				dgArray<dgContact*>& newContacts = *m_newContacts[threadID];
+				newContacts[m_newContactsCount[threadID]] = contact;
+				m_newContactsCount[threadID] ++;
 			}
 		}
 
@@ -1028,20 +2521,36 @@ void dgBroadPhase::KinematicBodyActivation (dgContact* const contatJoint) const
 	}
 }
 
-void dgBroadPhase::CalculatePairContacts (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID)
+void dgBroadPhase::CalculatePairContacts (dgBroadphaseSyncDescriptor* const descriptor, dgBroadphasePairSlot* const slot, dgInt32 threadID)
 {
 	dgContactPoint contacts[DG_MAX_CONTATCS];
 	
 	dgFloat32 timestep = descriptor->m_timestep;
 	dgCollidingPairCollector* const pairCollector = m_world;
-	const dgInt32 count = pairCollector->m_count;
-	dgCollidingPairCollector::dgPair* const pairs = (dgCollidingPairCollector::dgPair*) &m_world->m_pairMemoryBuffer[0];
 
-	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_pairsAtomicCounter, 1); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_pairsAtomicCounter, 1)) {
+	dgInt32 count = pairCollector->m_count;
+	dgInt32* atomicCounter = &descriptor->m_pairsAtomicCounter;
+	dgArray<dgUnsigned8>* pairBuffer = &m_world->m_pairMemoryBuffer;
+	if (slot) {
+		count = pairCollector->m_slotPairsCount[slot->m_slot];
+		atomicCounter = &slot->m_pairsAtomicCounter;
+		pairBuffer = m_world->m_pairSlotMemory[slot->m_slot];
+		if (!count) {
+			// do not touch an empty slot buffer, reading it may allocate
+			return;
+		}
+	}
+	dgCollidingPairCollector::dgPair* const pairs = (dgCollidingPairCollector::dgPair*) &(*pairBuffer)[0];
+
+	dgInt32 pairsCount = 0;
+	dgInt32 contactsCount = 0;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicCounter, 1); i < count; i = dgAtomicExchangeAndAdd(atomicCounter, 1)) {
 		dgCollidingPairCollector::dgPair* const pair = &pairs[i];
 		pair->m_cacheIsValid = false;
 		pair->m_contactBuffer = contacts;
 		m_world->CalculateContacts (pair, timestep, threadID, false, false);
+		pairsCount ++;
+		contactsCount += pair->m_contactCount;
 
 		if (pair->m_contactCount) {
 			dgAssert (pair->m_contactCount <= (DG_CONSTRAINT_MAX_ROWS / 3));
@@ -1060,6 +2569,10 @@ void dgBroadPhase::CalculatePairContacts (dgBroadphaseSyncDescriptor* const desc
 			}
 		}
 	}
+
+	dgInt32* const counts = m_world->m_counters.m_counts[threadID];
+	counts[m_pairsTestedCount] += pairsCount;
+	counts[m_contactPointsCount] += contactsCount;
 }
 
 
@@ -1068,26 +2581,49 @@ void dgBroadPhase::CalculatePairContacts (dgBroadphaseSyncDescriptor* const desc
 
 void dgBroadPhase::UpdateBodyBroadphase(dgBody* const body, dgInt32 threadIndex)
 {
-	if (m_rootNode) {
-
-		dgNode* const node = body->m_collisionCell;
+	dgNode* const node = body->m_collisionCell;
+	if (node) {
 		dgAssert (!node->m_left);
 		dgAssert (!node->m_right);
 
+		if (m_queryCache) {
+			if (m_world->m_inUpdate) {
+				// the cached queries are checked against the moved bodies when the update is done moving them
+				dgInt32 index = dgAtomicExchangeAndAdd (&m_movedBodiesCount, 1);
+				if (index < m_movedBodies.GetElementsCapacity()) {
+					m_movedBodies[index] = body;
+				}
+			} else {
+				dgBody* const bodyArray = body;
+				InvalidateQueryCache (&bodyArray, 1);
+			}
+		}
+
 		if (!dgBoxInclusionTest (body->m_minAABB, body->m_maxAABB, node->m_minBox, node->m_maxBox)) {
 			node->SetAABB(body->m_minAABB, body->m_maxAABB);
-			for (dgNode* parent = node->m_parent; parent; parent = parent->m_parent) {
-				dgVector minBox;
-				dgVector maxBox;
-				dgFloat32 area = CalculateSurfaceArea (parent->m_left, parent->m_right, minBox, maxBox);
-				if (dgBoxInclusionTest (minBox, maxBox, parent->m_minBox, parent->m_maxBox)) {
-					break;
+			if (m_world->m_inUpdate && !node->m_isStatic) {
+				// inside the update many threads move bodies at the same time, each one only writes its own leaf 
+				// and the parents are fit all at once after the bodies are moved, so the tree does not depend on the order the threads ran
+				if (!m_refitDeferred) {
+					dgInterlockedExchange (&m_refitDeferred, 1);
 				}
-
+			} else {
 				dgThreadHiveScopeLock lock (m_world, &m_criticalSectionLock);
-				parent->m_minBox = minBox;
-				parent->m_maxBox = maxBox;
-				parent->m_surfaceArea = area;
+				m_wideTreeFitted = false;
+				if (node->m_isStatic) {
+					m_staticTreeChanged = true;
+				}
+				for (dgNode* parent = node->m_parent; parent; parent = parent->m_parent) {
+					dgVector minBox;
+					dgVector maxBox;
+					dgFloat32 area = CalculateSurfaceArea (parent->m_left, parent->m_right, minBox, maxBox);
+					if (dgBoxInclusionTest (minBox, maxBox, parent->m_minBox, parent->m_maxBox)) {
+						break;
+					}
+					parent->m_minBox = minBox;
+					parent->m_maxBox = maxBox;
+					parent->m_surfaceArea = area;
+				}
 			}
 		}
 	}
@@ -1098,6 +2634,8 @@ void dgBroadPhase::ForceAndToqueKernel (void* const context, void* const worldCo
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "ForceAndToqueKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_forceCallbackTicks, threadID);
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
 
 	if (!threadID) {
@@ -1113,12 +2651,16 @@ void dgBroadPhase::CollidingPairsKernel (void* const context, void* const worldC
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "CollidingPairsKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_broadPhaceTicks, threadID);
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
 
 	if (!threadID) {
 		dgUnsigned32 ticks0 = world->m_getPerformanceCount();
 		if (descriptor->m_broadPhaseType == dgBroadPhase::m_generic) {
 			broadPhase->FindCollidingPairsGeneric (descriptor, threadID);
+		} else if (descriptor->m_broadPhaseType == dgBroadPhase::m_wide) {
+			broadPhase->FindCollidingPairsWide (descriptor, threadID);
 		} else {
 			broadPhase->FindCollidingPairsPersistent (descriptor, threadID);
 		}
@@ -1126,6 +2668,8 @@ void dgBroadPhase::CollidingPairsKernel (void* const context, void* const worldC
 	} else {
 		if (descriptor->m_broadPhaseType == dgBroadPhase::m_generic) {
 			broadPhase->FindCollidingPairsGeneric (descriptor, threadID);
+		} else if (descriptor->m_broadPhaseType == dgBroadPhase::m_wide) {
+			broadPhase->FindCollidingPairsWide (descriptor, threadID);
 		} else {
 			broadPhase->FindCollidingPairsPersistent (descriptor, threadID);
 		}
@@ -1136,14 +2680,16 @@ void dgBroadPhase::UpdateContactsKernel (void* const context, void* const worldC
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "UpdateContactsKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_narrowPhaseTicks, threadID);
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
 
 	if (!threadID) {
 		dgUnsigned32 ticks0 = world->m_getPerformanceCount();
-		broadPhase->CalculatePairContacts (descriptor, threadID);
+		broadPhase->CalculatePairContacts (descriptor, NULL, threadID);
 		world->m_perfomanceCounters[m_narrowPhaseTicks] = world->m_getPerformanceCount() - ticks0;
 	} else {
-		broadPhase->CalculatePairContacts (descriptor, threadID);
+		broadPhase->CalculatePairContacts (descriptor, NULL, threadID);
 	}
 }
 
@@ -1152,6 +2698,8 @@ void dgBroadPhase::AddGeneratedBodyesContactsKernel (void* const context, void*
 {
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "AddGeneratedBodyesContactsKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_broadPhaceTicks, threadID);
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
 
 	if (!threadID) {
@@ -1164,6 +2712,48 @@ void dgBroadPhase::AddGeneratedBodyesContactsKernel (void* const context, void*
 }
 
 
+void dgBroadPhase::CollidingPairsSlotKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBroadphasePairSlot* const slot = (dgBroadphasePairSlot*) context;
+	dgBroadphaseSyncDescriptor* const descriptor = slot->m_descriptor;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "CollidingPairsSlotKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_broadPhaceTicks, threadID);
+	dgBroadPhase* const broadPhase = world->GetBroadPhase();
+	dgCollidingPairCollector* const contactPairs = world;
+
+	// pairs found by this job go to the slot buffer, the narrow phase jobs of this slot start as soon as the job is done
+	dgUnsigned32 ticks0 = world->m_getPerformanceCount();
+	contactPairs->m_threadPairSlot[threadID] = slot->m_slot;
+	if (descriptor->m_broadPhaseType == dgBroadPhase::m_generic) {
+		broadPhase->FindCollidingPairsGeneric (descriptor, threadID);
+	} else if (descriptor->m_broadPhaseType == dgBroadPhase::m_wide) {
+		broadPhase->FindCollidingPairsWide (descriptor, threadID);
+	} else {
+		broadPhase->FindCollidingPairsPersistent (descriptor, threadID);
+	}
+	contactPairs->m_threadPairSlot[threadID] = -1;
+	if (!threadID) {
+		world->m_perfomanceCounters[m_broadPhaceTicks] += (world->m_getPerformanceCount() - ticks0);
+	}
+}
+
+void dgBroadPhase::UpdateContactsSlotKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBroadphasePairSlot* const slot = (dgBroadphasePairSlot*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "UpdateContactsSlotKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_narrowPhaseTicks, threadID);
+	dgBroadPhase* const broadPhase = world->GetBroadPhase();
+
+	dgUnsigned32 ticks0 = world->m_getPerformanceCount();
+	broadPhase->CalculatePairContacts (slot->m_descriptor, slot, threadID);
+	if (!threadID) {
+		world->m_perfomanceCounters[m_narrowPhaseTicks] += (world->m_getPerformanceCount() - ticks0);
+	}
+}
+
+
 bool dgBroadPhase::TestOverlaping (const dgBody* const body0, const dgBody* const body1) const
 {
 	bool mass0 = (body0->m_invMass.m_w != dgFloat32 (0.0f)); 
@@ -1358,7 +2948,8 @@ void dgBroadPhase::FindCollidingPairsPersistent (dgBroadphaseSyncDescriptor* con
 	
 	for ( ;node; ) {
 		dgBody* const body = node->GetInfo().GetBody();
-		if (body->m_collisionCell) {
+		// static bodies never collide with each other, only the bodies in the dynamic tree search for pairs
+		if (body->m_collisionCell && !body->m_collisionCell->m_isStatic) {
 			if (!body->m_collision->IsType (dgCollision::dgCollisionNull_RTTI)) {
 				dgNode* const bodyNode = body->m_collisionCell;
 				for (dgNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent) {
@@ -1367,6 +2958,9 @@ void dgBroadPhase::FindCollidingPairsPersistent (dgBroadphaseSyncDescriptor* con
 						SubmitPairsPersistent (bodyNode, sibling, timestep2, threadID);
 					}
 				}
+				if (m_staticRootNode) {
+					SubmitPairsPersistent (bodyNode, m_staticRootNode, timestep2, threadID);
+				}
 			}
 		}
 
@@ -1378,6 +2972,64 @@ void dgBroadPhase::FindCollidingPairsPersistent (dgBroadphaseSyncDescriptor* con
 	}
 }
 
+void dgBroadPhase::SubmitPairsWide (dgInt32 leafIndex, const dgVector& timeStepBound, dgInt32 threadID)
+{
+	dgInt32 pool[DG_BROADPHASE_MAX_STACK_DEPTH * 2];
+	const dgWideNode* const nodes = &m_wideNodes[0];
+	dgNode* const* const leafs = &m_wideLeafs[0];
+
+	dgBody* const body0 = leafs[leafIndex]->m_body;
+	dgAssert (!body0->m_collision->IsType (dgCollision::dgCollisionNull_RTTI));
+
+	const dgVector minX (body0->m_minAABB.BroadcastX());
+	const dgVector minY (body0->m_minAABB.BroadcastY());
+	const dgVector minZ (body0->m_minAABB.BroadcastZ());
+	const dgVector maxX (body0->m_maxAABB.BroadcastX());
+	const dgVector maxY (body0->m_maxAABB.BroadcastY());
+	const dgVector maxZ (body0->m_maxAABB.BroadcastZ());
+
+	pool[0] = 0;
+	dgInt32 stack = 1;
+	while (stack) {
+		stack --;
+		const dgWideNode& node = nodes[pool[stack]];
+		dgInt32 mask = node.OverlapMask (minX, minY, minZ, maxX, maxY, maxZ);
+		for (dgInt32 j = 0; mask; j ++) {
+			if (mask & 1) {
+				const dgInt32 child = node.m_child[j];
+				if (child >= 0) {
+					pool[stack] = child;
+					stack ++;
+					dgAssert (stack < dgInt32 (sizeof (pool) / sizeof (pool[0])));
+				} else {
+					// a pair of two bodies with mass is reported by the body with the lower index
+					const dgInt32 index = -1 - child;
+					dgBody* const body1 = leafs[index]->m_body;
+					if ((index > leafIndex) || ((index < leafIndex) && (body1->m_invMass.m_w == dgFloat32 (0.0f)))) {
+						if (TestOverlaping (body0, body1)) {
+							AddPair (body0, body1, timeStepBound, threadID);
+						}
+					}
+				}
+			}
+			mask >>= 1;
+		}
+	}
+}
+
+void dgBroadPhase::FindCollidingPairsWide (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID)
+{
+	dgVector timestep2 (descriptor->m_timestep * descriptor->m_timestep * dgFloat32 (4.0f));
+	dgNode* const* const leafs = &m_wideLeafs[0];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_wideLeafsAtomicCounter, 1); i < m_wideLeafsCount; i = dgAtomicExchangeAndAdd(&descriptor->m_wideLeafsAtomicCounter, 1)) {
+		// every valid pair has at least one body with mass, only those bodies search the tree
+		const dgBody* const body = leafs[i]->m_body;
+		if ((body->m_invMass.m_w != dgFloat32 (0.0f)) && !body->m_collision->IsType (dgCollision::dgCollisionNull_RTTI)) {
+			SubmitPairsWide (i, timestep2, threadID);
+		}
+	}
+}
+
 void dgBroadPhase::FindGeneratedBodiesCollidingPairs (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID)
 {
 	dgList<dgBody*>::dgListNode* node = NULL;
@@ -1395,15 +3047,24 @@ void dgBroadPhase::FindGeneratedBodiesCollidingPairs (dgBroadphaseSyncDescriptor
 		if (body->m_collisionCell) {
 			if (!body->m_collision->IsType (dgCollision::dgCollisionNull_RTTI)) {
 				dgNode* const bodyNode = body->m_collisionCell;
-				for (dgNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent) {
-					dgNode* const sibling = ptr->m_parent->m_right;
-					if (sibling != ptr) {
-						SubmitPairsPersistent (bodyNode, sibling, timestep2, threadID);
-					} else {
-						dgNode* const sibling = ptr->m_parent->m_left;
-						dgAssert (sibling);
-						dgAssert (sibling != ptr);
-						SubmitPairsPersistent (bodyNode, sibling, timestep2, threadID);
+				if (bodyNode->m_isStatic) {
+					if (m_rootNode) {
+						SubmitPairsPersistent (bodyNode, m_rootNode, timestep2, threadID);
+					}
+				} else {
+					for (dgNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent) {
+						dgNode* const sibling = ptr->m_parent->m_right;
+						if (sibling != ptr) {
+							SubmitPairsPersistent (bodyNode, sibling, timestep2, threadID);
+						} else {
+							dgNode* const sibling = ptr->m_parent->m_left;
+							dgAssert (sibling);
+							dgAssert (sibling != ptr);
+							SubmitPairsPersistent (bodyNode, sibling, timestep2, threadID);
+						}
+					}
+					if (m_staticRootNode) {
+						SubmitPairsPersistent (bodyNode, m_staticRootNode, timestep2, threadID);
 					}
 				}
 			}
@@ -1515,6 +3176,60 @@ void dgBroadPhase::FindCollidingPairsGeneric (dgBroadphaseSyncDescriptor* const
 	}
 }
 
+dgInt32 dgBroadPhase::CompareNewContacts (dgContact* const* const contactA, dgContact* const* const contactB, void* const notUsed)
+{
+	const dgInt32 idA0 = (*contactA)->m_body0->m_uniqueID;
+	const dgInt32 idA1 = (*contactA)->m_body1->m_uniqueID;
+	const dgInt32 idB0 = (*contactB)->m_body0->m_uniqueID;
+	const dgInt32 idB1 = (*contactB)->m_body1->m_uniqueID;
+	const dgUnsigned64 keyA = (dgUnsigned64 (dgMin (idA0, idA1)) << 32) + dgUnsigned64 (dgMax (idA0, idA1));
+	const dgUnsigned64 keyB = (dgUnsigned64 (dgMin (idB0, idB1)) << 32) + dgUnsigned64 (dgMax (idB0, idB1));
+	if (keyA < keyB) {
+		return -1;
+	} else if (keyA > keyB) {
+		return 1;
+	}
+	return 0;
+}
+
+void dgBroadPhase::AttachNewContacts ()
+{
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	dgInt32 count = 0;
+	for (dgInt32 i = 0; i < threadsCount; i ++) {
+		count += m_newContactsCount[i];
+	}
+	if (!count) {
+		return;
+	}
+
+	dgContact** const contacts = (dgContact**) m_world->m_frameArena.Alloc (count * sizeof (dgContact*));
+	count = 0;
+	for (dgInt32 i = 0; i < threadsCount; i ++) {
+		const dgArray<dgContact*>& newContacts = *m_newContacts[i];
+		for (dgInt32 j = 0; j < m_newContactsCount[i]; j ++) {
+			contacts[count] = newContacts[j];
+			count ++;
+		}
+		m_newContactsCount[i] = 0;
+	}
+
+	// linking in body id order makes the body graph independent of which thread found each pair, 
+	// and puts together the few pairs that were found by more than one thread
+	dgSort (contacts, count, CompareNewContacts);
+	dgContact* lastContact = NULL;
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgContact* const contact = contacts[i];
+		if (lastContact && !CompareNewContacts (&lastContact, &contact, NULL)) {
+			delete contact;
+		} else {
+			contact->AppendToActiveList();
+			m_world->AttachConstraint (contact, contact->m_body0, contact->m_body1);
+			lastContact = contact;
+		}
+	}
+}
+
 void dgBroadPhase::UpdateContactsBroadPhaseEnd ()
 {
 	// delete all non used contacts
@@ -1522,7 +3237,7 @@ void dgBroadPhase::UpdateContactsBroadPhaseEnd ()
 	dgUnsigned32 lru = m_lru;
 
 	dgActiveContacts* const contactList = m_world;
-	dgContact** const deadContacs = (dgContact**) &m_world->m_pairMemoryBuffer[0];
+	dgContact** const deadContacs = (dgContact**) m_world->m_frameArena.Alloc (contactList->GetCount() * sizeof (dgContact*));
 
 	for (dgActiveContacts::dgListNode* contactNode = contactList->GetFirst(); contactNode; contactNode = contactNode->GetNext()) {
 		dgContact* const contact = contactNode->GetInfo();
@@ -1556,22 +3271,125 @@ void dgBroadPhase::UpdateContactsBroadPhaseEnd ()
 }
 
 
-void dgBroadPhase::RayCast (const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+void dgBroadPhase::RayCast (const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+{
+	if (m_wideTreeFitted) {
+		RayCastWide (l0, l1, filter, prefilter, userData);
+	} else if (filter && (m_rootNode || m_staticRootNode)) {
+		dgVector segment (l1 - l0);
+		dgFloat32 dist2 = segment % segment;
+		if (dist2 > dgFloat32 (1.0e-8f)) {
+
+			dgFloat32 distance[DG_COMPOUND_STACK_DEPTH];
+			const dgNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+
+			dgFastRayTest ray (l0, l1);
+
+			dgInt32 stack = 0;
+			const dgNode* const roots[] = {m_rootNode, m_staticRootNode};
+			for (dgInt32 i = 0; i < 2; i ++) {
+				const dgNode* const root = roots[i];
+				if (root) {
+					dgFloat32 dist = ray.BoxIntersect(root->m_minBox, root->m_maxBox);
+					dgInt32 j = stack;
+					for ( ; j && (dist > distance[j - 1]); j --) {
+						stackPool[j] = stackPool[j - 1];
+						distance[j] = distance[j - 1];
+					}
+					stackPool[j] = root;
+					distance[j] = dist;
+					stack ++;
+				}
+			}
+			
+			dgFloat32 maxParam = dgFloat32 (1.2f);
+
+			dgLineBox line;	
+			line.m_l0 = l0;
+			line.m_l1 = l1;
+
+			dgVector test (line.m_l0 <= line.m_l1);
+			line.m_boxL0 = (line.m_l0 & test) | line.m_l1.AndNot(test);
+			line.m_boxL1 = (line.m_l1 & test) | line.m_l0.AndNot(test);
+
+			const dgBody* const sentinel = m_world->GetSentinelBody();
+			while (stack) {
+				stack --;
+				dgFloat32 dist = distance[stack];
+				if (dist > maxParam) {
+					break;
+				} else {
+					const dgNode* const me = stackPool[stack];
+					dgAssert (me);
+					if (me->m_body) {
+						if (me->m_body != sentinel) {
+							dgAssert (!me->m_left);
+							dgAssert (!me->m_right);
+							dgFloat32 param = me->m_body->RayCast (line, filter, prefilter, userData, maxParam);
+							if (param < maxParam) {
+								maxParam = param;
+								if (maxParam < dgFloat32 (1.0e-8f)) {
+									break;
+								}
+							}
+						}
+					} else {
+						const dgNode* const left = me->m_left;
+						dgAssert (left);
+						dgFloat32 dist = ray.BoxIntersect(left->m_minBox, left->m_maxBox);
+						if (dist < maxParam) {
+							dgInt32 j = stack;
+							for ( ; j && (dist > distance[j - 1]); j --) {
+								stackPool[j] = stackPool[j - 1];
+								distance[j] = distance[j - 1];
+							}
+							stackPool[j] = left;
+							distance[j] = dist;
+							stack++;
+							dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (dgNode*)));
+						}
+
+						const dgNode* const right = me->m_right;
+						dgAssert (right);
+						dist = ray.BoxIntersect(right->m_minBox, right->m_maxBox);
+						if (dist < maxParam) {
+							dgInt32 j = stack;
+							for ( ; j && (dist > distance[j - 1]); j --) {
+								stackPool[j] = stackPool[j - 1];
+								distance[j] = distance[j - 1];
+							}
+							stackPool[j] = right;
+							distance[j] = dist;
+							stack++;
+							dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (dgNode*)));
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+
+
+void dgBroadPhase::RayCastWide (const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
 {
-	if (filter && m_rootNode) {
+	if (filter && m_wideNodesCount) {
 		dgVector segment (l1 - l0);
 		dgFloat32 dist2 = segment % segment;
 		if (dist2 > dgFloat32 (1.0e-8f)) {
 
-			dgFloat32 distance[DG_COMPOUND_STACK_DEPTH];
-			const dgNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+			dgFloat32 distance[DG_BROADPHASE_MAX_STACK_DEPTH * 2];
+			dgInt32 stackPool[DG_BROADPHASE_MAX_STACK_DEPTH * 2];
+			const dgWideNode* const nodes = &m_wideNodes[0];
+			dgNode* const* const leafs = &m_wideLeafs[0];
 
 			dgFastRayTest ray (l0, l1);
 
 			dgInt32 stack = 1;
-			stackPool[0] = m_rootNode;
-			distance[0] = ray.BoxIntersect(m_rootNode->m_minBox, m_rootNode->m_maxBox);
-			
+			stackPool[0] = 0;
+			distance[0] = dgFloat32 (0.0f);
+
 			dgFloat32 maxParam = dgFloat32 (1.2f);
 
 			dgLineBox line;	
@@ -1582,6 +3400,7 @@ void dgBroadPhase::RayCast (const dgVector& l0, const dgVector& l1, OnRayCastAct
 			line.m_boxL0 = (line.m_l0 & test) | line.m_l1.AndNot(test);
 			line.m_boxL1 = (line.m_l1 & test) | line.m_l0.AndNot(test);
 
+			// leafs and nodes share the stack, sorted by distance so that the closest one is always on top
 			const dgBody* const sentinel = m_world->GetSentinelBody();
 			while (stack) {
 				stack --;
@@ -1589,13 +3408,11 @@ void dgBroadPhase::RayCast (const dgVector& l0, const dgVector& l1, OnRayCastAct
 				if (dist > maxParam) {
 					break;
 				} else {
-					const dgNode* const me = stackPool[stack];
-					dgAssert (me);
-					if (me->m_body) {
-						if (me->m_body != sentinel) {
-							dgAssert (!me->m_left);
-							dgAssert (!me->m_right);
-							dgFloat32 param = me->m_body->RayCast (line, filter, prefilter, userData, maxParam);
+					const dgInt32 index = stackPool[stack];
+					if (index < 0) {
+						dgBody* const body = leafs[-1 - index]->m_body;
+						if (body != sentinel) {
+							dgFloat32 param = body->RayCast (line, filter, prefilter, userData, maxParam);
 							if (param < maxParam) {
 								maxParam = param;
 								if (maxParam < dgFloat32 (1.0e-8f)) {
@@ -1604,53 +3421,581 @@ void dgBroadPhase::RayCast (const dgVector& l0, const dgVector& l1, OnRayCastAct
 							}
 						}
 					} else {
-						const dgNode* const left = me->m_left;
-						dgAssert (left);
-						dgFloat32 dist = ray.BoxIntersect(left->m_minBox, left->m_maxBox);
-						if (dist < maxParam) {
-							dgInt32 j = stack;
-							for ( ; j && (dist > distance[j - 1]); j --) {
-								stackPool[j] = stackPool[j - 1];
-								distance[j] = distance[j - 1];
+						const dgWideNode& node = nodes[index];
+						const dgVector childDist (node.RayDistance (ray));
+						for (dgInt32 i = 0; i < node.m_count; i ++) {
+							dgFloat32 dist = childDist[i];
+							if (dist < maxParam) {
+								dgInt32 j = stack;
+								for ( ; j && (dist > distance[j - 1]); j --) {
+									stackPool[j] = stackPool[j - 1];
+									distance[j] = distance[j - 1];
+								}
+								stackPool[j] = node.m_child[i];
+								distance[j] = dist;
+								stack++;
+								dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
 							}
-							stackPool[j] = left;
-							distance[j] = dist;
-							stack++;
-							dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (dgNode*)));
 						}
+					}
+				}
+			}
+		}
+	}
+}
 
-						const dgNode* const right = me->m_right;
-						dgAssert (right);
-						dist = ray.BoxIntersect(right->m_minBox, right->m_maxBox);
-						if (dist < maxParam) {
-							dgInt32 j = stack;
-							for ( ; j && (dist > distance[j - 1]); j --) {
-								stackPool[j] = stackPool[j - 1];
-								distance[j] = distance[j - 1];
+
+void dgBroadPhase::RayCastBatch (const dgFloat32* const p0, const dgFloat32* const p1, dgInt32 strideInBytes, dgInt32 count, bool anyHit, dgRayHitInfo* const hits) const
+{
+	dgBroadphaseRayBatchDescriptor descriptor (p0, p1, strideInBytes / dgInt32 (sizeof (dgFloat32)), count, anyHit, hits);
+
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	if (m_world->m_inUpdate || (threadsCount == 1) || (count <= DG_BROADPHASE_RAY_BATCH_JOB)) {
+		// from inside the update the threads are busy with the step, the calling thread casts all the rays
+		for (dgInt32 i = 0; i < count; i += 4) {
+			RayCastPacket (&descriptor, i, dgMin (count - i, 4));
+		}
+	} else {
+		for (dgInt32 i = 0; i < threadsCount; i ++) {
+			m_world->QueueJob (RayCastBatchKernel, &descriptor, m_world);
+		}
+		m_world->SynchronizationBarrier();
+	}
+}
+
+void dgBroadPhase::RayCastBatchKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBroadphaseRayBatchDescriptor* const descriptor = (dgBroadphaseRayBatchDescriptor*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "RayCastBatchKernel", threadID);
+
+	const dgBroadPhase* const broadPhase = world->GetBroadPhase();
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_RAY_BATCH_JOB); i < descriptor->m_count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_RAY_BATCH_JOB)) {
+		const dgInt32 count = dgMin (descriptor->m_count, i + DG_BROADPHASE_RAY_BATCH_JOB);
+		for (dgInt32 j = i; j < count; j += 4) {
+			broadPhase->RayCastPacket (descriptor, j, dgMin (count - j, 4));
+		}
+	}
+}
+
+dgFloat32 dgBroadPhase::RayCastBatchFilter (const dgBody* const body, const dgCollisionInstance* const collision, const dgVector& contact, const dgVector& normal, dgInt64 collisionID, void* const userData, dgFloat32 intersetParam)
+{
+	dgRayHitInfo* const hit = (dgRayHitInfo*) userData;
+	if (intersetParam < hit->m_intersectParam) {
+		for (dgInt32 i = 0; i < 3; i ++) {
+			hit->m_point[i] = contact[i];
+			hit->m_normal[i] = normal[i];
+		}
+		hit->m_contaID = collisionID;
+		hit->m_hitBody = body;
+		hit->m_intersectParam = intersetParam;
+	}
+	return intersetParam;
+}
+
+void dgBroadPhase::RayCastPacket (dgBroadphaseRayBatchDescriptor* const descriptor, dgInt32 first, dgInt32 count) const
+{
+	// each lane of the vectors is one ray, the four rays are tested against a node box at once
+	dgLineBox lines[4];
+	const dgVector zero (dgFloat32 (0.0f));
+	dgVector originX (zero);
+	dgVector originY (zero);
+	dgVector originZ (zero);
+	dgVector invDirX (zero);
+	dgVector invDirY (zero);
+	dgVector invDirZ (zero);
+	dgVector maxT (dgFloat32 (-1.0f));
+	dgVector direction (zero);
+	dgInt32 activeMask = 0;
+	for (dgInt32 i = 0; i < count; i ++) {
+		const dgFloat32* const p0 = &descriptor->m_p0[(first + i) * descriptor->m_stride];
+		const dgFloat32* const p1 = &descriptor->m_p1[(first + i) * descriptor->m_stride];
+		dgRayHitInfo& hit = descriptor->m_hits[first + i];
+		for (dgInt32 j = 0; j < 4; j ++) {
+			hit.m_point[j] = dgFloat32 (0.0f);
+			hit.m_normal[j] = dgFloat32 (0.0f);
+		}
+		hit.m_contaID = 0;
+		hit.m_hitBody = NULL;
+		hit.m_intersectParam = dgFloat32 (1.0f);
+
+		dgLineBox& line = lines[i];
+		line.m_l0 = dgVector (p0[0], p0[1], p0[2], dgFloat32 (0.0f));
+		line.m_l1 = dgVector (p1[0], p1[1], p1[2], dgFloat32 (0.0f));
+		dgVector test (line.m_l0 <= line.m_l1);
+		line.m_boxL0 = (line.m_l0 & test) | line.m_l1.AndNot(test);
+		line.m_boxL1 = (line.m_l1 & test) | line.m_l0.AndNot(test);
+
+		dgVector diff (line.m_l1 - line.m_l0);
+		if ((diff % diff) > dgFloat32 (1.0e-8f)) {
+			dgVector isParallel (diff.Abs() < dgVector (dgFloat32 (1.0e-8f)));
+			dgVector invDir (((dgVector (dgFloat32 (1.0e-20f)) & isParallel) | diff.AndNot(isParallel)).Reciproc());
+			originX[i] = line.m_l0.m_x;
+			originY[i] = line.m_l0.m_y;
+			originZ[i] = line.m_l0.m_z;
+			invDirX[i] = invDir.m_x;
+			invDirY[i] = invDir.m_y;
+			invDirZ[i] = invDir.m_z;
+			maxT[i] = dgFloat32 (1.0f);
+			direction += diff;
+			activeMask |= 1 << i;
+		}
+	}
+
+	dgInt32 stack = 0;
+	const dgNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	if (m_staticRootNode) {
+		stackPool[stack] = m_staticRootNode;
+		stack ++;
+	}
+	if (m_rootNode) {
+		stackPool[stack] = m_rootNode;
+		stack ++;
+	}
+
+	const dgBody* const sentinel = m_world->GetSentinelBody();
+	while (stack && activeMask) {
+		stack --;
+		const dgNode* const node = stackPool[stack];
+
+		dgVector tx0 ((node->m_minBox.BroadcastX() - originX).CompProduct4(invDirX));
+		dgVector tx1 ((node->m_maxBox.BroadcastX() - originX).CompProduct4(invDirX));
+		dgVector ty0 ((node->m_minBox.BroadcastY() - originY).CompProduct4(invDirY));
+		dgVector ty1 ((node->m_maxBox.BroadcastY() - originY).CompProduct4(invDirY));
+		dgVector tz0 ((node->m_minBox.BroadcastZ() - originZ).CompProduct4(invDirZ));
+		dgVector tz1 ((node->m_maxBox.BroadcastZ() - originZ).CompProduct4(invDirZ));
+		dgVector t0 (tx0.GetMin(tx1).GetMax(ty0.GetMin(ty1)).GetMax(tz0.GetMin(tz1)).GetMax(zero));
+		dgVector t1 (tx0.GetMax(tx1).GetMin(ty0.GetMax(ty1)).GetMin(tz0.GetMax(tz1)).GetMin(maxT));
+		const dgInt32 hitMask = (t0 <= t1).GetSignMask() & activeMask;
+		if (!hitMask) {
+			continue;
+		}
+
+		if (node->m_body) {
+			dgAssert (!node->m_left);
+			dgAssert (!node->m_right);
+			dgBody* const body = node->m_body;
+			if (body != sentinel) {
+				for (dgInt32 i = 0; i < count; i ++) {
+					if (hitMask & (1 << i)) {
+						dgFloat32 param = body->RayCast (lines[i], RayCastBatchFilter, NULL, &descriptor->m_hits[first + i], maxT[i]);
+						if (param < maxT[i]) {
+							maxT[i] = param;
+							if (descriptor->m_anyHit || (param < dgFloat32 (1.0e-8f))) {
+								activeMask &= ~(1 << i);
 							}
-							stackPool[j] = right;
-							distance[j] = dist;
-							stack++;
-							dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (dgNode*)));
 						}
 					}
 				}
 			}
+		} else {
+			// the child nearer to the rays is visited first, so the closest hit culls most of the other child
+			const dgNode* nearNode = node->m_left;
+			const dgNode* farNode = node->m_right;
+			dgVector separation ((nearNode->m_minBox + nearNode->m_maxBox) - (farNode->m_minBox + farNode->m_maxBox));
+			if ((separation % direction) > dgFloat32 (0.0f)) {
+				dgSwap (nearNode, farNode);
+			}
+			stackPool[stack] = farNode;
+			stack ++;
+			stackPool[stack] = nearNode;
+			stack ++;
+			dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
+		}
+	}
+}
+
+
+void dgBroadPhase::ConvexCastBatch (const dgCollisionInstance* const* const shapes, const dgFloat32* const matrices, const dgFloat32* const targets, dgInt32 targetStrideInBytes, dgInt32 count, OnRayPrecastAction prefilter, void* const* const userData, dgFloat32* const timeToImpact, dgInt32* const contactsCount, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	dgBroadphaseConvexCastBatchDescriptor descriptor;
+	descriptor.m_shapes = shapes;
+	descriptor.m_matrices = matrices;
+	descriptor.m_targets = targets;
+	descriptor.m_prefilter = prefilter;
+	descriptor.m_userData = userData;
+	descriptor.m_timeToImpact = timeToImpact;
+	descriptor.m_contactsCount = contactsCount;
+	descriptor.m_info = info;
+	descriptor.m_maxContacts = maxContacts;
+	descriptor.m_targetStride = targetStrideInBytes / dgInt32 (sizeof (dgFloat32));
+	descriptor.m_count = count;
+	descriptor.m_atomicIndex = 0;
+
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	if (m_world->m_inUpdate || (threadsCount == 1) || (count <= DG_BROADPHASE_CONVEX_BATCH_JOB)) {
+		// from inside the update the threads are busy with the step, the calling thread does all the casts
+		for (dgInt32 i = 0; i < count; i ++) {
+			ConvexCastQuery (&descriptor, i, threadIndex);
+		}
+	} else {
+		for (dgInt32 i = 0; i < threadsCount; i ++) {
+			m_world->QueueJob (ConvexCastBatchKernel, &descriptor, m_world);
+		}
+		m_world->SynchronizationBarrier();
+	}
+}
+
+void dgBroadPhase::ConvexCastBatchKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBroadphaseConvexCastBatchDescriptor* const descriptor = (dgBroadphaseConvexCastBatchDescriptor*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "ConvexCastBatchKernel", threadID);
+
+	const dgBroadPhase* const broadPhase = world->GetBroadPhase();
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_CONVEX_BATCH_JOB); i < descriptor->m_count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_CONVEX_BATCH_JOB)) {
+		const dgInt32 count = dgMin (descriptor->m_count, i + DG_BROADPHASE_CONVEX_BATCH_JOB);
+		for (dgInt32 j = i; j < count; j ++) {
+			broadPhase->ConvexCastQuery (descriptor, j, threadID);
+		}
+	}
+}
+
+void dgBroadPhase::ConvexCastQuery (dgBroadphaseConvexCastBatchDescriptor* const descriptor, dgInt32 index, dgInt32 threadID) const
+{
+	const dgFloat32* const target = &descriptor->m_targets[index * descriptor->m_targetStride];
+	dgMatrix matrix (&descriptor->m_matrices[index * 16]);
+	matrix.m_front.m_w = dgFloat32 (0.0f);
+	matrix.m_up.m_w = dgFloat32 (0.0f);
+	matrix.m_right.m_w = dgFloat32 (0.0f);
+	matrix.m_posit.m_w = dgFloat32 (1.0f);
+	dgVector destination (target[0], target[1], target[2], dgFloat32 (0.0f));
+
+	dgFloat32 timeToImpact = dgFloat32 (1.0f);
+	dgCollisionInstance* const shape = (dgCollisionInstance*) descriptor->m_shapes[index];
+	void* const userData = descriptor->m_userData ? descriptor->m_userData[index] : NULL;
+	dgConvexCastReturnInfo* const info = descriptor->m_info ? &descriptor->m_info[index * descriptor->m_maxContacts] : NULL;
+	const dgInt32 count = ConvexCast (shape, matrix, destination, timeToImpact, descriptor->m_prefilter, userData, info, descriptor->m_maxContacts, threadID);
+
+	// a cast that hit nothing keeps the search limit of the broadphase, report it as the end of the segment
+	descriptor->m_timeToImpact[index] = dgMin (timeToImpact, dgFloat32 (1.0f));
+	if (descriptor->m_contactsCount) {
+		descriptor->m_contactsCount[index] = count;
+	}
+}
+
+void dgBroadPhase::BodiesInAABBBatch (const dgFloat32* const p0, const dgFloat32* const p1, dgInt32 strideInBytes, dgInt32 count, dgBody** const bodies, dgInt32 maxBodies, dgInt32* const bodiesCount) const
+{
+	dgBroadphaseAABBBatchDescriptor descriptor;
+	descriptor.m_p0 = p0;
+	descriptor.m_p1 = p1;
+	descriptor.m_bodies = bodies;
+	descriptor.m_bodiesCount = bodiesCount;
+	descriptor.m_maxBodies = maxBodies;
+	descriptor.m_stride = strideInBytes / dgInt32 (sizeof (dgFloat32));
+	descriptor.m_count = count;
+	descriptor.m_atomicIndex = 0;
+
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	if (m_world->m_inUpdate || (threadsCount == 1) || (count <= DG_BROADPHASE_AABB_BATCH_JOB)) {
+		for (dgInt32 i = 0; i < count; i ++) {
+			BodiesInAABBQuery (&descriptor, i);
+		}
+	} else {
+		for (dgInt32 i = 0; i < threadsCount; i ++) {
+			m_world->QueueJob (BodiesInAABBBatchKernel, &descriptor, m_world);
+		}
+		m_world->SynchronizationBarrier();
+	}
+}
+
+void dgBroadPhase::BodiesInAABBBatchKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBroadphaseAABBBatchDescriptor* const descriptor = (dgBroadphaseAABBBatchDescriptor*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "BodiesInAABBBatchKernel", threadID);
+
+	const dgBroadPhase* const broadPhase = world->GetBroadPhase();
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_AABB_BATCH_JOB); i < descriptor->m_count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, DG_BROADPHASE_AABB_BATCH_JOB)) {
+		const dgInt32 count = dgMin (descriptor->m_count, i + DG_BROADPHASE_AABB_BATCH_JOB);
+		for (dgInt32 j = i; j < count; j ++) {
+			broadPhase->BodiesInAABBQuery (descriptor, j);
+		}
+	}
+}
+
+dgInt32 dgBroadPhase::BodiesInAABBBatchCallback (dgBody* body, void* const userData)
+{
+	dgBroadphaseAABBCollector* const collector = (dgBroadphaseAABBCollector*) userData;
+	collector->m_bodies[collector->m_count] = body;
+	collector->m_count ++;
+	return (collector->m_count < collector->m_maxCount) ? 1 : 0;
+}
+
+void dgBroadPhase::BodiesInAABBQuery (dgBroadphaseAABBBatchDescriptor* const descriptor, dgInt32 index) const
+{
+	const dgFloat32* const p0 = &descriptor->m_p0[index * descriptor->m_stride];
+	const dgFloat32* const p1 = &descriptor->m_p1[index * descriptor->m_stride];
+	dgVector q0 (p0[0], p0[1], p0[2], dgFloat32 (0.0f));
+	dgVector q1 (p1[0], p1[1], p1[2], dgFloat32 (0.0f));
+
+	// each box writes its bodies to its own slice of the array, the search stops when the slice is full
+	dgBroadphaseAABBCollector collector;
+	collector.m_bodies = &descriptor->m_bodies[index * descriptor->m_maxBodies];
+	collector.m_count = 0;
+	collector.m_maxCount = descriptor->m_maxBodies;
+	if (collector.m_maxCount > 0) {
+		ForEachBodyInAABB (q0, q1, BodiesInAABBBatchCallback, &collector);
+	}
+	descriptor->m_bodiesCount[index] = collector.m_count;
+}
+
+
+dgUnsigned32 dgBroadPhase::RayCastCachedPrefilter (const dgBody* const body, const dgCollisionInstance* const collision, void* const userData)
+{
+	// every body whose box is crossed by the ray is called here before its shape is tested
+	const dgBroadphaseCachedRay* const context = (dgBroadphaseCachedRay*) ((dgRayHitInfo*) userData);
+	context->m_entry->AddBody ((dgBody*) body);
+	return context->m_prefilter ? context->m_prefilter (body, collision, context->m_userData) : 1;
+}
+
+dgInt32 dgBroadPhase::BodiesInAABBCachedCallback (dgBody* body, void* const userData)
+{
+	dgBroadphaseQueryCacheEntry* const entry = (dgBroadphaseQueryCacheEntry*) userData;
+	entry->AddBody (body);
+	return 1;
+}
+
+dgBroadphaseQueryCacheEntry* dgBroadPhase::GetQueryCacheEntry (dgUnsigned64 cacheKey)
+{
+	// only the map is locked, the same key should not be used by two threads at the same time
+	dgThreadHiveScopeLock lock (m_world, &m_queryCacheLock);
+	if (!m_queryCache) {
+		m_queryCache = new (m_world->GetAllocator()) dgBroadphaseQueryCache (m_world->GetAllocator());
+	}
+	dgBroadphaseQueryCache::dgTreeNode* node = m_queryCache->Find (cacheKey);
+	if (!node) {
+		if (m_queryCache->GetCount() >= DG_BROADPHASE_QUERY_CACHE_SIZE) {
+			dgBroadphaseQueryCacheEntry* const oldest = m_queryCache->m_lruList.GetFirst()->GetInfo();
+			m_queryCache->RemoveEntry (m_queryCache->Find (oldest->m_key));
+		}
+		dgBroadphaseQueryCacheEntry* const entry = new (m_world->GetAllocator()) dgBroadphaseQueryCacheEntry (m_world->GetAllocator(), cacheKey);
+		entry->m_lruNode = m_queryCache->m_lruList.Append (entry);
+		node = m_queryCache->Insert (entry, cacheKey);
+	} else {
+		m_queryCache->m_lruList.RotateToEnd (node->GetInfo()->m_lruNode);
+	}
+	return node->GetInfo();
+}
+
+void dgBroadPhase::InvalidateQueryCache (dgBody* const* const bodies, dgInt32 count)
+{
+	dgThreadHiveScopeLock lock (m_world, &m_queryCacheLock);
+	dgBroadphaseQueryCache::Iterator iter (*m_queryCache);
+	for (iter.Begin(); iter; iter ++) {
+		dgBroadphaseQueryCacheEntry* const entry = iter.GetNode()->GetInfo();
+		if (entry->m_valid && (entry->m_queryStamp == m_queryStamp)) {
+			for (dgInt32 i = 0; i < count; i ++) {
+				dgVector minBox;
+				dgVector maxBox;
+				bodies[i]->GetAABB (minBox, maxBox);
+				if (entry->IsAffectedBy (bodies[i], minBox & dgVector::m_triplexMask, maxBox & dgVector::m_triplexMask)) {
+					entry->m_valid = false;
+					break;
+				}
+			}
+		}
+	}
+}
+
+void dgBroadPhase::UpdateQueryCache ()
+{
+	if (m_queryCache) {
+		if ((m_movedBodiesCount > m_movedBodies.GetElementsCapacity()) || (m_movedBodiesCount && (m_movedRemoveStamp != m_removeStamp))) {
+			// some moved bodies did not fit in the array or may have been destroyed, none of the entries can be trusted
+			dgThreadHiveScopeLock lock (m_world, &m_queryCacheLock);
+			dgBroadphaseQueryCache::Iterator iter (*m_queryCache);
+			for (iter.Begin(); iter; iter ++) {
+				iter.GetNode()->GetInfo()->m_valid = false;
+			}
+		} else if (m_movedBodiesCount) {
+			InvalidateQueryCache (&m_movedBodies[0], m_movedBodiesCount);
+		}
+		m_movedBodiesCount = 0;
+		m_movedRemoveStamp = m_removeStamp;
+
+		// the threads of the next update append to the array without growing it, a body can be moved more than once per update
+		const dgInt32 capacity = m_world->GetBodiesCount() * 2;
+		if (m_movedBodies.GetElementsCapacity() < capacity) {
+			m_movedBodies.Resize (capacity);
+		}
+	}
+}
+
+void dgBroadPhase::RemoveQueryCache (dgUnsigned64 cacheKey)
+{
+	dgThreadHiveScopeLock lock (m_world, &m_queryCacheLock);
+	if (m_queryCache) {
+		dgBroadphaseQueryCache::dgTreeNode* const node = m_queryCache->Find (cacheKey);
+		if (node) {
+			m_queryCache->RemoveEntry (node);
+		}
+	}
+}
+
+dgFloat32 dgBroadPhase::RayCastCachedNodes (const dgNode* const* const roots, dgInt32 rootsCount, const dgNode* const skip, const dgFastRayTest& ray, const dgLineBox& line, dgBroadphaseCachedRay* const context, dgFloat32 maxParam) const
+{
+	dgFloat32 distance[DG_COMPOUND_STACK_DEPTH];
+	const dgNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+
+	dgInt32 stack = 0;
+	for (dgInt32 i = 0; i < rootsCount; i ++) {
+		const dgNode* const root = roots[i];
+		if (root && (root != skip)) {
+			dgFloat32 dist = ray.BoxIntersect(root->m_minBox, root->m_maxBox);
+			dgInt32 j = stack;
+			for ( ; j && (dist > distance[j - 1]); j --) {
+				stackPool[j] = stackPool[j - 1];
+				distance[j] = distance[j - 1];
+			}
+			stackPool[j] = root;
+			distance[j] = dist;
+			stack ++;
+		}
+	}
+
+	const dgBody* const sentinel = m_world->GetSentinelBody();
+	while (stack) {
+		stack --;
+		if (distance[stack] > maxParam) {
+			break;
+		}
+		const dgNode* const me = stackPool[stack];
+		if (me->m_body) {
+			if (me->m_body != sentinel) {
+				dgFloat32 param = me->m_body->RayCast (line, RayCastBatchFilter, RayCastCachedPrefilter, (dgRayHitInfo*) context, maxParam);
+				if (param < maxParam) {
+					maxParam = param;
+				}
+			}
+		} else {
+			const dgNode* const children[] = {me->m_left, me->m_right};
+			for (dgInt32 i = 0; i < 2; i ++) {
+				const dgNode* const child = children[i];
+				if (child != skip) {
+					dgFloat32 dist = ray.BoxIntersect(child->m_minBox, child->m_maxBox);
+					if (dist < maxParam) {
+						dgInt32 j = stack;
+						for ( ; j && (dist > distance[j - 1]); j --) {
+							stackPool[j] = stackPool[j - 1];
+							distance[j] = distance[j - 1];
+						}
+						stackPool[j] = child;
+						distance[j] = dist;
+						stack++;
+						dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (dgNode*)));
+					}
+				}
+			}
+		}
+	}
+	return maxParam;
+}
+
+void dgBroadPhase::RayCastCached (dgUnsigned64 cacheKey, const dgVector& l0, const dgVector& l1, dgFloat32 tolerance, OnRayPrecastAction prefilter, void* const userData, dgRayHitInfo* const hit)
+{
+	dgBroadphaseQueryCacheEntry* const entry = GetQueryCacheEntry (cacheKey);
+
+	const dgVector p0 (l0 & dgVector::m_triplexMask);
+	const dgVector p1 (l1 & dgVector::m_triplexMask);
+	if (entry->m_valid && entry->m_isRay && (entry->m_queryStamp == m_queryStamp)) {
+		// nothing near the ray moved more than the tolerance, a segment within the tolerance of the last one gets the same answer
+		const dgVector tol (tolerance);
+		const dgVector error (((p0 - entry->m_p0).Abs() > tol) | ((p1 - entry->m_p1).Abs() > tol));
+		if (!(error.GetSignMask() & 0x07)) {
+			*hit = entry->m_hit;
+			return;
+		}
+	}
+
+	dgBroadphaseCachedRay context;
+	memset (&context, 0, sizeof (context));
+	context.m_intersectParam = dgFloat32 (1.0f);
+	context.m_prefilter = prefilter;
+	context.m_userData = userData;
+	context.m_entry = entry;
+	entry->m_bodiesCount = 0;
+
+	dgVector segment (p1 - p0);
+	if (m_wideTreeFitted) {
+		// the wide tree has no parent links to seed the search from, it is faster to cast against it directly
+		RayCastWide (p0, p1, RayCastBatchFilter, RayCastCachedPrefilter, (dgRayHitInfo*) &context);
+	} else if ((segment % segment) > dgFloat32 (1.0e-8f)) {
+		dgFastRayTest ray (p0, p1);
+		dgLineBox line;	
+		line.m_l0 = p0;
+		line.m_l1 = p1;
+		dgVector test (line.m_l0 <= line.m_l1);
+		line.m_boxL0 = (line.m_l0 & test) | line.m_l1.AndNot(test);
+		line.m_boxL1 = (line.m_l1 & test) | line.m_l0.AndNot(test);
+
+		// the subtree around the last body hit is tested first, the hit clips the ray for the traversal of the rest of the trees
+		dgFloat32 maxParam = dgFloat32 (1.2f);
+		const dgNode* subtree = NULL;
+		if (entry->m_isRay && entry->m_hit.m_hitBody && (entry->m_removeStamp == m_removeStamp)) {
+			subtree = entry->m_hit.m_hitBody->m_collisionCell;
+			if (subtree) {
+				for (dgInt32 i = 0; (i < DG_BROADPHASE_QUERY_CACHE_LEVELS) && subtree->m_parent; i ++) {
+					subtree = subtree->m_parent;
+				}
+				maxParam = RayCastCachedNodes (&subtree, 1, NULL, ray, line, &context, maxParam);
+			}
 		}
+		const dgNode* const roots[] = {m_rootNode, m_staticRootNode};
+		RayCastCachedNodes (roots, 2, subtree, ray, line, &context, maxParam);
 	}
+
+	entry->m_p0 = p0;
+	entry->m_p1 = p1;
+	entry->m_hit = context;
+	entry->m_tolerance = tolerance;
+	entry->m_queryStamp = m_queryStamp;
+	entry->m_removeStamp = m_removeStamp;
+	entry->m_isRay = true;
+	entry->m_valid = true;
+	*hit = context;
 }
 
+dgInt32 dgBroadPhase::BodiesInAABBCached (dgUnsigned64 cacheKey, const dgVector& q0, const dgVector& q1, dgFloat32 tolerance, dgBody** const bodies, dgInt32 maxBodies)
+{
+	dgBroadphaseQueryCacheEntry* const entry = GetQueryCacheEntry (cacheKey);
+
+	// the bodies of the grown box are kept, while none of them moves more than the tolerance any box inside it is answered from that list
+	const dgVector minBox (q0 & dgVector::m_triplexMask);
+	const dgVector maxBox (q1 & dgVector::m_triplexMask);
+	if (!(entry->m_valid && !entry->m_isRay && (entry->m_queryStamp == m_queryStamp) && dgBoxInclusionTest (minBox, maxBox, entry->m_p0, entry->m_p1))) {
+		const dgVector tol (dgVector (tolerance) & dgVector::m_triplexMask);
+		entry->m_p0 = minBox - tol;
+		entry->m_p1 = maxBox + tol;
+		entry->m_bodiesCount = 0;
+		ForEachBodyInAABB (entry->m_p0, entry->m_p1, BodiesInAABBCachedCallback, entry);
+		entry->m_tolerance = tolerance;
+		entry->m_queryStamp = m_queryStamp;
+		entry->m_removeStamp = m_removeStamp;
+		entry->m_isRay = false;
+		entry->m_valid = true;
+	}
 
+	dgInt32 count = 0;
+	for (dgInt32 i = 0; (i < entry->m_bodiesCount) && (count < maxBodies); i ++) {
+		dgBody* const body = entry->m_bodies[i].m_body;
+		if (dgOverlapTest (body->m_minAABB, body->m_maxAABB, minBox, maxBox)) {
+			bodies[count] = body;
+			count ++;
+		}
+	}
+	return count;
+}
 
 void dgBroadPhase::ConvexRayCast (dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData, dgInt32 threadId) const
 {
-	if (filter && m_rootNode && shape->IsType(dgCollision::dgCollisionConvexShape_RTTI)) {
+	if (filter && (m_rootNode || m_staticRootNode) && shape->IsType(dgCollision::dgCollisionConvexShape_RTTI)) {
 
 		dgVector boxP0;
 		dgVector boxP1;
 		shape->CalcAABB(shape->GetLocalMatrix() * matrix, boxP0, boxP1);
 
-		dgInt32 stack = 1;
+		dgInt32 stack = 0;
 		dgFloat32 distance[DG_COMPOUND_STACK_DEPTH];
 		const dgNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];		
 
@@ -1660,10 +4005,23 @@ void dgBroadPhase::ConvexRayCast (dgCollisionInstance* const shape, const dgMatr
 		dgFloat32 quantizeStep = dgMax (dgFloat32 (1.0f) / velocA.DotProduct4(velocA).m_x, dgFloat32 (0.001f));
 
 
-		dgVector minBox (m_rootNode->m_minBox - boxP1);
-		dgVector maxBox (m_rootNode->m_maxBox - boxP0);
-		stackPool[0] = m_rootNode;
-		distance[0] = ray.BoxIntersect(minBox, maxBox);
+		const dgNode* const roots[] = {m_rootNode, m_staticRootNode};
+		for (dgInt32 i = 0; i < 2; i ++) {
+			const dgNode* const root = roots[i];
+			if (root) {
+				dgVector minBox (root->m_minBox - boxP1);
+				dgVector maxBox (root->m_maxBox - boxP0);
+				dgFloat32 dist = ray.BoxIntersect(minBox, maxBox);
+				dgInt32 j = stack;
+				for ( ; j && (dist > distance[j - 1]); j --) {
+					stackPool[j] = stackPool[j - 1];
+					distance[j] = distance[j - 1];
+				}
+				stackPool[j] = root;
+				distance[j] = dist;
+				stack ++;
+			}
+		}
 
 		const dgBody* const sentinel = m_world->GetSentinelBody();
 		while (stack) {
@@ -1731,13 +4089,13 @@ void dgBroadPhase::ConvexRayCast (dgCollisionInstance* const shape, const dgMatr
 dgInt32 dgBroadPhase::ConvexCast (dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32& timeToImpact, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
 {
 	dgInt32 totalCount = 0;
-	if (m_rootNode) {
+	if (m_rootNode || m_staticRootNode) {
 		dgVector boxP0;
 		dgVector boxP1;
 		dgAssert (matrix.TestOrthogonal());
 		shape->CalcAABB(matrix, boxP0, boxP1);
 
-		dgInt32 stack = 1;
+		dgInt32 stack = 0;
 		dgTriplex points[DG_CONVEX_CAST_POOLSIZE];
 		dgTriplex normals[DG_CONVEX_CAST_POOLSIZE];
 		dgFloat32 penetration[DG_CONVEX_CAST_POOLSIZE];
@@ -1754,10 +4112,23 @@ dgInt32 dgBroadPhase::ConvexCast (dgCollisionInstance* const shape, const dgMatr
 		dgFloat32 maxParam = dgFloat32 (1.2f);
 		dgFastRayTest ray (dgVector (dgFloat32 (0.0f)), velocA);
 
-		dgVector minBox (m_rootNode->m_minBox - boxP1);
-		dgVector maxBox (m_rootNode->m_maxBox - boxP0);
-		stackPool[0] = m_rootNode;
-		distance[0] = ray.BoxIntersect(minBox, maxBox);
+		const dgNode* const roots[] = {m_rootNode, m_staticRootNode};
+		for (dgInt32 i = 0; i < 2; i ++) {
+			const dgNode* const root = roots[i];
+			if (root) {
+				dgVector minBox (root->m_minBox - boxP1);
+				dgVector maxBox (root->m_maxBox - boxP0);
+				dgFloat32 dist = ray.BoxIntersect(minBox, maxBox);
+				dgInt32 j = stack;
+				for ( ; j && (dist > distance[j - 1]); j --) {
+					stackPool[j] = stackPool[j - 1];
+					distance[j] = distance[j - 1];
+				}
+				stackPool[j] = root;
+				distance[j] = dist;
+				stack ++;
+			}
+		}
 
 		const dgBody* const sentinel = m_world->GetSentinelBody();
 		while (stack) {
@@ -1864,13 +4235,42 @@ dgUnsigned32 dgBroadPhase::GetLRU () const
 }
 
 
+void dgBroadPhase::UpdateContactsTaskGraph (dgBroadphaseSyncDescriptor* const descriptor)
+{
+	// the contacts of each slot only depend on the pair job that fills that slot, 
+	// so the narrow phase of the slots that are done overlaps with the pair search of the rest
+	dgCollidingPairCollector* const contactPairs = m_world;
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+
+	dgInt32 pairJobs[DG_MAX_THREADS_HIVE_COUNT];
+	for (dgInt32 i = 0; i < threadsCount; i ++) {
+		dgBroadphasePairSlot* const slot = &descriptor->m_pairSlots[i];
+		slot->m_descriptor = descriptor;
+		slot->m_slot = i;
+		slot->m_pairsAtomicCounter = 0;
+		contactPairs->m_slotPairsCount[i] = 0;
+		pairJobs[i] = m_world->AddGraphJob (CollidingPairsSlotKernel, slot, m_world);
+	}
+
+	for (dgInt32 i = 0; i < threadsCount; i ++) {
+		for (dgInt32 j = 0; j < threadsCount; j ++) {
+			dgInt32 job = m_world->AddGraphJob (UpdateContactsSlotKernel, &descriptor->m_pairSlots[i], m_world);
+			m_world->AddGraphDependency (job, pairJobs[i]);
+		}
+	}
+	m_world->ExecuteGraph();
+}
+
 void dgBroadPhase::UpdateContacts (dgFloat32 timestep)
 {
+	DG_PROFILER_EVENT (m_world, "UpdateContacts", DG_PROFILER_MASTER_TRACK);
+	dgWorldCounterScope counterScope (&m_world->m_counters, m_collisionTicks, DG_WORLD_COUNTERS_MASTER_ROW);
 	dgUnsigned32 ticks = m_world->m_getPerformanceCount();
 
 	dgCollidingPairCollector* const contactPairs = m_world;
 	contactPairs->Init();
 	m_lru = m_lru + 1;
+	UpdateQueryCache ();
 
 	m_recursiveChunks = true;
 	dgInt32 threadsCount = m_world->GetThreadCount();	
@@ -1888,30 +4288,51 @@ void dgBroadPhase::UpdateContacts (dgFloat32 timestep)
 	}
 	m_world->SynchronizationBarrier();
 
+	// the forces may have woken up kinematic bodies, they leave the static tree before any pair is found
+	UpdateStaticTree ();
+
 	// update pre-listeners after the force and true are applied
 	if (m_world->m_preListener.GetCount()) {
+		dgWorldCounterScope listenerScope (&m_world->m_counters, m_preUpdataListerTicks, DG_WORLD_COUNTERS_MASTER_ROW);
 		dgUnsigned32 ticks = m_world->m_getPerformanceCount();
 		for (dgWorld::dgListenerList::dgListNode* node = m_world->m_preListener.GetFirst(); node; node = node->GetNext()) {
 			dgWorld::dgListener& listener = node->GetInfo();
+			DG_PROFILER_EVENT (m_world, listener.m_name, DG_PROFILER_MASTER_TRACK);
 			listener.m_onListenerUpdate (m_world, listener.m_userData, timestep);
 		}
 		m_world->m_perfomanceCounters[m_preUpdataListerTicks] = m_world->m_getPerformanceCount() - ticks;
 	}
 
-	ImproveFitness();
+	// the force callbacks and the listeners may have moved bodies
+	if (m_maintenanceBudget > 0) {
+		RefitTree ();
+		m_refitDeferred = 0;
+		m_wideTreeFitted = false;
+		RebuildDirtySubtrees ();
+	} else {
+		UpdateTreeBounds ();
+		ImproveFitness();
+	}
 	if (m_broadPhaseType == m_generic) {
-		syncPoints.CreatePairsJobs (m_rootNode);
+		syncPoints.CreatePairsJobs (m_rootNode, m_staticRootNode);
+	} else if (m_broadPhaseType == m_wide) {
+		BuildWideTree ();
 	}
 
-	for (dgInt32 i = 0; i < threadsCount; i ++) {
-		m_world->QueueJob (CollidingPairsKernel, &syncPoints, m_world);
-	}
-	m_world->SynchronizationBarrier();
+	if (m_world->m_useTaskGraph) {
+		UpdateContactsTaskGraph (&syncPoints);
+	} else {
+		for (dgInt32 i = 0; i < threadsCount; i ++) {
+			m_world->QueueJob (CollidingPairsKernel, &syncPoints, m_world);
+		}
+		m_world->SynchronizationBarrier();
 
-	for (dgInt32 i = 0; i < threadsCount; i ++) {
-		m_world->QueueJob (UpdateContactsKernel, &syncPoints, m_world);
+		for (dgInt32 i = 0; i < threadsCount; i ++) {
+			m_world->QueueJob (UpdateContactsKernel, &syncPoints, m_world);
+		}
+		m_world->SynchronizationBarrier();
 	}
-	m_world->SynchronizationBarrier();
+	AttachNewContacts();
 
 	m_recursiveChunks = false;
 	if (m_generatedBodies.GetCount()) {
@@ -1925,6 +4346,7 @@ void dgBroadPhase::UpdateContacts (dgFloat32 timestep)
 			m_world->QueueJob (UpdateContactsKernel, &syncPoints, m_world);
 		}
 		m_world->SynchronizationBarrier();
+		AttachNewContacts();
 
 		m_generatedBodies.RemoveAll();
 	}
@@ -1937,6 +4359,8 @@ void dgBroadPhase::UpdateContacts (dgFloat32 timestep)
 
 	// update soft body dynamics phase 1
     dgDeformableBodiesUpdate* const softBodyList = m_world;
+	dgUnsigned64 softBodyTime = dgGetTimeInNanoseconds();
     softBodyList->ApplyExternaForces(timestep);
+	m_world->m_counters.m_ticks[DG_WORLD_COUNTERS_MASTER_ROW][m_softBodyTicks] += dgGetTimeInNanoseconds() - softBodyTime;
 	m_world->m_perfomanceCounters[m_softBodyTicks] = m_world->m_getPerformanceCount() - endTicks;
 }
@@ -30,7 +30,17 @@ class dgWorld;
 class dgContact;
 class dgCollision;
 class dgCollisionInstance;
+class dgBroadphasePairSlot;
 class dgBroadphaseSyncDescriptor;
+class dgBroadphaseMaintenanceDescriptor;
+class dgBroadphaseBuildJob;
+class dgBroadphaseRayBatchDescriptor;
+class dgBroadphaseConvexCastBatchDescriptor;
+class dgBroadphaseAABBBatchDescriptor;
+class dgBroadPhaseSnapshot;
+class dgBroadphaseQueryCache;
+class dgBroadphaseQueryCacheEntry;
+class dgBroadphaseCachedRay;
 
 typedef dgInt32 (dgApi *OnBodiesInAABB) (dgBody* body, void* const userData);
 typedef dgUnsigned32 (dgApi *OnRayPrecastAction) (const dgBody* const body, const dgCollisionInstance* const collision, void* const userData);
@@ -61,6 +71,16 @@ class dgConvexCastReturnInfo
 	dgFloat32 m_penetration;                // contact penetration at collision point
 };
 
+class dgRayHitInfo
+{
+	public:
+	dgFloat32 m_point[4];					// hit point in global space
+	dgFloat32 m_normal[4];					// surface normal at the hit point in global space
+	dgInt64  m_contaID;						// collision ID at the hit point
+	const dgBody* m_hitBody;				// body hit by the ray, NULL when the ray did not hit anything
+	dgFloat32 m_intersectParam;				// fraction of the segment at the hit point, 1.0 when the ray did not hit anything
+};
+
 
 class dgBroadPhase
 {
@@ -71,9 +91,11 @@ class dgBroadPhase
 	{
 		m_generic = 0,
 		m_persistent,
+		m_wide,
 	};
 
 	class dgNode;
+	class dgWideNode;
 	class dgSpliteInfo;
 
 	dgBroadPhase(dgWorld* const world);
@@ -86,12 +108,28 @@ class dgBroadPhase
 
 	dgInt32 ConvexCast (dgCollisionInstance* const shape, const dgMatrix& p0, const dgVector& p1, dgFloat32& timetoImpact, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
 	void ForEachBodyInAABB (const dgVector& q0, const dgVector& q1, OnBodiesInAABB callback, void* const userData) const;
+	void RayCastBatch (const dgFloat32* const p0, const dgFloat32* const p1, dgInt32 strideInBytes, dgInt32 count, bool anyHit, dgRayHitInfo* const hits) const;
+	void ConvexCastBatch (const dgCollisionInstance* const* const shapes, const dgFloat32* const matrices, const dgFloat32* const targets, dgInt32 targetStrideInBytes, dgInt32 count, OnRayPrecastAction prefilter, void* const* const userData, dgFloat32* const timeToImpact, dgInt32* const contactsCount, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	void BodiesInAABBBatch (const dgFloat32* const p0, const dgFloat32* const p1, dgInt32 strideInBytes, dgInt32 count, dgBody** const bodies, dgInt32 maxBodies, dgInt32* const bodiesCount) const;
+	void RayCastCached (dgUnsigned64 cacheKey, const dgVector& p0, const dgVector& p1, dgFloat32 tolerance, OnRayPrecastAction prefilter, void* const userData, dgRayHitInfo* const hit);
+	dgInt32 BodiesInAABBCached (dgUnsigned64 cacheKey, const dgVector& q0, const dgVector& q1, dgFloat32 tolerance, dgBody** const bodies, dgInt32 maxBodies);
+	void RemoveQueryCache (dgUnsigned64 cacheKey);
 
 	dgInt32 GetBroadPhaseType () const;
 	void SelectBroadPhaseType (dgInt32 algorthmType);
 
+	dgInt32 GetMaintenanceBudget () const;
+	void SetMaintenanceBudget (dgInt32 microseconds);
+
 	void ResetEntropy ();
 
+	void EnableSnapshot (bool state);
+	bool IsSnapshotEnabled () const;
+	void PublishSnapshot ();
+	void RemoveFromSnapshot (dgBody* const body);
+	void SnapshotRayCast (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
+	void SnapshotForEachBodyInAABB (const dgVector& q0, const dgVector& q1, OnBodiesInAABB callback, void* const userData) const;
+
 	protected:
 	class dgFitnessList: public dgList <dgNode*>
 	{
@@ -102,14 +140,40 @@ class dgBroadPhase
 
 	void Add (dgBody* const body);
 	void Remove (dgBody* const body);
+	void AddBodies (dgBody** const bodies, dgInt32 count);
+	void RemoveBodies (dgBody** const bodies, dgInt32 count);
 	void InvalidateCache ();
 	void UpdateContacts (dgFloat32 timestep);
 	void AddInternallyGeneratedBody(dgBody* const body);
 	void UpdateBodyBroadphase(dgBody* const body, dgInt32 threadIndex);
 
 	void ImproveFitness();
+	void BuildWideTree ();
+	void RefitWideTree ();
+	void UpdateTreeBounds ();
+	void UpdateQueryCache ();
+
+	void RefitTree ();
+	void RefitTreeNodes (dgBroadphaseMaintenanceDescriptor* const descriptor, dgInt32 threadID);
+	void RebuildDirtySubtrees ();
+	void RebuildSubtrees (dgBroadphaseMaintenanceDescriptor* const descriptor, dgInt32 threadID);
+	void RebuildSubtree (dgNode* const root, dgInt32 threadID);
+	dgInt32 SplitBinned (dgNode** const primitives, dgInt32 count, dgVector& minBox, dgVector& maxBox) const;
+	dgNode* BuildBinned (dgNode** const primitives, dgInt32 count, dgNode** const internalNodes, dgInt32& index) const;
+	dgNode* BuildBinnedTop (dgNode** const primitives, dgInt32 count, dgNode** const internalNodes, dgInt32& index, dgNode* const parent, bool isLeft, dgInt32 jobLeafs, dgBroadphaseBuildJob* const jobs, dgInt32& jobsCount, dgNode** const topNodes, dgInt32& topCount) const;
+	dgNode* BuildBinnedParallel (dgNode** const primitives, dgInt32 count, dgNode** const internalNodes);
+	static void RefitTreeKernel (void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static void RebuildSubtreesKernel (void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static void BuildBinnedKernel (void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static dgInt32 CompareSubtreeDecay (dgNode* const* const nodeA, dgNode* const* const nodeB, void* const notUsed);
+	static dgInt32 CompareBodiesUniqueID (dgBody* const* const bodyA, dgBody* const* const bodyB, void* const notUsed);
 	void ImproveNodeFitness (dgNode* const node);
-	dgNode* InsertNode (dgNode* const node);
+	dgNode* InsertNode (dgNode* const root, dgNode* const node, dgFitnessList& fitness);
+	void RemoveDynamicBodies (dgBody** const bodies, dgInt32 count);
+	void InsertLeafs (dgNode** const leafs, dgInt32 count, bool isStatic);
+	bool IsStaticBody (const dgBody* const body) const;
+	void CheckStaticState (dgBody* const body);
+	void UpdateStaticTree ();
 	dgFloat32 CalculateSurfaceArea (const dgNode* const node0, const dgNode* const node1, dgVector& minBox, dgVector& maxBox) const;
 
 	void AddPair (dgBody* const body0, dgBody* const body1, const dgVector& timestep2, dgInt32 threadID);
@@ -119,11 +183,15 @@ class dgBroadPhase
 	static void UpdateContactsKernel (void* const descriptor, void* const worldContext, dgInt32 threadID);
 //	static void UpdateSoftBodyForcesKernel (void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void AddGeneratedBodyesContactsKernel (void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static void CollidingPairsSlotKernel (void* const slot, void* const worldContext, dgInt32 threadID);
+	static void UpdateContactsSlotKernel (void* const slot, void* const worldContext, dgInt32 threadID);
 	
+	void UpdateContactsTaskGraph (dgBroadphaseSyncDescriptor* const descriptor);
 	void UpdateContactsBroadPhaseEnd ();
+	void AttachNewContacts ();
 	void ApplyForceAndtorque (dgBroadphaseSyncDescriptor* const desctiptor, dgInt32 threadID);
 	void ApplyDeformableForceAndtorque (dgBroadphaseSyncDescriptor* const desctiptor, dgInt32 threadID);
-	void CalculatePairContacts (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
+	void CalculatePairContacts (dgBroadphaseSyncDescriptor* const descriptor, dgBroadphasePairSlot* const slot, dgInt32 threadID);
 //	void UpdateSoftBodyForcesKernel (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
 	
 	dgNode* BuildTopDown (dgNode** const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgFitnessList::dgListNode** const nextNode);
@@ -131,6 +199,23 @@ class dgBroadPhase
 	void FindCollidingPairsGeneric (dgBroadphaseSyncDescriptor* const desctiptor, dgInt32 threadID);
 	void FindCollidingPairsPersistent (dgBroadphaseSyncDescriptor* const desctiptor, dgInt32 threadID);
 	void SubmitPairsPersistent (dgNode* const body, dgNode* const node, const dgVector& timeStepBound, dgInt32 threadID);
+	void FindCollidingPairsWide (dgBroadphaseSyncDescriptor* const desctiptor, dgInt32 threadID);
+	void SubmitPairsWide (dgInt32 leafIndex, const dgVector& timeStepBound, dgInt32 threadID);
+	void RayCastWide (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
+	void ForEachBodyInAABBWide (const dgVector& q0, const dgVector& q1, OnBodiesInAABB callback, void* const userData) const;
+	void RayCastPacket (dgBroadphaseRayBatchDescriptor* const descriptor, dgInt32 first, dgInt32 count) const;
+	static void RayCastBatchKernel (void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static dgFloat32 dgApi RayCastBatchFilter (const dgBody* const body, const dgCollisionInstance* const collision, const dgVector& contact, const dgVector& normal, dgInt64 collisionID, void* const userData, dgFloat32 intersetParam);
+	void ConvexCastQuery (dgBroadphaseConvexCastBatchDescriptor* const descriptor, dgInt32 index, dgInt32 threadID) const;
+	void BodiesInAABBQuery (dgBroadphaseAABBBatchDescriptor* const descriptor, dgInt32 index) const;
+	static void ConvexCastBatchKernel (void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static void BodiesInAABBBatchKernel (void* const descriptor, void* const worldContext, dgInt32 threadID);
+	static dgInt32 dgApi BodiesInAABBBatchCallback (dgBody* body, void* const userData);
+	dgFloat32 RayCastCachedNodes (const dgNode* const* const roots, dgInt32 rootsCount, const dgNode* const skip, const dgFastRayTest& ray, const dgLineBox& line, dgBroadphaseCachedRay* const context, dgFloat32 maxParam) const;
+	dgBroadphaseQueryCacheEntry* GetQueryCacheEntry (dgUnsigned64 cacheKey);
+	void InvalidateQueryCache (dgBody* const* const bodies, dgInt32 count);
+	static dgUnsigned32 dgApi RayCastCachedPrefilter (const dgBody* const body, const dgCollisionInstance* const collision, void* const userData);
+	static dgInt32 dgApi BodiesInAABBCachedCallback (dgBody* body, void* const userData);
 
 	void FindGeneratedBodiesCollidingPairs (dgBroadphaseSyncDescriptor* const desctiptor, dgInt32 threadID);
 
@@ -139,17 +224,62 @@ class dgBroadPhase
 	bool TestOverlaping (const dgBody* const body0, const dgBody* const body1) const;
 	dgFloat64 CalculateEmptropy ();
 
+	static dgInt32 CompareNewContacts (dgContact* const* const contactA, dgContact* const* const contactB, void* const notUsed);
+
 	dgWorld* m_world;
 	dgNode* m_rootNode;
 	dgFloat64 m_treeEntropy;
 	dgUnsigned32 m_lru;
 	dgFitnessList m_fitness;
+
+	// bodies without mass that do not move are kept in a second tree, it is not part of the tree rotations 
+	// and it is only rebuilt when its cost drifts far from the last build
+	dgNode* m_staticRootNode;
+	dgFitnessList m_staticFitness;
+	dgFloat64 m_staticBuildCost;
+	bool m_staticTreeChanged;
+	dgList<dgNode*> m_staticStateChanges;
+
 	dgList<dgBody*> m_generatedBodies;
 	dgType m_broadPhaseType;
-	dgThread::dgCriticalSection m_contacJointLock;
 	dgThread::dgCriticalSection m_criticalSectionLock;
+
+	// contacts created by each thread during the pair search, they are linked to the bodies after the pair kernels are done
+	dgArray<dgContact*>* m_newContacts[DG_MAX_THREADS_HIVE_COUNT];
+	dgInt32 m_newContactsCount[DG_MAX_THREADS_HIVE_COUNT];
+
+	// linear 4 wide copy of the tree, rebuilt after the tree changes shape and refit after the bodies move
+	dgArray<dgWideNode> m_wideNodes;
+	dgArray<dgNode*> m_wideLeafs;
+	dgInt32 m_wideNodesCount;
+	dgInt32 m_wideLeafsCount;
+	bool m_wideTreeBuilt;
+	bool m_wideTreeFitted;
+
+	// the tree is refit in parallel after the bodies move, when the budget is not zero 
+	// the subtrees that lost the most quality are also rebuilt until the step runs out of budget
+	dgArray<dgNode*> m_fitnessArray;
+	dgInt32 m_fitnessArrayCount;
+	dgInt32 m_maintenanceBudget;
+	dgFloat32 m_topBuildCost;
+	dgInt32 m_refitDeferred;
+	bool m_fitnessArrayDirty;
 	bool m_recursiveChunks;
 
+	// optional read only copy of the trees for queries that run while the next step is updating the bodies
+	dgBroadPhaseSnapshot* m_snapshot;
+
+	// results of the cached queries are reused across updates, the bodies moved inside an update are collected 
+	// and the entries they affect are cleared once the update is done with them. The query stamp moves when a body 
+	// is added or removed, the remove stamp only when a body leaves the tree.
+	dgBroadphaseQueryCache* m_queryCache;
+	dgThread::dgCriticalSection m_queryCacheLock;
+	dgArray<dgBody*> m_movedBodies;
+	dgInt32 m_movedBodiesCount;
+	dgUnsigned32 m_movedRemoveStamp;
+	dgUnsigned32 m_queryStamp;
+	dgUnsigned32 m_removeStamp;
+
 	static dgVector m_conservativeRotAngle;
 	friend class dgBody;
 	friend class dgWorld;
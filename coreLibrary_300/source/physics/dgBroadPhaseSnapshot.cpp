@@ -0,0 +1,290 @@
+/* Copyright (c) <2003-2011> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgContact.h"
+#include "dgCollisionInstance.h"
+#include "dgBroadPhaseSnapshot.h"
+
+#define DG_SNAPSHOT_STACK_DEPTH		256
+
+
+dgBroadPhaseSnapshot::dgBuffer::dgBuffer (dgMemoryAllocator* const allocator)
+	:m_nodes(256, allocator)
+	,m_bodies(256, allocator)
+	,m_nodesCount(0)
+	,m_bodiesCount(0)
+	,m_readers(0)
+{
+	m_roots[0] = -1;
+	m_roots[1] = -1;
+}
+
+dgBroadPhaseSnapshot::dgBuffer::~dgBuffer ()
+{
+	Clear ();
+}
+
+void dgBroadPhaseSnapshot::dgBuffer::Clear ()
+{
+	dgAssert (!m_readers);
+	for (dgInt32 i = 0; i < m_bodiesCount; i ++) {
+		m_bodies[i].m_collision->Release();
+	}
+	m_nodesCount = 0;
+	m_bodiesCount = 0;
+	m_roots[0] = -1;
+	m_roots[1] = -1;
+}
+
+
+dgBroadPhaseSnapshot::dgBroadPhaseSnapshot (dgMemoryAllocator* const allocator)
+	:m_buffer0(allocator)
+	,m_buffer1(allocator)
+	,m_front(0)
+{
+	m_buffers[0] = &m_buffer0;
+	m_buffers[1] = &m_buffer1;
+}
+
+dgBroadPhaseSnapshot::~dgBroadPhaseSnapshot ()
+{
+}
+
+dgBroadPhaseSnapshot::dgBuffer& dgBroadPhaseSnapshot::BeginPublish (dgInt32& bufferIndex)
+{
+	// a reader that picked the back buffer before the last swap is still walking it, wait until it leaves
+	bufferIndex = m_front ^ 1;
+	dgBuffer* const buffer = m_buffers[bufferIndex];
+	while (buffer->m_readers) {
+		dgThreadYield();
+	}
+	buffer->Clear();
+	return *buffer;
+}
+
+void dgBroadPhaseSnapshot::EndPublish ()
+{
+	dgInterlockedExchange (&m_front, m_front ^ 1);
+}
+
+void dgBroadPhaseSnapshot::RemoveBody (const dgBody* const body, const dgInt32* const bodyIndex)
+{
+	// the entry keeps its collision reference until the buffer is written again, only the body is cleared 
+	for (dgInt32 i = 0; i < 2; i ++) {
+		dgBuffer* const buffer = m_buffers[i];
+		const dgInt32 index = bodyIndex[i];
+		if ((index >= 0) && (index < buffer->m_bodiesCount) && (buffer->m_bodies[index].m_body == body)) {
+			buffer->m_bodies[index].m_body = NULL;
+		}
+	}
+
+	// a query that read the entry before it was cleared may still be using the body, wait for all readers to leave before it is destroyed
+	for (dgInt32 i = 0; i < 2; i ++) {
+		while (dgAtomicExchangeAndAdd (&m_buffers[i]->m_readers, 0)) {
+			dgThreadYield();
+		}
+	}
+}
+
+dgBroadPhaseSnapshot::dgBuffer* dgBroadPhaseSnapshot::AcquireFront () const
+{
+	// the front index is read again after the reader is registered, if a swap happened in between try the new front 
+	for (;;) {
+		const dgInt32 front = m_front;
+		dgBuffer* const buffer = m_buffers[front];
+		dgAtomicExchangeAndAdd (&buffer->m_readers, 1);
+		if (front == m_front) {
+			return buffer;
+		}
+		dgAtomicExchangeAndAdd (&buffer->m_readers, -1);
+	}
+}
+
+void dgBroadPhaseSnapshot::ReleaseFront (dgBuffer* const buffer) const
+{
+	dgAtomicExchangeAndAdd (&buffer->m_readers, -1);
+}
+
+
+void dgBroadPhaseSnapshot::ForEachBodyInAABB (const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
+{
+	dgBuffer* const buffer = AcquireFront ();
+	if (buffer->m_nodesCount) {
+		const dgSnapshotNode* const nodes = &buffer->m_nodes[0];
+		const dgSnapshotBody* const bodies = &buffer->m_bodies[0];
+
+		dgInt32 stack = 0;
+		dgInt32 stackPool[DG_SNAPSHOT_STACK_DEPTH];
+		for (dgInt32 i = 0; i < 2; i ++) {
+			if (buffer->m_roots[i] >= 0) {
+				stackPool[stack] = buffer->m_roots[i];
+				stack ++;
+			}
+		}
+
+		while (stack) {
+			stack --;
+			const dgSnapshotNode& node = nodes[stackPool[stack]];
+			if (dgOverlapTest (node.m_minBox, node.m_maxBox, minBox, maxBox)) {
+				if (node.m_left < 0) {
+					if (node.m_right >= 0) {
+						const dgSnapshotBody& entry = bodies[node.m_right];
+						dgBody* const body = entry.m_body;
+						if (body && dgOverlapTest (entry.m_minBox, entry.m_maxBox, minBox, maxBox)) {
+							if (!callback (body, userData)) {
+								break;
+							}
+						}
+					}
+				} else {
+					stackPool[stack] = node.m_left;
+					stack ++;
+					dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
+
+					stackPool[stack] = node.m_right;
+					stack ++;
+					dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
+				}
+			}
+		}
+	}
+	ReleaseFront (buffer);
+}
+
+
+dgFloat32 dgBroadPhaseSnapshot::RayCastBody (const dgSnapshotBody& entry, const dgLineBox& line, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData, dgFloat32 maxT) const
+{
+	// same as dgBody::RayCast but with the published transform
+	const dgBody* const body = entry.m_body;
+	if (body) {
+		dgVector l0 (line.m_l0);
+		dgVector l1 (line.m_l0 + (line.m_l1 - line.m_l0).Scale4 (dgMin(maxT, dgFloat32 (1.0f))));
+		if (dgRayBoxClip (l0, l1, entry.m_minBox, entry.m_maxBox)) {
+			dgContactPoint contactOut;
+			const dgMatrix& globalMatrix = entry.m_matrix;
+			dgVector localP0 (globalMatrix.UntransformVector (l0));
+			dgVector localP1 (globalMatrix.UntransformVector (l1));
+			dgVector p1p0 (localP1 - localP0);
+			if ((p1p0 % p1p0) > dgFloat32 (1.0e-12f)) {
+				dgFloat32 t = entry.m_collision->RayCast (localP0, localP1, dgFloat32 (1.0f), contactOut, prefilter, body, userData);
+				if (t < dgFloat32 (1.0f)) {
+					dgVector p (globalMatrix.TransformVector(localP0 + (localP1 - localP0).Scale3(t)));
+					dgVector l1l0 (line.m_l1 - line.m_l0);
+					t = ((p - line.m_l0) % l1l0) / (l1l0 % l1l0);
+					if (t < maxT) {
+						dgAssert (t >= dgFloat32 (0.0f));
+						dgAssert (t <= dgFloat32 (1.0f));
+						contactOut.m_normal = globalMatrix.RotateVector (contactOut.m_normal);
+						maxT = filter (body, contactOut.m_collision0, p, contactOut.m_normal, contactOut.m_shapeId0, userData, t);
+					}
+				}
+			}
+		}
+	}
+	return maxT;
+}
+
+void dgBroadPhaseSnapshot::RayCast (const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+{
+	dgVector segment (l1 - l0);
+	dgFloat32 dist2 = segment % segment;
+	if (!filter || (dist2 <= dgFloat32 (1.0e-8f))) {
+		return;
+	}
+
+	dgBuffer* const buffer = AcquireFront ();
+	if (buffer->m_nodesCount) {
+		const dgSnapshotNode* const nodes = &buffer->m_nodes[0];
+		const dgSnapshotBody* const bodies = &buffer->m_bodies[0];
+
+		dgFloat32 distance[DG_SNAPSHOT_STACK_DEPTH];
+		dgInt32 stackPool[DG_SNAPSHOT_STACK_DEPTH];
+
+		dgFastRayTest ray (l0, l1);
+
+		dgInt32 stack = 0;
+		for (dgInt32 i = 0; i < 2; i ++) {
+			const dgInt32 root = buffer->m_roots[i];
+			if (root >= 0) {
+				dgFloat32 dist = ray.BoxIntersect(nodes[root].m_minBox, nodes[root].m_maxBox);
+				dgInt32 j = stack;
+				for ( ; j && (dist > distance[j - 1]); j --) {
+					stackPool[j] = stackPool[j - 1];
+					distance[j] = distance[j - 1];
+				}
+				stackPool[j] = root;
+				distance[j] = dist;
+				stack ++;
+			}
+		}
+
+		dgFloat32 maxParam = dgFloat32 (1.2f);
+
+		dgLineBox line;	
+		line.m_l0 = l0;
+		line.m_l1 = l1;
+
+		dgVector test (line.m_l0 <= line.m_l1);
+		line.m_boxL0 = (line.m_l0 & test) | line.m_l1.AndNot(test);
+		line.m_boxL1 = (line.m_l1 & test) | line.m_l0.AndNot(test);
+
+		while (stack) {
+			stack --;
+			dgFloat32 dist = distance[stack];
+			if (dist > maxParam) {
+				break;
+			} else {
+				const dgSnapshotNode& me = nodes[stackPool[stack]];
+				if (me.m_left < 0) {
+					if (me.m_right >= 0) {
+						dgFloat32 param = RayCastBody (bodies[me.m_right], line, filter, prefilter, userData, maxParam);
+						if (param < maxParam) {
+							maxParam = param;
+							if (maxParam < dgFloat32 (1.0e-8f)) {
+								break;
+							}
+						}
+					}
+				} else {
+					const dgInt32 children[] = {me.m_left, me.m_right};
+					for (dgInt32 i = 0; i < 2; i ++) {
+						const dgSnapshotNode& child = nodes[children[i]];
+						dgFloat32 dist = ray.BoxIntersect(child.m_minBox, child.m_maxBox);
+						if (dist < maxParam) {
+							dgInt32 j = stack;
+							for ( ; j && (dist > distance[j - 1]); j --) {
+								stackPool[j] = stackPool[j - 1];
+								distance[j] = distance[j - 1];
+							}
+							stackPool[j] = children[i];
+							distance[j] = dist;
+							stack++;
+							dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
+						}
+					}
+				}
+			}
+		}
+	}
+	ReleaseFront (buffer);
+}
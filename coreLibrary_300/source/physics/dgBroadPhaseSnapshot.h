@@ -0,0 +1,96 @@
+/* Copyright (c) <2003-2011> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef _DG_BROADPHASE_SNAPSHOT_H_
+#define _DG_BROADPHASE_SNAPSHOT_H_
+
+#include "dgPhysicsStdafx.h"
+#include "dgBroadPhase.h"
+
+class dgBody;
+class dgCollisionInstance;
+
+// a read only copy of the broadphase trees and the body transforms published at the end of each update.
+// queries read the last published buffer from any thread while the next update writes the other one.
+class dgBroadPhaseSnapshot
+{
+	public:
+	DG_MSC_VECTOR_ALIGMENT
+	class dgSnapshotNode
+	{
+		public:
+		dgVector m_minBox;
+		dgVector m_maxBox;
+		// the left child always follows its parent, leafs have no left child and the right index is the body entry
+		dgInt32 m_left;
+		dgInt32 m_right;
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	DG_MSC_VECTOR_ALIGMENT
+	class dgSnapshotBody
+	{
+		public:
+		dgMatrix m_matrix;
+		dgVector m_minBox;
+		dgVector m_maxBox;
+		dgBody* m_body;
+		dgCollisionInstance* m_collision;
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	class dgBuffer
+	{
+		public:
+		dgBuffer (dgMemoryAllocator* const allocator);
+		~dgBuffer ();
+		void Clear ();
+
+		dgArray<dgSnapshotNode> m_nodes;
+		dgArray<dgSnapshotBody> m_bodies;
+		dgInt32 m_nodesCount;
+		dgInt32 m_bodiesCount;
+		dgInt32 m_roots[2];
+		dgInt32 m_readers;
+	};
+
+	DG_CLASS_ALLOCATOR(allocator)
+
+	dgBroadPhaseSnapshot (dgMemoryAllocator* const allocator);
+	~dgBroadPhaseSnapshot ();
+
+	dgBuffer& BeginPublish (dgInt32& bufferIndex);
+	void EndPublish ();
+	void RemoveBody (const dgBody* const body, const dgInt32* const bodyIndex);
+
+	void RayCast (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
+	void ForEachBodyInAABB (const dgVector& q0, const dgVector& q1, OnBodiesInAABB callback, void* const userData) const;
+
+	private:
+	dgBuffer* AcquireFront () const;
+	void ReleaseFront (dgBuffer* const buffer) const;
+	dgFloat32 RayCastBody (const dgSnapshotBody& entry, const dgLineBox& line, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData, dgFloat32 maxT) const;
+
+	dgBuffer m_buffer0;
+	dgBuffer m_buffer1;
+	dgBuffer* m_buffers[2];
+	dgInt32 m_front;
+};
+
+#endif
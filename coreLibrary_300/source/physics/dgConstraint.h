@@ -221,6 +221,7 @@ class dgConstraint
 	ConstraintsForceFeeback m_updaFeedbackCallback;
 	dgUnsigned32 m_dynamicsLru;
 	dgUnsigned32 m_index;
+	dgInt32 m_solverColor;
 	
 	dgUnsigned32 m_maxDOF			:  6;
 	dgUnsigned32 m_constId			:  6;		
@@ -249,6 +250,7 @@ inline dgConstraint::dgConstraint()
 	,m_updaFeedbackCallback(NULL)
 	,m_dynamicsLru(0)
 	,m_index(0)
+	,m_solverColor(-1)
 	,m_maxDOF(6)
 	,m_constId(m_unknownConstraint)
 	,m_enableCollision(false)
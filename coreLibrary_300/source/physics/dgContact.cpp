@@ -335,6 +335,10 @@ dgCollidingPairCollector::dgCollidingPairCollector ()
 	,m_sentinel(NULL)
 	,m_lock()
 {
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		m_threadPairSlot[i] = -1;
+		m_slotPairsCount[i] = 0;
+	}
 }
 
 dgCollidingPairCollector::~dgCollidingPairCollector ()
@@ -381,15 +385,27 @@ void dgCollidingPairCollector::AddPair (dgContact* const contact, dgInt32 thread
 			dgAssert (!body0->m_collision->IsType (dgCollision::dgCollisionNull_RTTI));
 			dgAssert (!body1->m_collision->IsType (dgCollision::dgCollisionNull_RTTI));
 
-			dgThreadHiveScopeLock lock (world, &m_lock);
-			if (world->m_pairMemoryBuffer.ExpandCapacityIfNeessesary (m_count, sizeof (dgPair))) {
-				m_maxSize = dgInt32 (world->m_pairMemoryBuffer.GetBytesCapacity() / sizeof (dgPair));
+			const dgInt32 slot = m_threadPairSlot[threadIndex];
+			if (slot >= 0) {
+				// task graph update, the pair job running on this thread owns the slot buffer, so there is no need for a lock
+				dgArray<dgUnsigned8>* const pairBuffer = world->m_pairSlotMemory[slot];
+				pairBuffer->ExpandCapacityIfNeessesary (m_slotPairsCount[slot], sizeof (dgPair));
+				dgPair* const pairs = (dgPair*) &(*pairBuffer)[0];
+				dgPair* const pair = &pairs[m_slotPairsCount[slot]];
+				m_slotPairsCount[slot] ++;
+				pair->m_contact = contact;
+				pair->m_isDeformable = 0;
+			} else {
+				dgThreadHiveScopeLock lock (world, &m_lock);
+				if (world->m_pairMemoryBuffer.ExpandCapacityIfNeessesary (m_count, sizeof (dgPair))) {
+					m_maxSize = dgInt32 (world->m_pairMemoryBuffer.GetBytesCapacity() / sizeof (dgPair));
+				}
+				dgPair* const pairs = (dgPair*) &world->m_pairMemoryBuffer[0];
+				dgPair* const pair = &pairs[m_count];
+				m_count ++;
+				pair->m_contact = contact;
+				pair->m_isDeformable = 0;
 			}
-			dgPair* const pairs = (dgPair*) &world->m_pairMemoryBuffer[0];
-			dgPair* const pair = &pairs[m_count];
-			m_count ++;
-			pair->m_contact = contact;
-			pair->m_isDeformable = 0;
 		}
 	}
 }
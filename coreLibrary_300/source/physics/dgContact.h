@@ -69,6 +69,8 @@ class dgCollidingPairCollector
 	
 	dgInt32 m_count;
 	dgInt32 m_maxSize;
+	dgInt32 m_threadPairSlot[DG_MAX_THREADS_HIVE_COUNT];
+	dgInt32 m_slotPairsCount[DG_MAX_THREADS_HIVE_COUNT];
 	dgBody* m_sentinel;
 	dgThread::dgCriticalSection m_lock;
 };
@@ -53,6 +53,8 @@
 
 #define DG_CONTACT_TRANSLATION_ERROR (dgFloat32 (1.0e-3f))
 #define DG_CONTACT_ANGULAR_ERROR (dgFloat32 (0.25f * 3.141592f / 180.0f))
+#define DG_CONTACT_WARM_START_RADIUS (dgFloat32 (2.0f))
+#define DG_CONTACT_WARM_START_NORMAL_COS (dgFloat32 (0.9f))
 dgVector dgWorld::m_angularContactError2 (DG_CONTACT_ANGULAR_ERROR * DG_CONTACT_ANGULAR_ERROR);
 dgVector dgWorld::m_linearContactError2 (DG_CONTACT_TRANSLATION_ERROR * DG_CONTACT_TRANSLATION_ERROR);
 
@@ -794,6 +796,11 @@ void dgWorld::PopulateContacts (dgCollidingPairCollector::dgPair* const pair, dg
 		dgAssert (dgAbsf((controlDir0 * controlDir1) % controlNormal - dgFloat32 (1.0f)) < dgFloat32 (1.0e-3f));
 	}
 
+	// a point that is within a few merge distances of a point of the last update is the same contact, 
+	// it keeps its forces so that the solver starts from last update solution
+	dgFloat32 warmStartDist2 = DG_CONTACT_WARM_START_RADIUS * m_contactTolerance;
+	warmStartDist2 *= warmStartDist2;
+
 	dgFloat32 maxImpulse = dgFloat32 (-1.0f);
 //	dgFloat32 breakImpulse0 = dgFloat32 (0.0f);
 //	dgFloat32 breakImpulse1 = dgFloat32 (0.0f);
@@ -812,15 +819,25 @@ void dgWorld::PopulateContacts (dgCollidingPairCollector::dgPair* const pair, dg
 			}
 		}
 
+		bool persistent = false;
+		dgFloat32 persistentNormalForce = dgFloat32 (0.0f);
+		dgVector persistentNormal (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
+		dgVector persistentTangentForce (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
 		if (contactNode) {
 			count --;
 			dgAssert (index != -1);
 			nodes[index] = nodes[count];
 			cachePosition[index] = cachePosition[count];
+			persistent = (min < warmStartDist2);
+			if (persistent) {
+				// only a matched node holds the forces of last update, a new node is not initialized yet
+				const dgContactMaterial& oldContact = contactNode->GetInfo();
+				persistentNormal = oldContact.m_normal;
+				persistentNormalForce = oldContact.m_normal_Force.m_force;
+				persistentTangentForce = oldContact.m_dir0.Scale3 (oldContact.m_dir0_Force.m_force) + oldContact.m_dir1.Scale3 (oldContact.m_dir1_Force.m_force);
+			}
 		} else {
-			GlobalLock();
 			contactNode = list.Append ();
-			GlobalUnlock();
 		}
 
 		dgContactMaterial* const contactMaterial = &contactNode->GetInfo();
@@ -914,14 +931,24 @@ void dgWorld::PopulateContacts (dgCollidingPairCollector::dgPair* const pair, dg
 		contactMaterial->m_normal.m_w = dgFloat32 (0.0f);
 		contactMaterial->m_dir0.m_w = dgFloat32 (0.0f); 
 		contactMaterial->m_dir1.m_w = dgFloat32 (0.0f); 
-	}
 
-	if (count) {
-		GlobalLock();
-		for (dgInt32 i = 0; i < count; i ++) {
-			list.Remove(nodes[i]);
+		if (persistent && ((contactMaterial->m_normal % persistentNormal) > DG_CONTACT_WARM_START_NORMAL_COS)) {
+			// the friction directions change every update, project last friction force on the new ones
+			contactMaterial->m_normal_Force.m_force = persistentNormalForce;
+			contactMaterial->m_dir0_Force.m_force = persistentTangentForce % contactMaterial->m_dir0;
+			contactMaterial->m_dir1_Force.m_force = persistentTangentForce % contactMaterial->m_dir1;
+		} else {
+			contactMaterial->m_normal_Force.m_force = dgFloat32 (0.0f);
+			contactMaterial->m_normal_Force.m_impact = dgFloat32 (0.0f);
+			contactMaterial->m_dir0_Force.m_force = dgFloat32 (0.0f);
+			contactMaterial->m_dir0_Force.m_impact = dgFloat32 (0.0f);
+			contactMaterial->m_dir1_Force.m_force = dgFloat32 (0.0f);
+			contactMaterial->m_dir1_Force.m_impact = dgFloat32 (0.0f);
 		}
-		GlobalUnlock();
+	}
+
+	for (dgInt32 i = 0; i < count; i ++) {
+		list.Remove(nodes[i]);
 	}
 
 	contact->m_maxDOF = dgUnsigned32 (3 * contact->GetCount());
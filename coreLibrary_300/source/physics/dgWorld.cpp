@@ -35,6 +35,7 @@
 #include "dgCollisionCylinder.h"
 #include "dgCollisionInstance.h"
 #include "dgCollisionCompound.h"
+#include "dgWorldRecorder.h"
 #include "dgWorldDynamicUpdate.h"
 #include "dgCollisionConvexHull.h"
 #include "dgCollisionChamferCylinder.h"
@@ -223,6 +224,7 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	,m_sentinelBody(NULL)
 	,m_pointCollision(NULL)
 	,m_amp(NULL)
+	,m_recorder(NULL)
 	,m_preListener(allocator)
 	,m_postListener(allocator)
 	,m_perInstanceData(allocator)
@@ -232,6 +234,7 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	,m_pairMemoryBuffer (DG_INITIAL_CONTACT_SIZE, allocator, 64)
 	,m_solverMatrixMemory (DG_INITIAL_JACOBIAN_SIZE, allocator, 64)
 	,m_solverRightSideMemory (DG_INITIAL_BODIES_SIZE, allocator, 64)
+	,m_frameArena (allocator)
 {
 	dgMutexThread* const mutexThread = this;
 	SetMatertThread (mutexThread);
@@ -250,6 +253,12 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	m_genericLRUMark = 0;
 
 	m_useParallelSolver = 0;
+	m_useParallelSolverSimdBlocks = 0;
+	m_useTaskGraph = 0;
+
+	m_solverResidualTolerance = dgFloat32 (0.0f);
+	m_solverMinIterations = 0;
+	m_solverMaxIterations = 0;
 
 	//m_solverMode = 0;
 	m_solverMode = 1;
@@ -300,6 +309,9 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	//dgBroadPhase::Init ();
 	m_broadPhase = new (allocator) dgBroadPhase(this);
 	dgCollidingPairCollector::Init ();
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		m_pairSlotMemory[i] = new (allocator) dgArray<dgUnsigned8> (DG_INITIAL_CONTACT_SIZE, allocator, 64);
+	}
 	
 	//m_pointCollision = new (m_allocator) dgCollisionPoint(m_allocator);
 	dgCollision* const pointCollison = new (m_allocator) dgCollisionPoint(m_allocator);
@@ -320,6 +332,8 @@ dgWorld::~dgWorld()
 	dgAsyncThread::Terminate();
 	dgMutexThread::Terminate();
 
+	StopRecording();
+
 	#ifdef _NEWTON_AMP
 	if (m_amp) {
 		delete m_amp;
@@ -336,12 +350,87 @@ dgWorld::~dgWorld()
 
 
 	delete m_broadPhase;
+
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		delete m_pairSlotMemory[i];
+	}
 }
 
 void dgWorld::SetThreadsCount (dgInt32 count)
 {
 	dgThreadHive::SetThreadsCount(count);
 	dgThreadHive::SetPerfomanceCounter(m_getPerformanceCount);
+	if (HasThreadAffinity()) {
+		BindThreadMemory();
+	}
+}
+
+void dgWorld::BindThreadMemory ()
+{
+	// the solver buffers are reallocated by a pinned worker, so that linux first touch policy places them on its numa node.
+	// a single job needs no barrier between the workers, so this also works when the hive runs the jobs inline.
+	QueueJob (BindThreadMemoryKernel, this, this);
+	SynchronizationBarrier();
+}
+
+void dgWorld::BindThreadMemoryKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgWorld* const world = (dgWorld*) worldContext;
+	world->m_solverMatrixMemory.Resize (world->m_solverMatrixMemory.GetElementsCapacity());
+	world->m_solverRightSideMemory.Resize (world->m_solverRightSideMemory.GetElementsCapacity());
+}
+
+void dgWorld::ReserveFrameArena (dgInt32 sizeInBytes)
+{
+	dgAssert (m_inUpdate == 0);
+	m_frameArena.Reserve (sizeInBytes);
+}
+
+dgInt32 dgWorld::GetFrameArenaPeak (dgInt32 threadIndex) const
+{
+	if (threadIndex < 0) {
+		dgInt32 peak = 0;
+		for (dgInt32 i = 0; i <= DG_FRAME_ARENA_SERIAL; i ++) {
+			peak += m_frameArena.GetPeak (i);
+		}
+		return peak;
+	}
+	return m_frameArena.GetPeak ((threadIndex >= GetThreadCount()) ? DG_FRAME_ARENA_SERIAL : threadIndex);
+}
+
+bool dgWorld::StartRecording (const char* const fileName)
+{
+	dgAssert (m_inUpdate == 0);
+	StopRecording();
+	m_recorder = new (m_allocator) dgWorldRecorder (this);
+	if (!m_recorder->StartRecording (fileName)) {
+		StopRecording();
+		return false;
+	}
+	return true;
+}
+
+void dgWorld::StopRecording ()
+{
+	if (m_recorder) {
+		delete m_recorder;
+		m_recorder = NULL;
+	}
+}
+
+dgInt32 dgWorld::Replay (const char* const fileName, dgWorldRecorder::OnReplayStep callback, void* const userData)
+{
+	dgAssert (m_inUpdate == 0);
+	StopRecording();
+	m_recorder = new (m_allocator) dgWorldRecorder (this);
+	dgInt32 frame = m_recorder->Replay (fileName, callback, userData);
+	StopRecording();
+	return frame;
+}
+
+dgUnsigned32 dgWorld::CalculateStateCRC () const
+{
+	return dgWorldRecorder::CalculateStateCRC (this);
 }
 
 dgUnsigned32 dgWorld::GetPerformanceCount ()
@@ -445,6 +534,40 @@ dgInt32 dgWorld::GetThreadOnSingleIsland() const
 	return m_useParallelSolver ? 1 : 0;
 }
 
+void dgWorld::SetParallelSolverSimdBlocks(dgInt32 mode)
+{
+	m_useParallelSolverSimdBlocks = mode ? 1 : 0;
+}
+
+dgInt32 dgWorld::GetParallelSolverSimdBlocks() const
+{
+	return m_useParallelSolverSimdBlocks ? 1 : 0;
+}
+
+void dgWorld::SetSolverAdaptiveIterations (dgFloat32 residual, dgInt32 minIterations, dgInt32 maxIterations)
+{
+	m_solverResidualTolerance = dgMax (residual, dgFloat32 (0.0f));
+	m_solverMinIterations = dgMax (minIterations, 1);
+	m_solverMaxIterations = dgMax (maxIterations, m_solverMinIterations);
+}
+
+void dgWorld::GetSolverAdaptiveIterations (dgFloat32& residual, dgInt32& minIterations, dgInt32& maxIterations) const
+{
+	residual = m_solverResidualTolerance;
+	minIterations = m_solverMinIterations;
+	maxIterations = m_solverMaxIterations;
+}
+
+void dgWorld::SetTaskGraphStepMode(dgInt32 mode)
+{
+	m_useTaskGraph = mode ? 1 : 0;
+}
+
+dgInt32 dgWorld::GetTaskGraphStepMode() const
+{
+	return m_useTaskGraph ? 1 : 0;
+}
+
 
 void dgWorld::SetFrictionThreshold (dgFloat32 acceleration)
 {
@@ -486,7 +609,33 @@ void dgWorld::DestroyAllBodies ()
 }
 
 
+class dgBodiesBatchDescriptor
+{
+	public:
+	dgBodiesBatchDescriptor (dgBody** const bodies, dgInt32 count)
+		:m_bodies(bodies)
+		,m_count(count)
+		,m_atomicIndex(0)
+	{
+	}
+
+	dgBody** m_bodies;
+	dgInt32 m_count;
+	dgInt32 m_atomicIndex;
+};
+
 void dgWorld::InitBody (dgBody* const body, dgCollisionInstance* const collision, const dgMatrix& matrix)
+{
+	SetupBody (body, collision);
+	body->SetMatrix (matrix);
+	m_broadPhase->Add (body);
+
+	if (m_recorder) {
+		m_recorder->BodyCreated (body);
+	}
+}
+
+void dgWorld::SetupBody (dgBody* const body, dgCollisionInstance* const collision)
 {
 	dgAssert (collision);
 
@@ -506,8 +655,75 @@ void dgWorld::InitBody (dgBody* const body, dgCollisionInstance* const collision
 	body->m_bodyGroupId = dgInt32 (m_defualtBodyGroupID);
 
 	body->SetMassMatrix (DG_INFINITE_MASS * dgFloat32 (2.0f), DG_INFINITE_MASS, DG_INFINITE_MASS, DG_INFINITE_MASS);
-	body->SetMatrix (matrix);
-	m_broadPhase->Add (body);
+}
+
+void dgWorld::CreateBodiesBatch (dgBody** const bodies, dgInt32 count, dgBody::dgRTTI bodyType, dgCollisionInstance* const* const collisions, const dgMatrix* const matrices, const dgFloat32* const masses)
+{
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBody* body = NULL;
+		switch (bodyType) 
+		{
+			case dgBody::m_kinematicBodyRTTI:
+				body = new (m_allocator) dgKinematicBody();
+				break;
+			case dgBody::m_deformableBodyRTTI:
+				body = new (m_allocator) dgDeformableBody();
+				break;
+			default:
+				dgAssert (bodyType == dgBody::m_dynamicBodyRTTI);
+				body = new (m_allocator) dgDynamicBody();
+		}
+		dgAssert ((dgUnsigned64 (body) & 0xf) == 0);
+		bodies[i] = body;
+	}
+
+	if (m_inUpdate || (bodyType == dgBody::m_deformableBodyRTTI)) {
+		// bodies made from a callback are added the same way as single bodies, 
+		// and so are deformable bodies, their virtual SetMatrix also places the deformable mesh
+		for (dgInt32 i = 0; i < count; i ++) {
+			InitBody (bodies[i], collisions[i], matrices[i]);
+			if (masses && (masses[i] > dgFloat32 (0.0f))) {
+				bodies[i]->SetMassProperties (masses[i], bodies[i]->GetCollision());
+			}
+		}
+		return;
+	}
+
+	// the list and allocator work is serial, the collision matrices and boxes are calculated by the hive 
+	// and all the new bodies enter the broadphase as one subtree.
+	// the mass is set before that, so the bodies with mass go to the dynamic tree and the rest to the static tree
+	for (dgInt32 i = 0; i < count; i ++) {
+		SetupBody (bodies[i], collisions[i]);
+		bodies[i]->SetMatrixOriginAndRotation (matrices[i]);
+		if (masses && (masses[i] > dgFloat32 (0.0f))) {
+			bodies[i]->SetMassProperties (masses[i], bodies[i]->GetCollision());
+		}
+	}
+
+	dgBodiesBatchDescriptor descriptor (bodies, count);
+	const dgInt32 threadsCount = GetThreadCount();
+	for (dgInt32 i = 0; i < threadsCount; i ++) {
+		QueueJob (UpdateBodiesCollisionKernel, &descriptor, this);
+	}
+	SynchronizationBarrier();
+
+	m_broadPhase->AddBodies (bodies, count);
+
+	if (m_recorder) {
+		for (dgInt32 i = 0; i < count; i ++) {
+			m_recorder->BodyCreated (bodies[i]);
+		}
+	}
+}
+
+void dgWorld::UpdateBodiesCollisionKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgBodiesBatchDescriptor* const descriptor = (dgBodiesBatchDescriptor*) context;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1); i < descriptor->m_count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicIndex, 1)) {
+		dgBody* const body = descriptor->m_bodies[i];
+		dgAssert (!body->m_collisionCell);
+		body->UpdateCollisionMatrix (dgFloat32 (0.0f), threadID);
+	}
 }
 
 void dgWorld::BodyEnableSimulation (dgBody* const body)
@@ -569,6 +785,56 @@ dgBody* dgWorld::CreateDeformableBody(dgCollisionInstance* const collision, cons
 
 
 void dgWorld::DestroyBody(dgBody* const body)
+{
+	CallBodyDestroyCallbacks (body);
+	m_broadPhase->RemoveFromSnapshot (body);
+	
+	if (m_disableBodies.Find(body)) {
+		m_disableBodies.Remove(body);
+	} else {
+		m_broadPhase->Remove (body);
+		dgBodyMasterList::RemoveBody (body);
+	}
+
+	dgAssert (body->m_collision);
+	body->m_collision->Release();
+	delete body;
+}
+
+void dgWorld::DestroyBodiesBatch (dgBody** const bodies, dgInt32 count)
+{
+	if (m_inUpdate) {
+		for (dgInt32 i = 0; i < count; i ++) {
+			DestroyBody (bodies[i]);
+		}
+		return;
+	}
+
+	// disabled bodies are not in the broadphase, take them out of the array and destroy them first
+	dgInt32 activeCount = 0;
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBody* const body = bodies[i];
+		if (m_disableBodies.Find(body)) {
+			DestroyBody (body);
+		} else {
+			CallBodyDestroyCallbacks (body);
+			m_broadPhase->RemoveFromSnapshot (body);
+			bodies[activeCount] = body;
+			activeCount ++;
+		}
+	}
+
+	m_broadPhase->RemoveBodies (bodies, activeCount);
+	for (dgInt32 i = 0; i < activeCount; i ++) {
+		dgBody* const body = bodies[i];
+		dgBodyMasterList::RemoveBody (body);
+		dgAssert (body->m_collision);
+		body->m_collision->Release();
+		delete body;
+	}
+}
+
+void dgWorld::CallBodyDestroyCallbacks (dgBody* const body)
 {
 	for (dgListenerList::dgListNode* node = m_postListener.GetLast(); node; node = node->GetPrev()) {
 		dgListener& listener = node->GetInfo();
@@ -585,20 +851,13 @@ void dgWorld::DestroyBody(dgBody* const body)
 	}
 
 
+	if (m_recorder) {
+		m_recorder->BodyDestroyed (body);
+	}
+
 	if (body->m_destructor) {
 		body->m_destructor (*body);
 	}
-	
-	if (m_disableBodies.Find(body)) {
-		m_disableBodies.Remove(body);
-	} else {
-		m_broadPhase->Remove (body);
-		dgBodyMasterList::RemoveBody (body);
-	}
-
-	dgAssert (body->m_collision);
-	body->m_collision->Release();
-	delete body;
 }
 
 
@@ -623,6 +882,8 @@ void dgWorld::SetPerfomanceCounter(OnGetPerformanceCountCallback callback)
 	m_getPerformanceCount = callback;
 	memset (m_perfomanceCounters, 0, sizeof (m_perfomanceCounters));
 	memset (m_perfomanceCountersBack, 0, sizeof (m_perfomanceCountersBack));
+	memset (&m_counters, 0, sizeof (m_counters));
+	memset (&m_countersBack, 0, sizeof (m_countersBack));
 }
 
 
@@ -632,6 +893,11 @@ dgUnsigned32 dgWorld::GetPerfomanceTicks (dgUnsigned32 entry) const
 	return m_perfomanceCountersBack[entry];
 }
 
+const dgWorldCounters& dgWorld::GetCounters () const
+{
+	return m_countersBack;
+}
+
 dgUnsigned32 dgWorld::GetThreadPerfomanceTicks (dgUnsigned32 threadIndex) const
 {
 	return dgThreadHive::GetPerfomanceTicks (threadIndex);
@@ -981,23 +1247,48 @@ void dgWorld::StepDynamics (dgFloat32 timestep)
 
 	dgThreadHive::ClearTimers();
 	memset (m_perfomanceCounters, 0, sizeof (m_perfomanceCounters));
+	memset (&m_counters, 0, sizeof (m_counters));
 	dgUnsigned32 ticks = m_getPerformanceCount();
 
 	m_inUpdate ++;
 	dgAssert (GetThreadCount() >= 1);
+	DG_PROFILER_EVENT (this, "StepDynamics", DG_PROFILER_MASTER_TRACK);
+	dgWorldCounterScope counterScope (&m_counters, m_worldTicks, DG_WORLD_COUNTERS_MASTER_ROW);
+
+	// everything allocated from the frame arena during the last update is dead now
+	m_frameArena.Reset();
+
+	if (m_recorder) {
+		m_recorder->BeginStep (timestep);
+	}
 
 	m_broadPhase->UpdateContacts (timestep);
 	UpdateDynamics (timestep);
 
+	// bring the broadphase up to date with the new body positions before the post listeners cast rays
+	m_broadPhase->UpdateTreeBounds ();
+
 	if (m_postListener.GetCount()) {
+		dgWorldCounterScope listenerScope (&m_counters, m_postUpdataListerTicks, DG_WORLD_COUNTERS_MASTER_ROW);
 		dgUnsigned32 ticks = m_getPerformanceCount();
 		for (dgListenerList::dgListNode* node = m_postListener.GetFirst(); node; node = node->GetNext()) {
 			dgListener& listener = node->GetInfo();
+			DG_PROFILER_EVENT (this, listener.m_name, DG_PROFILER_MASTER_TRACK);
 			listener.m_onListenerUpdate (this, listener.m_userData, timestep);
 		}
 		m_perfomanceCounters[m_postUpdataListerTicks] = m_getPerformanceCount() - ticks;
 	}
 
+	// the post listeners may have moved bodies
+	m_broadPhase->UpdateQueryCache ();
+
+	// queries on the snapshot see this step from now on, while the next step runs
+	m_broadPhase->PublishSnapshot ();
+
+	if (m_recorder) {
+		m_recorder->EndStep ();
+	}
+
 	m_inUpdate --;
 	m_perfomanceCounters[m_worldTicks] = m_getPerformanceCount() - ticks;
 }
@@ -1030,6 +1321,7 @@ void dgWorld::TickCallback (dgInt32 threadID)
 	if (threadID == DG_MUTEX_THREAD_ID) {
 		StepDynamics (m_savetimestep);
 		memcpy (m_perfomanceCountersBack, m_perfomanceCounters, sizeof (m_perfomanceCounters));
+		memcpy (&m_countersBack, &m_counters, sizeof (m_counters));
 	} else {
 		Update (m_savetimestep);
 	}
@@ -1055,6 +1347,7 @@ void dgWorld::Update (dgFloat32 timestep)
 		// run update in same thread as the calling application as if it was a separate thread  
 		StepDynamics (m_savetimestep);
 		memcpy (m_perfomanceCountersBack, m_perfomanceCounters, sizeof (m_perfomanceCounters));
+		memcpy (&m_countersBack, &m_counters, sizeof (m_counters));
 	#else 
 		// runs the update in a separate thread and wait until the update is completed before it returns.
 		// this will run well on single core systems, since the two thread are mutually exclusive 
@@ -1070,6 +1363,7 @@ void dgWorld::UpdateAsync (dgFloat32 timestep)
 	#ifdef DG_USE_THREAD_EMULATION
 		StepDynamics (m_savetimestep);
 		memcpy (m_perfomanceCountersBack, m_perfomanceCounters, sizeof (m_perfomanceCounters));
+		memcpy (&m_countersBack, &m_counters, sizeof (m_counters));
 	#else 
 		// execute one update, but do not wait for the update to finish, instead return immediately to the caller
 		dgAsyncThread::Tick();
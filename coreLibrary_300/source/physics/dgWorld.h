@@ -29,6 +29,7 @@
 #include "dgBroadPhase.h"
 #include "dgCollisionScene.h"
 #include "dgBodyMasterList.h"
+#include "dgWorldRecorder.h"
 #include "dgWorldDynamicUpdate.h"
 #include "dgDeformableBodiesUpdate.h"
 #include "dgCollisionCompoundFractured.h"
@@ -38,6 +39,7 @@
 
 #define DG_SLEEP_ENTRIES					8
 #define DG_MAX_DESTROYED_BODIES_BY_FORCE	8
+#define DG_SOLVER_ITERATIONS_HISTOGRAM_SIZE	6
 
 
 class dgBody;
@@ -99,6 +101,49 @@ enum dgPerformanceCounters
 	m_counterSize
 };
 
+enum dgWorldCounts
+{
+	m_pairsTestedCount = 0,
+	m_contactPointsCount,
+	m_islandsCount,
+	m_solverRowsCount,
+	m_solverIterationsCount,
+	m_sleepingBodiesCount,
+	m_solverEarlyExitIslandsCount,
+	m_solverIslandIterationsCount,
+
+	m_countsSize = m_solverIslandIterationsCount + DG_SOLVER_ITERATIONS_HISTOGRAM_SIZE
+};
+
+#define DG_WORLD_COUNTERS_MASTER_ROW	DG_MAX_THREADS_HIVE_COUNT
+
+// time in nanoseconds each thread spent in each phase of an update, and the work done in it.
+// each thread only writes its own row, the last row is the thread that called the update.
+class dgWorldCounters
+{
+	public:
+	dgUnsigned64 m_ticks[DG_WORLD_COUNTERS_MASTER_ROW + 1][m_counterSize];
+	dgInt32 m_counts[DG_WORLD_COUNTERS_MASTER_ROW + 1][m_countsSize];
+};
+
+class dgWorldCounterScope
+{
+	public:
+	dgWorldCounterScope (dgWorldCounters* const counters, dgPerformanceCounters phase, dgInt32 threadIndex)
+		:m_ticks(&counters->m_ticks[threadIndex][phase])
+		,m_startTime(dgGetTimeInNanoseconds())
+	{
+	}
+
+	~dgWorldCounterScope ()
+	{
+		*m_ticks += dgGetTimeInNanoseconds() - m_startTime;
+	}
+
+	dgUnsigned64* m_ticks;
+	dgUnsigned64 m_startTime;
+};
+
 class dgWorld;
 class dgCollisionInstance;
 
@@ -208,6 +253,15 @@ class dgWorld
 	void EnableThreadOnSingleIsland(dgInt32 mode);
 	dgInt32 GetThreadOnSingleIsland() const;
 
+	void SetParallelSolverSimdBlocks(dgInt32 mode);
+	dgInt32 GetParallelSolverSimdBlocks() const;
+
+	void SetSolverAdaptiveIterations (dgFloat32 residual, dgInt32 minIterations, dgInt32 maxIterations);
+	void GetSolverAdaptiveIterations (dgFloat32& residual, dgInt32& minIterations, dgInt32& maxIterations) const;
+
+	void SetTaskGraphStepMode(dgInt32 mode);
+	dgInt32 GetTaskGraphStepMode() const;
+
 	void FlushCache();
 	
 	void* GetUserData() const;
@@ -258,7 +312,9 @@ class dgWorld
 	dgDynamicBody* CreateDynamicBody (dgCollisionInstance* const collision, const dgMatrix& matrix);
 	dgKinematicBody* CreateKinematicBody (dgCollisionInstance* const collision, const dgMatrix& matrix);
 	dgBody* CreateDeformableBody (dgCollisionInstance* const collision, const dgMatrix& matrix);
+	void CreateBodiesBatch (dgBody** const bodies, dgInt32 count, dgBody::dgRTTI bodyType, dgCollisionInstance* const* const collisions, const dgMatrix* const matrices, const dgFloat32* const masses);
 	void DestroyBody(dgBody* const body);
+	void DestroyBodiesBatch (dgBody** const bodies, dgInt32 count);
 	void DestroyAllBodies ();
 
 //	void AddToBreakQueue (const dgContact* const contactJoint, dgBody* const body, dgFloat32 maxForce);
@@ -334,7 +390,15 @@ class dgWorld
 	void SetPerfomanceCounter(OnGetPerformanceCountCallback callback);
 
 	void SetThreadsCount (dgInt32 count);
+	void BindThreadMemory ();
+	void ReserveFrameArena (dgInt32 sizeInBytes);
+	dgInt32 GetFrameArenaPeak (dgInt32 threadIndex) const;
+	bool StartRecording (const char* const fileName);
+	void StopRecording ();
+	dgInt32 Replay (const char* const fileName, dgWorldRecorder::OnReplayStep callback, void* const userData);
+	dgUnsigned32 CalculateStateCRC () const;
 	dgUnsigned32 GetPerfomanceTicks (dgUnsigned32 entry) const;
+	const dgWorldCounters& GetCounters () const;
 	dgUnsigned32 GetThreadPerfomanceTicks (dgUnsigned32 threadIndex) const;
 
 	//Parallel Job dispatcher for user related stuff
@@ -404,6 +468,10 @@ class dgWorld
 	void AddSentinelBody();
 	void InitConvexCollision ();
 	static dgUnsigned32 dgApi GetPerformanceCount ();
+	static void BindThreadMemoryKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void UpdateBodiesCollisionKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	void SetupBody (dgBody* const body, dgCollisionInstance* const collision);
+	void CallBodyDestroyCallbacks (dgBody* const body);
 
 	virtual void Execute (dgInt32 threadID);
 	virtual void TickCallback (dgInt32 threadID);
@@ -426,6 +494,11 @@ class dgWorld
 	dgUnsigned32 m_defualtBodyGroupID;
 	dgUnsigned32 m_bodiesUniqueID;
 	dgUnsigned32 m_useParallelSolver;
+	dgUnsigned32 m_useParallelSolverSimdBlocks;
+	dgUnsigned32 m_useTaskGraph;
+	dgFloat32 m_solverResidualTolerance;
+	dgInt32 m_solverMinIterations;
+	dgInt32 m_solverMaxIterations;
 	dgUnsigned32 m_genericLRUMark;
 
 	dgFloat32 m_freezeAccel2;
@@ -443,6 +516,7 @@ class dgWorld
 	dgCollisionInstance* m_pointCollision;
 
 	dgAmpInstance* m_amp;
+	dgWorldRecorder* m_recorder;
 	void* m_userData;
 	dgMemoryAllocator* m_allocator;
 	dgInt32 m_hardwaredIndex;
@@ -454,6 +528,8 @@ class dgWorld
 
 	dgUnsigned32 m_perfomanceCounters[m_counterSize];	
 	dgUnsigned32 m_perfomanceCountersBack[m_counterSize];	
+	dgWorldCounters m_counters;
+	dgWorldCounters m_countersBack;
 
 	dgListenerList m_preListener;
 	dgListenerList m_postListener;
@@ -464,6 +540,8 @@ class dgWorld
 	dgArray<dgUnsigned8> m_pairMemoryBuffer;
 	dgArray<dgUnsigned8> m_solverMatrixMemory;  
 	dgArray<dgUnsigned8> m_solverRightSideMemory;
+	dgArray<dgUnsigned8>* m_pairSlotMemory[DG_MAX_THREADS_HIVE_COUNT];
+	dgFrameArena m_frameArena;
 	
 	static dgVector m_linearContactError2;
 	static dgVector m_angularContactError2;
@@ -474,6 +552,7 @@ class dgWorld
 	friend class dgDeformableBody;
 	friend class dgActiveContacts;
 	friend class dgUserConstraint;
+	friend class dgWorldRecorder;
 	friend class dgBodyMasterList;
 	friend class dgJacobianMemory;
 	friend class dgCollisionScene;
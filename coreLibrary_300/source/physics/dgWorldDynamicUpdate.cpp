@@ -38,6 +38,8 @@
 
 
 #define DG_PARALLEL_JOINT_COUNT_CUT_OFF		(4 * DG_MAX_THREADS_HIVE_COUNT)
+#define DG_ISLAND_BATCHES_PER_THREAD		8
+#define DG_ISLAND_COST_MAX_EXACT_PASSES		64
 #define DG_CCD_EXTRA_CONTACT_COUNT			(8 * 3)
 
 
@@ -56,6 +58,12 @@ class dgWorldDynamicUpdateSyncDescriptor
 	
 	dgInt32 m_islandCount;
 	dgInt32 m_firstIsland;
+	dgInt32 m_roleCounter;
+	dgInt32 m_teamCount;
+	dgInt32 m_batchCount;
+	dgInt32 m_parallelJointCount;
+	dgInt32* m_batchStart;
+	dgParallelSolverTeam* m_teams;
 	dgThread::dgCriticalSection* m_criticalSection;
 };
 
@@ -79,6 +87,8 @@ dgWorldDynamicUpdate::dgWorldDynamicUpdate()
 	,m_joints(0)
 	,m_islands(0)
 	,m_markLru(0)
+	,m_treeQueueSize(0)
+	,m_treeQueuePool(NULL)
 //	,m_rowCountAtomicIndex(0)
 	,m_softBodyCriticalSectionLock()
 {
@@ -88,6 +98,9 @@ dgWorldDynamicUpdate::dgWorldDynamicUpdate()
 void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 {
 	dgWorld* const world = (dgWorld*) this;
+	DG_PROFILER_EVENT (world, "UpdateDynamics", DG_PROFILER_MASTER_TRACK);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsTicks, DG_WORLD_COUNTERS_MASTER_ROW);
+	dgUnsigned64 spanningTreeTime = dgGetTimeInNanoseconds();
 	dgUnsigned32 updateTime = world->m_getPerformanceCount();
 
 	world->m_dynamicsLru = world->m_dynamicsLru + DG_BODY_LRU_STEP;
@@ -101,7 +114,9 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 
 	dgBodyMasterList& me = *world;
 
-	world->m_pairMemoryBuffer.ExpandCapacityIfNeessesary (4 * me.GetCount(), sizeof (dgBody*));
+	// the first half is the breadth first queue, the second half collects the static bodies of the island
+	m_treeQueueSize = 4 * me.GetCount();
+	m_treeQueuePool = (dgDynamicBody**) world->m_frameArena.Alloc (m_treeQueueSize * sizeof (dgDynamicBody*));
 
 	dgAssert (me.GetFirst()->GetInfo().GetBody() == world->m_sentinelBody);
 
@@ -109,6 +124,7 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 	sentinelBody->m_index = 0; 
 	sentinelBody->m_dynamicsLru = m_markLru;
 
+	dgInt32 sleepingCount = 0;
 	for (dgBodyMasterList::dgListNode* node = me.GetLast(); node; node = node->GetPrev()) {
 		const dgBodyMasterListRow& graphNode = node->GetInfo();
 		dgBody* const body = graphNode.GetBody();	
@@ -126,6 +142,7 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 
 		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
 			dgDynamicBody* const dynamicBody = (dgDynamicBody*) body;
+			sleepingCount += dynamicBody->m_sleeping ? 1 : 0;
 			if (dynamicBody->m_dynamicsLru < lru) {
 				if (!(dynamicBody->m_freeze | dynamicBody->m_spawnnedFromCallback | dynamicBody->m_sleeping)) {
 					SpanningTree (dynamicBody, timestep);
@@ -143,6 +160,11 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 	}
 	m_solverMemory.Init (world, maxRowCount, m_bodies);
 
+	dgInt32* const counts = world->m_counters.m_counts[DG_WORLD_COUNTERS_MASTER_ROW];
+	counts[m_islandsCount] = m_islands;
+	counts[m_solverRowsCount] = maxRowCount;
+	counts[m_sleepingBodiesCount] = sleepingCount;
+
 //	m_rowCountAtomicIndex = 0;
 
 	dgInt32 threadCount = world->GetThreadCount();	
@@ -165,22 +187,69 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 
 	dgUnsigned32 dynamicsTime = world->m_getPerformanceCount();
 	world->m_perfomanceCounters[m_dynamicsBuildSpanningTreeTicks] = dynamicsTime - updateTime;
+	world->m_counters.m_ticks[DG_WORLD_COUNTERS_MASTER_ROW][m_dynamicsBuildSpanningTreeTicks] += dgGetTimeInNanoseconds() - spanningTreeTime;
 
 	if (!(world->m_amp && (world->m_hardwaredIndex > 0))) {
 		dgInt32 index = 0;
+		descriptor.m_teamCount = 0;
+		descriptor.m_parallelJointCount = 0x7fffffff;
 		if (world->m_useParallelSolver && (threadCount > 1)) {
+			descriptor.m_parallelJointCount = DG_PARALLEL_JOINT_COUNT_CUT_OFF;
+			dgInt64 totalCost = 0;
+			for (dgInt32 i = 0; i < m_islands; i ++) {
+				totalCost += islandsArray[i].m_solverCost;
+			}
+
+			// an island with almost all the work is solved by the whole hive
 			for ( ; (index < m_islands) && (islandsArray[index].m_jointCount >= DG_PARALLEL_JOINT_COUNT_CUT_OFF); index ++) {
-				int i = index + 1;
-				if ((i < m_islands) && (islandsArray[index].m_jointCount < (2 * islandsArray[i].m_jointCount))) { 
+				dgInt64 cost = islandsArray[index].m_solverCost;
+				if ((cost * threadCount) < (totalCost * (threadCount - 1))) {
+					break;
+				}
+				CalculateReactionForcesParallel (&islandsArray[index], timestep, NULL, 0);
+				totalCost -= cost;
+			}
+
+			// an island with more than the fair share of one thread gets a team sized to its cost, all the teams run at the same time as the small islands
+			descriptor.m_teams = (dgParallelSolverTeam*) world->m_frameArena.Alloc ((threadCount / 2) * sizeof (dgParallelSolverTeam));
+			dgInt32 freeThreads = threadCount;
+			for ( ; (index < m_islands) && (freeThreads >= 2) && (islandsArray[index].m_jointCount >= DG_PARALLEL_JOINT_COUNT_CUT_OFF); index ++) {
+				dgInt32 teamSize = dgInt32 ((dgInt64 (islandsArray[index].m_solverCost) * threadCount + totalCost / 2) / totalCost);
+				if (teamSize < 2) {
 					break;
 				}
-				CalculateReactionForcesParallel (&islandsArray[index], timestep);
+				dgParallelSolverTeam* const team = &descriptor.m_teams[descriptor.m_teamCount];
+				memset (team, 0, sizeof (dgParallelSolverTeam));
+				team->m_island = &islandsArray[index];
+				team->m_threadCount = dgMin (teamSize, freeThreads);
+				freeThreads -= team->m_threadCount;
+				descriptor.m_teamCount ++;
 			}
 		}
 
+		// pack the small islands in batches of similar cost, the islands are sorted by cost so the batches get longer toward the end
+		dgInt64 smallCost = 0;
+		for (dgInt32 i = index; i < m_islands; i ++) {
+			smallCost += islandsArray[i].m_solverCost;
+		}
+		dgInt64 batchCost = dgMax (smallCost / (threadCount * DG_ISLAND_BATCHES_PER_THREAD), dgInt64 (1));
+		descriptor.m_batchStart = (dgInt32*) world->m_frameArena.Alloc ((m_islands - index + 1) * sizeof (dgInt32));
+		descriptor.m_batchCount = 0;
+		dgInt64 cost = batchCost;
+		for (dgInt32 i = index; i < m_islands; i ++) {
+			if (cost >= batchCost) {
+				descriptor.m_batchStart[descriptor.m_batchCount] = i;
+				descriptor.m_batchCount ++;
+				cost = 0;
+			}
+			cost += islandsArray[i].m_solverCost;
+		}
+		descriptor.m_batchStart[descriptor.m_batchCount] = m_islands;
+
 		descriptor.m_firstIsland = index;
 		descriptor.m_islandCount = m_islands - index;
 		descriptor.m_atomicCounter = 0;
+		descriptor.m_roleCounter = 0;
 		for (dgInt32 i = 0; i < threadCount; i ++) {
 			world->QueueJob (CalculateIslandReactionForcesKernel, &descriptor, world);
 		}
@@ -198,14 +267,28 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 
 	// integrate soft body dynamics phase 2
 	dgDeformableBodiesUpdate* const softBodyList = world;
+	dgUnsigned64 softBodyTime = dgGetTimeInNanoseconds();
     softBodyList->SolveConstraintsAndIntegrate (timestep);
+	world->m_counters.m_ticks[DG_WORLD_COUNTERS_MASTER_ROW][m_softBodyTicks] += dgGetTimeInNanoseconds() - softBodyTime;
 	world->m_perfomanceCounters[m_softBodyTicks] += (world->m_getPerformanceCount() - ticks);
 }
 
 
 
+void dgJacobianMemory::ExpandMatrixMemoryKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgWorld* const world = (dgWorld*) worldContext;
+	const dgInt32 rowsCount = *((dgInt32*) context);
+	world->m_solverMatrixMemory.ExpandCapacityIfNeessesary (rowsCount, sizeof (dgJacobianMatrixElement));
+}
+
 void dgJacobianMemory::Init (dgWorld* const world, dgInt32 rowsCount, dgInt32 bodyCount)
 {
+	if (world->HasThreadAffinity() && (((rowsCount + 1) * dgInt32 (sizeof (dgJacobianMatrixElement))) >= world->m_solverMatrixMemory.GetElementsCapacity())) {
+		// grow the matrix on a pinned worker, so that the new pages are first touched on the worker numa node
+		world->QueueJob (ExpandMatrixMemoryKernel, &rowsCount, world);
+		world->SynchronizationBarrier();
+	}
 	world->m_solverMatrixMemory.ExpandCapacityIfNeessesary (rowsCount, sizeof (dgJacobianMatrixElement));
 	m_memory = (dgJacobianMatrixElement*) &world->m_solverMatrixMemory[0];
 
@@ -220,8 +303,8 @@ void dgJacobianMemory::Init (dgWorld* const world, dgInt32 rowsCount, dgInt32 bo
 // sort from high to low
 dgInt32 dgWorldDynamicUpdate::CompareIslands (const dgIsland* const islandA, const dgIsland* const islandB, void* notUsed)
 {
-	dgInt32 countA = islandA->m_jointCount + (islandA->m_hasExactSolverJoints << 28);
-	dgInt32 countB = islandB->m_jointCount + (islandB->m_hasExactSolverJoints << 28);
+	dgInt32 countA = islandA->m_solverCost;
+	dgInt32 countB = islandB->m_solverCost;
 
 	if (countA < countB) {
 		return 1;
@@ -246,7 +329,7 @@ void dgWorldDynamicUpdate::SpanningTree (dgDynamicBody* const body, dgFloat32 ti
 
 	dgDynamicBody* heaviestBody = NULL;
 	dgWorld* const world = (dgWorld*) this;
-	dgQueue<dgDynamicBody*> queue ((dgDynamicBody**) &world->m_pairMemoryBuffer[0], dgInt32 ((world->m_pairMemoryBuffer.GetBytesCapacity()>>1)/sizeof (void*)));
+	dgQueue<dgDynamicBody*> queue (m_treeQueuePool, m_treeQueueSize >> 1);
 	
 	dgDynamicBody** const staticPool = &queue.m_pool[queue.m_mod];
 
@@ -710,12 +793,63 @@ void dgWorldDynamicUpdate::FindActiveJointAndBodies (void* const context, void*
 	dgWorldDynamicUpdateSyncDescriptor* const descriptor = (dgWorldDynamicUpdateSyncDescriptor*) context;
 
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "FindActiveJointAndBodies", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsBuildSpanningTreeTicks, threadID);
 	dgInt32 count = descriptor->m_islandCount;
 	dgIsland* const islands = &((dgIsland*)&world->m_islandMemory[0])[descriptor->m_firstIsland];
 
 	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
 		dgIsland* const island = &islands[i]; 
 		world->FindActiveJointAndBodies (island); 
+		island->m_solverCost = world->CalculateIslandSolverCost (island);
+	}
+}
+
+
+// rough estimate of the solver work in an island, the rows times the iterations the solver will run on them
+dgInt32 dgWorldDynamicUpdate::CalculateIslandSolverCost (const dgIsland* const island) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	dgInt32 passes = dgInt32 (world->m_solverMode + LINEAR_SOLVER_SUB_STEPS);
+	dgSolverIterationLimits limits;
+	GetSolverIterationLimits (&limits, passes, DG_SOLVER_MAX_ERROR);
+	dgInt32 iterations = limits.m_maxIterations;
+	if (!world->m_solverMode || island->m_hasExactSolverJoints) {
+		// the exact solver can iterate once per row
+		iterations = dgMax (dgMin (island->m_rowsCount, DG_ISLAND_COST_MAX_EXACT_PASSES), DG_BASE_ITERATION_COUNT);
+	}
+	return island->m_rowsCount * iterations + island->m_bodyCount * passes;
+}
+
+void dgWorldDynamicUpdate::GetSolverIterationLimits (dgSolverIterationLimits* const limits, dgInt32 subSteps, dgFloat32 maxAccNorm) const
+{
+	const dgWorld* const world = (dgWorld*) this;
+	limits->m_adaptive = (world->m_solverResidualTolerance > dgFloat32 (0.0f));
+	if (limits->m_adaptive) {
+		// the passes are spread evenly over the substeps, so that the last substeps are not left without passes
+		limits->m_tolerance = world->m_solverResidualTolerance;
+		limits->m_minIterations = world->m_solverMinIterations;
+		limits->m_maxIterations = world->m_solverMaxIterations;
+		limits->m_stepIterations = (limits->m_maxIterations + subSteps - 1) / subSteps;
+	} else {
+		limits->m_tolerance = maxAccNorm;
+		limits->m_minIterations = 0;
+		limits->m_maxIterations = subSteps * DG_BASE_ITERATION_COUNT;
+		limits->m_stepIterations = DG_BASE_ITERATION_COUNT;
+	}
+}
+
+// islands are counted by the passes they took, slot i holds the islands of up to 2^(i+1) passes and the last slot all the rest
+void dgWorldDynamicUpdate::UpdateSolverIterationCounts (dgInt32* const counts, dgInt32 iterations, dgInt32 maxIterations) const
+{
+	dgInt32 slot = 0;
+	for (dgInt32 passes = 2; (passes < iterations) && (slot < (DG_SOLVER_ITERATIONS_HISTOGRAM_SIZE - 1)); passes *= 2) {
+		slot ++;
+	}
+	dgAtomicExchangeAndAdd (&counts[m_solverIterationsCount], iterations);
+	dgAtomicExchangeAndAdd (&counts[m_solverIslandIterationsCount + slot], 1);
+	if (iterations < maxIterations) {
+		dgAtomicExchangeAndAdd (&counts[m_solverEarlyExitIslandsCount], 1);
 	}
 }
 
@@ -727,12 +861,54 @@ void dgWorldDynamicUpdate::CalculateIslandReactionForcesKernel (void* const cont
 
 	dgFloat32 timestep = descriptor->m_timestep;
 	dgWorld* const world = (dgWorld*) worldContext;
-	dgInt32 count = descriptor->m_islandCount;
-	dgIsland* const islands = &((dgIsland*)&world->m_islandMemory[0])[descriptor->m_firstIsland];
+	DG_PROFILER_EVENT (world, "CalculateIslandReactionForcesKernel", threadID);
+	dgIsland* const islands = (dgIsland*)&world->m_islandMemory[0];
+	dgParallelSolverTeam* const teams = descriptor->m_teams;
+	dgInt32 teamCount = descriptor->m_teamCount;
+
+	// the first jobs to start lead the teams, the next ones join the teams until they are full, the rest go to the small islands 
+	dgInt32 role = dgAtomicExchangeAndAdd(&descriptor->m_roleCounter, 1);
+	if (role < teamCount) {
+		dgParallelSolverTeam* const team = &teams[role];
+		world->CalculateReactionForcesParallel (team->m_island, timestep, team, threadID);
+		dgInterlockedExchange (&team->m_finished, 1);
+	} else {
+		role -= teamCount;
+		for (dgInt32 i = 0; i < teamCount; i ++) {
+			if (role < (teams[i].m_threadCount - 1)) {
+				HelpParallelSolverTeam (&teams[i], world, threadID);
+				break;
+			}
+			role -= teams[i].m_threadCount - 1;
+		}
+	}
 
-	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
-		dgIsland* const island = &islands[i]; 
-		world->CalculateIslandReactionForces (island, timestep, threadID);
+	{
+		dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
+		const dgInt32* const batchStart = descriptor->m_batchStart;
+		for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); i < descriptor->m_batchCount; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+			for (dgInt32 j = batchStart[i]; j < batchStart[i + 1]; j ++) {
+				dgIsland* const island = &islands[j]; 
+				if (island->m_jointCount >= descriptor->m_parallelJointCount) {
+					// a large island that did not get a team still uses the parallel solver, on a team of one, 
+					// so that the solver picked for an island does not depend on the thread count
+					dgParallelSolverTeam team;
+					memset (&team, 0, sizeof (dgParallelSolverTeam));
+					team.m_island = island;
+					team.m_threadCount = 1;
+					world->CalculateReactionForcesParallel (island, timestep, &team, threadID);
+				} else {
+					world->CalculateIslandReactionForces (island, timestep, threadID);
+				}
+			}
+		}
+	}
+
+	// out of small islands, help the teams still running
+	for (dgInt32 i = 0; i < teamCount; i ++) {
+		if (dgAtomicExchangeAndAdd(&descriptor->m_roleCounter, 0) > i) {
+			HelpParallelSolverTeam (&teams[i], world, threadID);
+		}
 	}
 }
 
@@ -950,16 +1126,5 @@ void dgWorldDynamicUpdate::IntegrateArray (const dgIsland* const island, dgFloat
 
 
 
-dgInt32 dgWorldDynamicUpdate::SortJointInfoByColor (const dgParallelJointMap* const indirectIndexA, const dgParallelJointMap* const indirectIndexB, void* const context)
-{
-	if (indirectIndexA->m_bashIndex < indirectIndexB->m_bashIndex) {
-		return -1;
-	}
-	if (indirectIndexA->m_bashIndex > indirectIndexB->m_bashIndex) {
-		return 1;
-	}
-	return 0;
-}
-
 
 
@@ -62,6 +62,9 @@
 class dgBody;
 class dgDynamicBody;
 class dgParallelSolverSyncData;
+class dgParallelSolverTeam;
+class dgJacobianMatrixSoaBlock;
+class dgJacobianMatrixSoaElement;
 class dgWorldDynamicUpdateSyncDescriptor;
 
 
@@ -90,6 +93,7 @@ class dgIsland
 	dgInt32 m_jointStart;
 	dgInt32 m_rowsCount;
 	dgInt32 m_rowsStart;
+	dgInt32 m_solverCost;
 	dgUnsigned32 m_isContinueCollision	: 1;
 	dgUnsigned32 m_hasExactSolverJoints : 1;
 };
@@ -150,14 +154,54 @@ class dgParallelSolverSyncData
 	dgInt32 m_islandCount;
 	dgInt32 m_islandCountCounter;
 	dgInt32 m_jacobianMatrixRowAtomicIndex;
+	dgInt32 m_coloringRound;
+	dgInt32 m_coloringPendingCount;
+	dgInt32 m_coloringNextCount;
+	dgInt32 m_soaBlocksCount;
+	dgInt32 m_restingBodyWoken;
+	dgInt32 m_threadID;
+	dgInt32 m_arenaIndex;
 
 	const dgIsland* m_islandArray;
+	dgParallelSolverTeam* m_team;
 	dgBody** m_bodyInfoMap;
 	dgParallelJointMap* m_jointInfoMap;
-	JointsBashes m_jointBatches[64];
+	JointsBashes* m_jointBatches;
+	JointsBashes* m_soaBatches;
+	dgJacobianMatrixSoaBlock* m_soaBlocks;
+	dgJacobianMatrixSoaElement* m_soaRows;
+	dgInt32* m_soaBatchRows;
+	dgInt32* m_coloringRoundArray;
+	dgInt32* m_coloringPending;
+	dgInt32* m_coloringNext;
 	dgInt32 m_hasJointFeeback[DG_MAX_THREADS_HIVE_COUNT];
 };
 
+// the passes one island can run in a game mode update, adaptive when the world has a residual target
+class dgSolverIterationLimits
+{
+	public:
+	dgFloat32 m_tolerance;
+	dgInt32 m_minIterations;
+	dgInt32 m_maxIterations;
+	dgInt32 m_stepIterations;
+	bool m_adaptive;
+};
+
+// a subset of the hive solving one island with the parallel solver, while other teams and threads solve other islands.
+// the leader runs the serial parts and opens one phase per kernel, helpers join the open phases until the leader is done.
+class dgParallelSolverTeam
+{
+	public:
+	const dgIsland* m_island;
+	dgParallelSolverSyncData* m_syncData;
+	dgWorkerThreadTaskCallback m_kernel;
+	dgInt32 m_threadCount;
+	dgInt32 m_phase;
+	dgInt32 m_activeCount;
+	dgInt32 m_finished;
+};
+
 
 template<class T>
 class dgQueue
@@ -239,10 +283,38 @@ class dgJacobianMatrixElement
 	bool m_accelIsMotor;
 } DG_GCC_VECTOR_ALIGMENT;
 
+// one row of four joints of the same color batch, each lane is a different joint
+DG_MSC_VECTOR_ALIGMENT
+class dgJacobianMatrixSoaElement
+{
+	public:
+	dgVector m_Jt[12];
+	dgVector m_JMinv[12];
+	dgVector m_force;
+	dgVector m_maxImpact;
+	dgVector m_coordenateAccel;
+	dgVector m_diagDamp;
+	dgVector m_invDJMinvJt;
+	dgVector m_lowerBoundFrictionCoefficent;
+	dgVector m_upperBoundFrictionCoefficent;
+	dgInt32 m_rowIndex[4];
+	dgInt32 m_normalForceIndex[4];
+} DG_GCC_VECTOR_ALIGMENT;
+
+class dgJacobianMatrixSoaBlock
+{
+	public:
+	dgInt32 m_jointIndex[4];
+	dgInt32 m_rowStart;
+	dgInt32 m_rowCount;
+	dgInt32 m_batch;
+};
+
 class dgJacobianMemory
 {
 	public:
 	void Init (dgWorld* const world, dgInt32 rowsCount, dgInt32 bodyCount);
+	static void ExpandMatrixMemoryKernel (void* const context, void* const worldContext, dgInt32 threadID);
 
 	//dgJacobian* m_internalVeloc;
 	dgJacobian* m_internalForces;
@@ -274,19 +346,32 @@ class dgWorldDynamicUpdate
 	static void UpdateFeedbackForcesParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void UpdateBodyVelocityParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void FindActiveJointAndBodies (void* const context, void* const worldContext, dgInt32 threadID); 
-	static dgInt32 SortJointInfoByColor (const dgParallelJointMap* const indirectIndexA, const dgParallelJointMap* const indirectIndexB, void* const constraintArray);
+	static void ValidateJointColorsParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void ColorJointsParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void BuildJacobianSoaBatchesParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void BuildJacobianSoaBlocksParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void CalculateJointsForceSoaParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void UpdateSoaBlocksAccelParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void UpdateRowsFromSoaBlocksParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void HelpParallelSolverTeam (dgParallelSolverTeam* const team, dgWorld* const world, dgInt32 threadID);
+	static dgInt32 CompareJointRowCount (const dgParallelJointMap* const indirectIndexA, const dgParallelJointMap* const indirectIndexB, void* const constraintArray);
 
 	void GetJacobianDerivativesParallel (dgJointInfo* const jointInfo, dgInt32 threadID, dgInt32 rowBase, dgFloat32 timestep) const;	
 	void CreateParallelArrayBatchArrays (dgParallelSolverSyncData* const solverSyncData, dgJointInfo* const constraintArray, const dgIsland* const island) const;
 
 	void FindActiveJointAndBodies (dgIsland* const island); 
+	dgInt32 CalculateIslandSolverCost (const dgIsland* const island) const;
+	void GetSolverIterationLimits (dgSolverIterationLimits* const limits, dgInt32 subSteps, dgFloat32 maxAccNorm) const;
+	void UpdateSolverIterationCounts (dgInt32* const counts, dgInt32 iterations, dgInt32 maxIterations) const;
+	void ExecuteParallelSolverKernel (dgWorkerThreadTaskCallback kernel, dgParallelSolverSyncData* const syncData) const;
 	void IntegrateInslandParallel(dgParallelSolverSyncData* const syncData) const; 
 	void InitilizeBodyArrayParallel (dgParallelSolverSyncData* const syncData) const; 
 	void BuildJacobianMatrixParallel (dgParallelSolverSyncData* const syncData) const; 
+	void BuildJacobianSoaBlocksParallel (dgParallelSolverSyncData* const syncData) const; 
 	void SolverInitInternalForcesParallel (dgParallelSolverSyncData* const syncData) const; 
 	void CalculateForcesGameModeParallel (dgParallelSolverSyncData* const syncData) const; 
 
-	void CalculateReactionForcesParallel (const dgIsland* const island, dgFloat32 timestep) const;
+	void CalculateReactionForcesParallel (const dgIsland* const island, dgFloat32 timestep, dgParallelSolverTeam* const team, dgInt32 threadID) const;
 	dgFloat32 CalculateJointForces (const dgIsland* const island, dgInt32 rowStart, dgInt32 joint, dgFloat32* const forceStep, dgFloat32 maxAccNorm, const dgJacobianPair* const JMinv) const;
 	void CalculateForcesSimulationMode (const dgIsland* const island, dgInt32 threadID, dgFloat32 timestep, dgFloat32 maxAccNorm) const;
 	void CalculateIslandReactionForces (dgIsland* const island, dgFloat32 timestep, dgInt32 threadID) const;
@@ -304,6 +389,8 @@ class dgWorldDynamicUpdate
 	dgInt32 m_joints;
 	dgInt32 m_islands;
 	dgUnsigned32 m_markLru;
+	dgInt32 m_treeQueueSize;
+	dgDynamicBody** m_treeQueuePool;
 	dgJacobianMemory m_solverMemory;
 	dgThread::dgCriticalSection m_softBodyCriticalSectionLock;
 	dgBody* m_sentinelBody;
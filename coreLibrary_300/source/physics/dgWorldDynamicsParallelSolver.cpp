@@ -27,27 +27,48 @@
 #include "dgDynamicBody.h"
 #include "dgWorldDynamicUpdate.h"
 
+#define DG_PARALLEL_COLOR_UNSET			0x7fffffff
+#define DG_PARALLEL_COLOR_REUSE_FACTOR	4
 
 
-void dgWorldDynamicUpdate::CalculateReactionForcesParallel (const dgIsland* const island, dgFloat32 timestep) const
+// coloring priority of a joint, a scramble of its island index so that the colors do not depend on thread scheduling
+DG_INLINE dgUnsigned32 dgJointColoringPriority (dgInt32 index)
+{
+	dgUnsigned32 key = dgUnsigned32 (index) * 0x9e3779b1;
+	key ^= key >> 15;
+	key *= 0x85ebca77;
+	key ^= key >> 13;
+	return key;
+}
+
+
+void dgWorldDynamicUpdate::CalculateReactionForcesParallel (const dgIsland* const island, dgFloat32 timestep, dgParallelSolverTeam* const team, dgInt32 threadID) const
 {
 	dgParallelSolverSyncData syncData;
 
 	dgWorld* const world = (dgWorld*) this;
 
-	world->m_pairMemoryBuffer.ExpandCapacityIfNeessesary (m_joints + 1024, sizeof (dgParallelJointMap));
+	// a team solves its island at the same time as other islands, so it takes its memory from the leader thread arena
+	syncData.m_team = team;
+	syncData.m_threadID = threadID;
+	syncData.m_arenaIndex = team ? threadID : DG_FRAME_ARENA_SERIAL;
+	if (team) {
+		team->m_syncData = &syncData;
+	}
 
 //	syncData.m_bodyAtomic = (dgThread::dgCriticalSection*) (&world->m_pairMemoryBuffer[0]);
 //	syncData.m_jointInfoMap = (dgParallelJointMap*) (&syncData.m_bodyAtomic[(m_bodies + 31) & ~0x0f]);
-	syncData.m_jointInfoMap = (dgParallelJointMap*) (&world->m_pairMemoryBuffer[0]);
+	syncData.m_jointInfoMap = (dgParallelJointMap*) world->m_frameArena.Alloc ((island->m_jointCount + 1024) * sizeof (dgParallelJointMap), syncData.m_arenaIndex);
 
 	dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
 
 	dgInt32 bodyCount = island->m_bodyCount - 1;
 	dgInt32 jointsCount = island->m_jointCount;
+	syncData.m_jointCount = jointsCount;
+	syncData.m_islandArray = island;
 	CreateParallelArrayBatchArrays (&syncData, constraintArray, island);
 	
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[0];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[island->m_bodyStart];
 	dgVector zero(dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
 	internalForces[0].m_linear = zero;
 	internalForces[0].m_angular = zero;
@@ -65,105 +86,291 @@ void dgWorldDynamicUpdate::CalculateReactionForcesParallel (const dgIsland* cons
 	syncData.m_bodyCount = bodyCount;
 	syncData.m_jointCount = jointsCount;
 	syncData.m_atomicIndex = 0;
+	syncData.m_jacobianMatrixRowAtomicIndex = island->m_rowsStart;
 	syncData.m_islandCount = 1;
 	syncData.m_islandArray = island;
 
 	InitilizeBodyArrayParallel (&syncData);
 	BuildJacobianMatrixParallel (&syncData);
 	SolverInitInternalForcesParallel (&syncData);
+	if (world->m_useParallelSolverSimdBlocks) {
+		BuildJacobianSoaBlocksParallel (&syncData);
+	}
 	CalculateForcesGameModeParallel (&syncData);
 	IntegrateInslandParallel(&syncData); 
 }
 
 
+void dgWorldDynamicUpdate::ExecuteParallelSolverKernel (dgWorkerThreadTaskCallback kernel, dgParallelSolverSyncData* const syncData) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	dgParallelSolverTeam* const team = syncData->m_team;
+	if (!team) {
+		dgInt32 threadCounts = world->GetThreadCount();	
+		for (dgInt32 j = 0; j < threadCounts; j ++) {
+			world->QueueJob (kernel, syncData, world);
+		}
+		world->SynchronizationBarrier();
+	} else {
+		// the kernels take their work from the atomic counters, so the phase is done when the leader 
+		// runs out of work and no helper is still inside. the leader never waits for a helper to show up.
+		team->m_kernel = kernel;
+		dgInterlockedExchange (&team->m_phase, team->m_phase + 1);
+		kernel (syncData, world, syncData->m_threadID);
+		dgInterlockedExchange (&team->m_phase, team->m_phase + 1);
+		while (dgAtomicExchangeAndAdd (&team->m_activeCount, 0)) {
+			dgThreadYield();
+		}
+	}
+}
+
+
+// the caller only helps a team whose leader is already running, so a helper never holds a thread the leader needs
+void dgWorldDynamicUpdate::HelpParallelSolverTeam (dgParallelSolverTeam* const team, dgWorld* const world, dgInt32 threadID)
+{
+	dgInt32 lastPhase = 0;
+	while (!dgAtomicExchangeAndAdd (&team->m_finished, 0)) {
+		dgInt32 phase = dgAtomicExchangeAndAdd (&team->m_phase, 0);
+		if ((phase & 1) && (phase != lastPhase)) {
+			// a phase is open while its count is odd, join it at most once and only if it did not close in between
+			dgAtomicExchangeAndAdd (&team->m_activeCount, 1);
+			if (dgAtomicExchangeAndAdd (&team->m_phase, 0) == phase) {
+				team->m_kernel (team->m_syncData, world, threadID);
+			}
+			dgAtomicExchangeAndAdd (&team->m_activeCount, -1);
+			lastPhase = phase;
+		} else {
+			dgThreadYield();
+		}
+	}
+}
+
+
 
 void dgWorldDynamicUpdate::CreateParallelArrayBatchArrays(dgParallelSolverSyncData* const solverSyncData, dgJointInfo* const constraintArray, const dgIsland* const island) const
 {
+	dgWorld* const world = (dgWorld*) this;
 	dgParallelJointMap* const jointInfoMap = solverSyncData->m_jointInfoMap;
+	dgJointInfo* const jointArray = &constraintArray[island->m_jointStart];
 	dgInt32 count = island->m_jointCount;
 	dgInt32 index = island->m_jointStart;
+
+	bool hasColors = false;
 	for (dgInt32 j = 0; j < count; j ++) {
 		dgConstraint* const joint = constraintArray[index].m_joint;
-		constraintArray[index].m_color = 0;
-		jointInfoMap[j].m_jointIndex = index;
+		hasColors |= (joint->m_solverColor >= 0);
 		joint->m_index = index;
 		index ++;
 	}
 
-	jointInfoMap[count].m_bashIndex = 0x7fffffff;
-	jointInfoMap[count].m_jointIndex= -1;
+	solverSyncData->m_coloringRoundArray = (dgInt32*) world->m_frameArena.Alloc (3 * count * sizeof (dgInt32), solverSyncData->m_arenaIndex);
+	solverSyncData->m_coloringPending = &solverSyncData->m_coloringRoundArray[count];
+	solverSyncData->m_coloringNext = &solverSyncData->m_coloringPending[count];
+	solverSyncData->m_coloringPendingCount = count;
+
+	// keep the colors of last update that are still valid, only new joints and joints that now conflict with a neighbor are recolored
+	if (hasColors) {
+		solverSyncData->m_atomicIndex = 0;
+		solverSyncData->m_coloringNextCount = 0;
+		ExecuteParallelSolverKernel (ValidateJointColorsParallelKernel, solverSyncData);
+		dgSwap (solverSyncData->m_coloringPending, solverSyncData->m_coloringNext);
+		solverSyncData->m_coloringPendingCount = solverSyncData->m_coloringNextCount;
+	}
 
-	for (dgInt32 i = 0; i < count; i ++) {
-		dgJointInfo& jointInfo = constraintArray[jointInfoMap[i].m_jointIndex];
+	if (!hasColors || (solverSyncData->m_coloringPendingCount * DG_PARALLEL_COLOR_REUSE_FACTOR > count)) {
+		// the contact graph changed too much, color the whole island again
+		dgInt32* const roundArray = solverSyncData->m_coloringRoundArray;
+		dgInt32* const pending = solverSyncData->m_coloringPending;
+		for (dgInt32 j = 0; j < count; j ++) {
+			jointArray[j].m_color = -1;
+			roundArray[j] = DG_PARALLEL_COLOR_UNSET;
+			pending[j] = j;
+		}
+		solverSyncData->m_coloringPendingCount = count;
+	}
 
-		dgInt32 index = 0; 
-		dgInt32 color = jointInfo.m_color;
-		for (dgInt32 n = 1; n & color; n <<= 1) {
-			index ++;
-			dgAssert (index < 32);
+	// Jones-Plassmann rounds, a joint with higher priority than all its uncolored neighbors takes the lowest color not used by its colored neighbors
+	solverSyncData->m_coloringRound = 0;
+	while (solverSyncData->m_coloringPendingCount) {
+		solverSyncData->m_coloringRound ++;
+		solverSyncData->m_atomicIndex = 0;
+		solverSyncData->m_coloringNextCount = 0;
+		ExecuteParallelSolverKernel (ColorJointsParallelKernel, solverSyncData);
+		dgSwap (solverSyncData->m_coloringPending, solverSyncData->m_coloringNext);
+		solverSyncData->m_coloringPendingCount = solverSyncData->m_coloringNextCount;
+	}
+
+	// bucket the joints by color, colors left empty by the reuse pass do not make a batch
+	dgInt32 colorCount = 0;
+	for (dgInt32 j = 0; j < count; j ++) {
+		colorCount = dgMax (colorCount, jointArray[j].m_color + 1);
+	}
+
+	dgInt32* const colorStart = (dgInt32*) world->m_frameArena.Alloc (2 * colorCount * sizeof (dgInt32), solverSyncData->m_arenaIndex);
+	dgInt32* const colorBash = &colorStart[colorCount];
+	memset (colorStart, 0, colorCount * sizeof (dgInt32));
+	for (dgInt32 j = 0; j < count; j ++) {
+		colorStart[jointArray[j].m_color] ++;
+	}
+
+	dgInt32 bash = 0;
+	dgInt32 start = 0;
+	solverSyncData->m_jointBatches = (dgParallelSolverSyncData::JointsBashes*) world->m_frameArena.Alloc (colorCount * sizeof (dgParallelSolverSyncData::JointsBashes), solverSyncData->m_arenaIndex);
+	for (dgInt32 i = 0; i < colorCount; i ++) {
+		dgInt32 batchCount = colorStart[i];
+		colorStart[i] = start;
+		colorBash[i] = bash;
+		if (batchCount) {
+			solverSyncData->m_jointBatches[bash].m_start = start;
+			solverSyncData->m_jointBatches[bash].m_count = batchCount;
+			start += batchCount;
+			bash ++;
 		}
-		jointInfoMap[i].m_bashIndex = index;
+	}
+	solverSyncData->m_batchesCount = bash;
+
+	for (dgInt32 j = 0; j < count; j ++) {
+		dgInt32 color = jointArray[j].m_color;
+		dgInt32 entry = colorStart[color];
+		colorStart[color] ++;
+		jointInfoMap[entry].m_bashIndex = colorBash[color];
+		jointInfoMap[entry].m_jointIndex = island->m_jointStart + j;
+		jointArray[j].m_joint->m_solverColor = color;
+	}
+	jointInfoMap[count].m_bashIndex = 0x7fffffff;
+	jointInfoMap[count].m_jointIndex= -1;
+}
 
-		color = 1 << index;
-		dgConstraint* const constraint = jointInfo.m_joint;
-		dgDynamicBody* const body0 = (dgDynamicBody*) constraint->m_body0;
-		dgAssert (body0->IsRTTIType(dgBody::m_dynamicBodyRTTI));
 
-		if (body0->m_invMass.m_w > dgFloat32 (0.0f)) {
-			for (dgBodyMasterListRow::dgListNode* jointNode = body0->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
-				dgBodyMasterListCell& cell = jointNode->GetInfo();
+void dgWorldDynamicUpdate::ValidateJointColorsParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "ValidateJointColorsParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
 
-				dgConstraint* const neiborgLink = cell.m_joint;
-				if ((neiborgLink != constraint) && (neiborgLink->m_maxDOF) && neiborgLink->IsActive()) {
-					dgJointInfo& info = constraintArray[neiborgLink->m_index];
-					info.m_color |= color;
+	const dgIsland* const island = syncData->m_islandArray;
+	dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
+	dgJointInfo* const jointArray = &constraintArray[island->m_jointStart];
+	dgInt32* const roundArray = syncData->m_coloringRoundArray;
+	dgInt32 jointStart = island->m_jointStart;
+
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_jointCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		const dgConstraint* const constraint = jointArray[i].m_joint;
+		dgUnsigned32 priority = dgJointColoringPriority (i);
+
+		// of two neighbors sharing a color only the one with higher priority keeps it
+		dgInt32 color = constraint->m_solverColor;
+		for (dgInt32 k = 0; (k < 2) && (color >= 0); k ++) {
+			const dgBody* const body = k ? constraint->m_body1 : constraint->m_body0;
+			if (body->m_invMass.m_w > dgFloat32 (0.0f)) {
+				for (dgBodyMasterListRow::dgListNode* jointNode = body->m_masterNode->GetInfo().GetFirst(); jointNode && (color >= 0); jointNode = jointNode->GetNext()) {
+					const dgConstraint* const neiborgLink = jointNode->GetInfo().m_joint;
+					if ((neiborgLink != constraint) && (neiborgLink->m_solverColor == color) && (neiborgLink->m_maxDOF) && neiborgLink->IsActive()) {
+						if (dgJointColoringPriority (dgInt32 (neiborgLink->m_index) - jointStart) > priority) {
+							color = -1;
+						}
+					}
 				}
 			}
 		}
 
-		dgDynamicBody* const body1 = (dgDynamicBody*)constraint->m_body1;
-		dgAssert (body1->IsRTTIType(dgBody::m_dynamicBodyRTTI));
-		if (body1->m_invMass.m_w > dgFloat32 (0.0f)) {
-			for (dgBodyMasterListRow::dgListNode* jointNode = body1->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
-				dgBodyMasterListCell& cell = jointNode->GetInfo();
+		jointArray[i].m_color = color;
+		if (color >= 0) {
+			roundArray[i] = 0;
+		} else {
+			roundArray[i] = DG_PARALLEL_COLOR_UNSET;
+			syncData->m_coloringNext[dgAtomicExchangeAndAdd(&syncData->m_coloringNextCount, 1)] = i;
+		}
+	}
+}
+
+
+void dgWorldDynamicUpdate::ColorJointsParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "ColorJointsParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
 
-				dgConstraint* const neiborgLink = cell.m_joint;
-				if ((neiborgLink != constraint) && (neiborgLink->m_maxDOF) && neiborgLink->IsActive()) {
-					dgJointInfo& info = constraintArray[neiborgLink->m_index];
-					info.m_color |= color;
+	const dgIsland* const island = syncData->m_islandArray;
+	dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
+	dgJointInfo* const jointArray = &constraintArray[island->m_jointStart];
+	dgInt32* const roundArray = syncData->m_coloringRoundArray;
+	const dgInt32* const pending = syncData->m_coloringPending;
+	dgInt32 jointStart = island->m_jointStart;
+	dgInt32 round = syncData->m_coloringRound;
+
+	// a neighbor is colored only if it took its color in an earlier round, joints colored in this round are never neighbors
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_coloringPendingCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgInt32 index = pending[i];
+		const dgConstraint* const constraint = jointArray[index].m_joint;
+		dgUnsigned32 priority = dgJointColoringPriority (index);
+
+		bool isLocalMax = true;
+		dgUnsigned64 colorMask = 0;
+		for (dgInt32 k = 0; (k < 2) && isLocalMax; k ++) {
+			const dgBody* const body = k ? constraint->m_body1 : constraint->m_body0;
+			if (body->m_invMass.m_w > dgFloat32 (0.0f)) {
+				for (dgBodyMasterListRow::dgListNode* jointNode = body->m_masterNode->GetInfo().GetFirst(); jointNode && isLocalMax; jointNode = jointNode->GetNext()) {
+					const dgConstraint* const neiborgLink = jointNode->GetInfo().m_joint;
+					if ((neiborgLink != constraint) && (neiborgLink->m_maxDOF) && neiborgLink->IsActive()) {
+						dgInt32 neighbor = dgInt32 (neiborgLink->m_index) - jointStart;
+						if (roundArray[neighbor] < round) {
+							dgInt32 color = jointArray[neighbor].m_color;
+							if (color < 64) {
+								colorMask |= dgUnsigned64 (1) << color;
+							}
+						} else if (dgJointColoringPriority (neighbor) > priority) {
+							isLocalMax = false;
+						}
+					}
 				}
 			}
 		}
-	}
 
-	dgSort (jointInfoMap, count, SortJointInfoByColor, constraintArray);
+		if (isLocalMax) {
+			dgInt32 base = 0;
+			while (colorMask == dgUnsigned64 (-1)) {
+				// every color in this window is taken, try the next one
+				base += 64;
+				colorMask = 0;
+				for (dgInt32 k = 0; k < 2; k ++) {
+					const dgBody* const body = k ? constraint->m_body1 : constraint->m_body0;
+					if (body->m_invMass.m_w > dgFloat32 (0.0f)) {
+						for (dgBodyMasterListRow::dgListNode* jointNode = body->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+							const dgConstraint* const neiborgLink = jointNode->GetInfo().m_joint;
+							if ((neiborgLink != constraint) && (neiborgLink->m_maxDOF) && neiborgLink->IsActive()) {
+								dgInt32 neighbor = dgInt32 (neiborgLink->m_index) - jointStart;
+								dgInt32 color = jointArray[neighbor].m_color - base;
+								if ((roundArray[neighbor] < round) && (color >= 0) && (color < 64)) {
+									colorMask |= dgUnsigned64 (1) << color;
+								}
+							}
+						}
+					}
+				}
+			}
 
-	dgInt32 bash = 0;
-	for (int index = 0; index < count; index ++) {
-		dgInt32 count = 0; 
-		solverSyncData->m_jointBatches[bash].m_start = index;
-		while (jointInfoMap[index].m_bashIndex == bash) {
-			count ++;
-			index ++;
+			dgInt32 color = base;
+			for (dgUnsigned64 bit = 1; bit & colorMask; bit <<= 1) {
+				color ++;
+			}
+			jointArray[index].m_color = color;
+			roundArray[index] = round;
+		} else {
+			syncData->m_coloringNext[dgAtomicExchangeAndAdd(&syncData->m_coloringNextCount, 1)] = index;
 		}
-		solverSyncData->m_jointBatches[bash].m_count = count;
-		bash ++;
-		index --;
 	}
-	solverSyncData->m_batchesCount = bash;
 }
 
 
 void dgWorldDynamicUpdate::InitilizeBodyArrayParallel (dgParallelSolverSyncData* const syncData) const
 {
-	dgWorld* const world = (dgWorld*) this;
-	dgInt32 threadCounts = world->GetThreadCount();	
-
 	syncData->m_atomicIndex = 0;
-	for (dgInt32 j = 0; j < threadCounts; j ++) {
-		world->QueueJob (InitializeBodyArrayParallelKernel, syncData, world);
-	}
-	world->SynchronizationBarrier();
+	ExecuteParallelSolverKernel (InitializeBodyArrayParallelKernel, syncData);
 }
 
 
@@ -171,13 +378,15 @@ void dgWorldDynamicUpdate::InitializeBodyArrayParallelKernel (void* const contex
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "InitializeBodyArrayParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
 
 	const dgIsland* const island = syncData->m_islandArray;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
 	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
 
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[0];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[island->m_bodyStart];
 	dgVector zero(dgFloat32 (0.0f));
 
 	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
@@ -202,9 +411,6 @@ void dgWorldDynamicUpdate::InitializeBodyArrayParallelKernel (void* const contex
 
 void dgWorldDynamicUpdate::BuildJacobianMatrixParallel (dgParallelSolverSyncData* const syncData) const
 {
-	dgWorld* const world = (dgWorld*) this;
-	dgInt32 threadCounts = world->GetThreadCount();	
-
 //	for (int i = 0; i < syncData->m_batchesCount; i ++) {
 //		syncData->m_atomicIndex = syncData->m_jointBatches[i].m_start;
 //		syncData->m_jointsInBatch = syncData->m_jointBatches[i].m_count + syncData->m_atomicIndex;
@@ -215,10 +421,7 @@ void dgWorldDynamicUpdate::BuildJacobianMatrixParallel (dgParallelSolverSyncData
 //	}
 
 	syncData->m_atomicIndex = 0;
-	for (dgInt32 j = 0; j < threadCounts; j ++) {
-		world->QueueJob (BuildJacobianMatrixParallelKernel, syncData, world);
-	}
-	world->SynchronizationBarrier();
+	ExecuteParallelSolverKernel (BuildJacobianMatrixParallelKernel, syncData);
 }
 
 
@@ -293,6 +496,8 @@ void dgWorldDynamicUpdate::BuildJacobianMatrixParallelKernel (void* const contex
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "BuildJacobianMatrixParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 	const dgParallelJointMap* const jointInfoIndexArray = syncData->m_jointInfoMap;
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
 	const dgIsland* const island = syncData->m_islandArray;
@@ -390,23 +595,17 @@ void dgWorldDynamicUpdate::BuildJacobianMatrixParallelKernel (void* const contex
 
 void dgWorldDynamicUpdate::SolverInitInternalForcesParallel (dgParallelSolverSyncData* const syncData) const
 {
-	dgWorld* const world = (dgWorld*) this;
-	dgInt32 threadCounts = world->GetThreadCount();	
-
 	for (int i = 0; i < syncData->m_batchesCount; i ++) {
 		syncData->m_atomicIndex = syncData->m_jointBatches[i].m_start;
 		syncData->m_jointsInBatch = syncData->m_jointBatches[i].m_count + syncData->m_atomicIndex;
-		for (dgInt32 j = 0; j < threadCounts; j ++) {
-			world->QueueJob (SolverInitInternalForcesParallelKernel, syncData, world);
-		}
-		world->SynchronizationBarrier();
+		ExecuteParallelSolverKernel (SolverInitInternalForcesParallelKernel, syncData);
 	}
 
 //	syncData->m_atomicIndex = 0;
 //	for (dgInt32 j = 0; j < threadCounts; j ++) {
 //		world->QueueJob (SolverInitInternalForcesParallelKernel, syncData, world);
 //	}
-	world->SynchronizationBarrier();
+//	world->SynchronizationBarrier();
 
 //	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[0];
 //	internalForces[0].m_linear = dgVector (dgFloat32 (0.0f));
@@ -419,8 +618,11 @@ void dgWorldDynamicUpdate::SolverInitInternalForcesParallelKernel (void* const c
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "SolverInitInternalForcesParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 	const dgParallelJointMap* const jointInfoIndexArray = syncData->m_jointInfoMap;
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[0];
+	const dgIsland* const island = syncData->m_islandArray;
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[island->m_bodyStart];
 	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_memory[0];
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
 	dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
@@ -479,10 +681,258 @@ void dgWorldDynamicUpdate::SolverInitInternalForcesParallelKernel (void* const c
 
 
 
+dgInt32 dgWorldDynamicUpdate::CompareJointRowCount (const dgParallelJointMap* const indirectIndexA, const dgParallelJointMap* const indirectIndexB, void* const context)
+{
+	const dgJointInfo* const constraintArray = (dgJointInfo*) context;
+	dgInt32 countA = constraintArray[indirectIndexA->m_jointIndex].m_autoPaircount;
+	dgInt32 countB = constraintArray[indirectIndexB->m_jointIndex].m_autoPaircount;
+	if (countA > countB) {
+		return -1;
+	}
+	if (countA < countB) {
+		return 1;
+	}
+	if (indirectIndexA->m_jointIndex < indirectIndexB->m_jointIndex) {
+		return -1;
+	}
+	if (indirectIndexA->m_jointIndex > indirectIndexB->m_jointIndex) {
+		return 1;
+	}
+	return 0;
+}
+
+
+void dgWorldDynamicUpdate::BuildJacobianSoaBlocksParallel (dgParallelSolverSyncData* const syncData) const
+{
+	dgWorld* const world = (dgWorld*) this;
+
+	// the number of blocks of each batch is known from its joint count, only the rows of each block depend on the sort
+	dgInt32 blockCount = 0;
+	syncData->m_soaBatches = (dgParallelSolverSyncData::JointsBashes*) world->m_frameArena.Alloc (syncData->m_batchesCount * sizeof (dgParallelSolverSyncData::JointsBashes), syncData->m_arenaIndex);
+	for (dgInt32 i = 0; i < syncData->m_batchesCount; i ++) {
+		syncData->m_soaBatches[i].m_start = blockCount;
+		syncData->m_soaBatches[i].m_count = (syncData->m_jointBatches[i].m_count + 3) >> 2;
+		blockCount += syncData->m_soaBatches[i].m_count;
+	}
+	syncData->m_soaBlocks = (dgJacobianMatrixSoaBlock*) world->m_frameArena.Alloc (dgMax (blockCount, 1) * sizeof (dgJacobianMatrixSoaBlock), syncData->m_arenaIndex);
+	syncData->m_soaBatchRows = (dgInt32*) world->m_frameArena.Alloc (syncData->m_batchesCount * sizeof (dgInt32), syncData->m_arenaIndex);
+	syncData->m_soaBlocksCount = blockCount;
+
+	syncData->m_atomicIndex = 0;
+	ExecuteParallelSolverKernel (BuildJacobianSoaBatchesParallelKernel, syncData);
+
+	// each batch now knows its row count, turn the counts into the first row of each batch
+	dgInt32 rowCount = 0;
+	for (dgInt32 i = 0; i < syncData->m_batchesCount; i ++) {
+		dgInt32 count = syncData->m_soaBatchRows[i];
+		syncData->m_soaBatchRows[i] = rowCount;
+		rowCount += count;
+	}
+	syncData->m_soaRows = (dgJacobianMatrixSoaElement*) world->m_frameArena.Alloc (dgMax (rowCount, 1) * sizeof (dgJacobianMatrixSoaElement), syncData->m_arenaIndex);
+
+	syncData->m_atomicIndex = 0;
+	ExecuteParallelSolverKernel (BuildJacobianSoaBlocksParallelKernel, syncData);
+}
+
+
+void dgWorldDynamicUpdate::BuildJacobianSoaBatchesParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "BuildJacobianSoaBatchesParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
+
+	dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
+	dgParallelJointMap* const jointInfoMap = syncData->m_jointInfoMap;
+	dgJacobianMatrixSoaBlock* const blocks = syncData->m_soaBlocks;
+
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_batchesCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgInt32 start = syncData->m_jointBatches[i].m_start;
+		dgInt32 count = syncData->m_jointBatches[i].m_count;
+
+		// joints with similar row count go to the same block, so that few lanes are padded 
+		dgSort (&jointInfoMap[start], count, CompareJointRowCount, constraintArray);
+
+		// the row start of each block is relative to its batch until the batches are laid out
+		dgInt32 rowCount = 0;
+		dgInt32 blockIndex = syncData->m_soaBatches[i].m_start;
+		for (dgInt32 j = 0; j < count; j += 4) {
+			dgJacobianMatrixSoaBlock& block = blocks[blockIndex];
+			block.m_rowStart = rowCount;
+			block.m_rowCount = 0;
+			block.m_batch = i;
+			for (dgInt32 lane = 0; lane < 4; lane ++) {
+				block.m_jointIndex[lane] = -1;
+				if ((j + lane) < count) {
+					dgInt32 jointIndex = jointInfoMap[start + j + lane].m_jointIndex;
+					block.m_jointIndex[lane] = jointIndex;
+					block.m_rowCount = dgMax (block.m_rowCount, constraintArray[jointIndex].m_autoPaircount);
+				}
+			}
+			rowCount += block.m_rowCount;
+			blockIndex ++;
+		}
+		dgAssert (blockIndex == (syncData->m_soaBatches[i].m_start + syncData->m_soaBatches[i].m_count));
+		syncData->m_soaBatchRows[i] = rowCount;
+	}
+}
+
+
+void dgWorldDynamicUpdate::BuildJacobianSoaBlocksParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "BuildJacobianSoaBlocksParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
+
+	const dgIsland* const island = syncData->m_islandArray;
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	const dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
+	const dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
+	const dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_memory[0];
+	dgJacobianMatrixSoaBlock* const blocks = syncData->m_soaBlocks;
+
+	dgJacobianMatrixElement zeroRow;
+	memset (&zeroRow, 0, sizeof (dgJacobianMatrixElement));
+	zeroRow.m_normalForceIndex = DG_BILATERAL_CONSTRAINT;
+
+	const dgVector zero (dgFloat32 (0.0f));
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_soaBlocksCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgJacobianMatrixSoaBlock& block = blocks[i];
+		block.m_rowStart += syncData->m_soaBatchRows[block.m_batch];
+		dgJacobianMatrixSoaElement* const soaRow = &syncData->m_soaRows[block.m_rowStart];
+
+		dgInt32 rowStart[4];
+		dgInt32 rowCount[4];
+		dgVector invMass0[4];
+		dgVector invMass1[4];
+		const dgMatrix* invInertia0[4];
+		const dgMatrix* invInertia1[4];
+		for (dgInt32 lane = 0; lane < 4; lane ++) {
+			dgInt32 jointIndex = block.m_jointIndex[lane];
+			rowStart[lane] = 0;
+			rowCount[lane] = 0;
+			invMass0[lane] = zero;
+			invMass1[lane] = zero;
+			invInertia0[lane] = &dgGetIdentityMatrix();
+			invInertia1[lane] = &dgGetIdentityMatrix();
+			if (jointIndex >= 0) {
+				const dgJointInfo* const jointInfo = &constraintArray[jointIndex];
+				const dgBody* const body0 = bodyArray[jointInfo->m_m0].m_body;
+				const dgBody* const body1 = bodyArray[jointInfo->m_m1].m_body;
+				rowStart[lane] = jointInfo->m_autoPairstart;
+				rowCount[lane] = jointInfo->m_autoPaircount;
+				invMass0[lane] = dgVector (body0->m_invMass[3]);
+				invMass1[lane] = dgVector (body1->m_invMass[3]);
+				invInertia0[lane] = &body0->m_invWorldInertiaMatrix;
+				invInertia1[lane] = &body1->m_invWorldInertiaMatrix;
+			}
+		}
+
+		// padded lanes read a zero row, so their Jacobian and bounds are zero and their force stays at zero 
+		for (dgInt32 k = 0; k < block.m_rowCount; k ++) {
+			dgJacobianMatrixSoaElement* const dst = &soaRow[k];
+			const dgJacobianMatrixElement* row[4];
+			dgVector JMinvLinearM0[4];
+			dgVector JMinvAngularM0[4];
+			dgVector JMinvLinearM1[4];
+			dgVector JMinvAngularM1[4];
+			for (dgInt32 lane = 0; lane < 4; lane ++) {
+				row[lane] = &zeroRow;
+				dst->m_rowIndex[lane] = -1;
+				if (k < rowCount[lane]) {
+					row[lane] = &matrixRow[rowStart[lane] + k];
+					dst->m_rowIndex[lane] = rowStart[lane] + k;
+				}
+				JMinvLinearM0[lane] = row[lane]->m_Jt.m_jacobianM0.m_linear.CompProduct4 (invMass0[lane]);
+				JMinvAngularM0[lane] = invInertia0[lane]->RotateVector (row[lane]->m_Jt.m_jacobianM0.m_angular);
+				JMinvLinearM1[lane] = row[lane]->m_Jt.m_jacobianM1.m_linear.CompProduct4 (invMass1[lane]);
+				JMinvAngularM1[lane] = invInertia1[lane]->RotateVector (row[lane]->m_Jt.m_jacobianM1.m_angular);
+				dst->m_normalForceIndex[lane] = row[lane]->m_normalForceIndex;
+			}
+
+			dgVector unused;
+			dgVector::Transpose4x4 (dst->m_Jt[0], dst->m_Jt[1], dst->m_Jt[2], unused, row[0]->m_Jt.m_jacobianM0.m_linear, row[1]->m_Jt.m_jacobianM0.m_linear, row[2]->m_Jt.m_jacobianM0.m_linear, row[3]->m_Jt.m_jacobianM0.m_linear);
+			dgVector::Transpose4x4 (dst->m_Jt[3], dst->m_Jt[4], dst->m_Jt[5], unused, row[0]->m_Jt.m_jacobianM0.m_angular, row[1]->m_Jt.m_jacobianM0.m_angular, row[2]->m_Jt.m_jacobianM0.m_angular, row[3]->m_Jt.m_jacobianM0.m_angular);
+			dgVector::Transpose4x4 (dst->m_Jt[6], dst->m_Jt[7], dst->m_Jt[8], unused, row[0]->m_Jt.m_jacobianM1.m_linear, row[1]->m_Jt.m_jacobianM1.m_linear, row[2]->m_Jt.m_jacobianM1.m_linear, row[3]->m_Jt.m_jacobianM1.m_linear);
+			dgVector::Transpose4x4 (dst->m_Jt[9], dst->m_Jt[10], dst->m_Jt[11], unused, row[0]->m_Jt.m_jacobianM1.m_angular, row[1]->m_Jt.m_jacobianM1.m_angular, row[2]->m_Jt.m_jacobianM1.m_angular, row[3]->m_Jt.m_jacobianM1.m_angular);
+			dgVector::Transpose4x4 (dst->m_JMinv[0], dst->m_JMinv[1], dst->m_JMinv[2], unused, JMinvLinearM0[0], JMinvLinearM0[1], JMinvLinearM0[2], JMinvLinearM0[3]);
+			dgVector::Transpose4x4 (dst->m_JMinv[3], dst->m_JMinv[4], dst->m_JMinv[5], unused, JMinvAngularM0[0], JMinvAngularM0[1], JMinvAngularM0[2], JMinvAngularM0[3]);
+			dgVector::Transpose4x4 (dst->m_JMinv[6], dst->m_JMinv[7], dst->m_JMinv[8], unused, JMinvLinearM1[0], JMinvLinearM1[1], JMinvLinearM1[2], JMinvLinearM1[3]);
+			dgVector::Transpose4x4 (dst->m_JMinv[9], dst->m_JMinv[10], dst->m_JMinv[11], unused, JMinvAngularM1[0], JMinvAngularM1[1], JMinvAngularM1[2], JMinvAngularM1[3]);
+
+			dst->m_force = dgVector (row[0]->m_force, row[1]->m_force, row[2]->m_force, row[3]->m_force);
+			dst->m_maxImpact = dgVector (row[0]->m_maxImpact, row[1]->m_maxImpact, row[2]->m_maxImpact, row[3]->m_maxImpact);
+			dst->m_diagDamp = dgVector (row[0]->m_diagDamp, row[1]->m_diagDamp, row[2]->m_diagDamp, row[3]->m_diagDamp);
+			dst->m_invDJMinvJt = dgVector (row[0]->m_invDJMinvJt, row[1]->m_invDJMinvJt, row[2]->m_invDJMinvJt, row[3]->m_invDJMinvJt);
+			dst->m_lowerBoundFrictionCoefficent = dgVector (row[0]->m_lowerBoundFrictionCoefficent, row[1]->m_lowerBoundFrictionCoefficent, row[2]->m_lowerBoundFrictionCoefficent, row[3]->m_lowerBoundFrictionCoefficent);
+			dst->m_upperBoundFrictionCoefficent = dgVector (row[0]->m_upperBoundFrictionCoefficent, row[1]->m_upperBoundFrictionCoefficent, row[2]->m_upperBoundFrictionCoefficent, row[3]->m_upperBoundFrictionCoefficent);
+		}
+	}
+}
+
+
+void dgWorldDynamicUpdate::UpdateSoaBlocksAccelParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "UpdateSoaBlocksAccelParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
+
+	const dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_memory[0];
+	const dgJacobianMatrixSoaBlock* const blocks = syncData->m_soaBlocks;
+
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_soaBlocksCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		const dgJacobianMatrixSoaBlock& block = blocks[i];
+		dgJacobianMatrixSoaElement* const soaRow = &syncData->m_soaRows[block.m_rowStart];
+		for (dgInt32 k = 0; k < block.m_rowCount; k ++) {
+			dgFloat32 accel[4];
+			for (dgInt32 lane = 0; lane < 4; lane ++) {
+				dgInt32 index = soaRow[k].m_rowIndex[lane];
+				accel[lane] = (index >= 0) ? matrixRow[index].m_coordenateAccel : dgFloat32 (0.0f);
+			}
+			soaRow[k].m_coordenateAccel = dgVector (accel[0], accel[1], accel[2], accel[3]);
+		}
+	}
+}
+
+
+void dgWorldDynamicUpdate::UpdateRowsFromSoaBlocksParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "UpdateRowsFromSoaBlocksParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
+
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_memory[0];
+	const dgJacobianMatrixSoaBlock* const blocks = syncData->m_soaBlocks;
+
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_soaBlocksCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		const dgJacobianMatrixSoaBlock& block = blocks[i];
+		const dgJacobianMatrixSoaElement* const soaRow = &syncData->m_soaRows[block.m_rowStart];
+		for (dgInt32 k = 0; k < block.m_rowCount; k ++) {
+			for (dgInt32 lane = 0; lane < 4; lane ++) {
+				dgInt32 index = soaRow[k].m_rowIndex[lane];
+				if (index >= 0) {
+					matrixRow[index].m_force = soaRow[k].m_force[lane];
+					matrixRow[index].m_maxImpact = soaRow[k].m_maxImpact[lane];
+				}
+			}
+		}
+	}
+}
+
+
 void dgWorldDynamicUpdate::CalculateJointsAccelParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "CalculateJointsAccelParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 	const dgParallelJointMap* const jointInfoIndexArray = syncData->m_jointInfoMap;
 	dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
 	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_memory[0];
@@ -533,12 +983,14 @@ void dgWorldDynamicUpdate::CalculateJointsForceParallelKernel (void* const conte
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "CalculateJointsForceParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 	
 	const dgParallelJointMap* const jointInfoIndexArray = syncData->m_jointInfoMap;
 	dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[0];
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_memory[0];
 	const dgIsland* const island = syncData->m_islandArray;
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[island->m_bodyStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_memory[0];
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
 	const dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
 //	dgThread::dgCriticalSection* const bodyAtomic = syncData->m_bodyAtomic;
@@ -667,10 +1119,127 @@ void dgWorldDynamicUpdate::CalculateJointsForceParallelKernel (void* const conte
 	syncData->m_accelNorm[threadID] = accNorm;
 }
 
+void dgWorldDynamicUpdate::CalculateJointsForceSoaParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "CalculateJointsForceSoaParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
+
+	const dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
+	const dgIsland* const island = syncData->m_islandArray;
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[island->m_bodyStart];
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	const dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
+	const dgJacobianMatrixSoaBlock* const blocks = syncData->m_soaBlocks;
+
+	dgVector normalForce[DG_CONSTRAINT_MAX_ROWS];
+	const dgVector zero (dgFloat32 (0.0f));
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
+
+	dgVector accNorm (syncData->m_accelNorm[threadID]);
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_jointsInBatch; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		const dgJacobianMatrixSoaBlock& block = blocks[i];
+
+		dgInt32 m0[4];
+		dgInt32 m1[4];
+		dgInt32 activeLanes[4];
+		for (dgInt32 lane = 0; lane < 4; lane ++) {
+			m0[lane] = 0;
+			m1[lane] = 0;
+			activeLanes[lane] = 0;
+			dgInt32 jointIndex = block.m_jointIndex[lane];
+			if (jointIndex >= 0) {
+				m0[lane] = constraintArray[jointIndex].m_m0;
+				m1[lane] = constraintArray[jointIndex].m_m1;
+				const dgBody* const body0 = bodyArray[m0[lane]].m_body;
+				const dgBody* const body1 = bodyArray[m1[lane]].m_body;
+				activeLanes[lane] = (body0->m_resting & body1->m_resting) ? 0 : -1;
+			}
+		}
+
+		if (activeLanes[0] | activeLanes[1] | activeLanes[2] | activeLanes[3]) {
+			const dgVector activeMask (activeLanes[0], activeLanes[1], activeLanes[2], activeLanes[3]);
+
+			dgVector veloc[12];
+			dgVector unused;
+			dgVector::Transpose4x4 (veloc[0], veloc[1], veloc[2], unused, internalForces[m0[0]].m_linear, internalForces[m0[1]].m_linear, internalForces[m0[2]].m_linear, internalForces[m0[3]].m_linear);
+			dgVector::Transpose4x4 (veloc[3], veloc[4], veloc[5], unused, internalForces[m0[0]].m_angular, internalForces[m0[1]].m_angular, internalForces[m0[2]].m_angular, internalForces[m0[3]].m_angular);
+			dgVector::Transpose4x4 (veloc[6], veloc[7], veloc[8], unused, internalForces[m1[0]].m_linear, internalForces[m1[1]].m_linear, internalForces[m1[2]].m_linear, internalForces[m1[3]].m_linear);
+			dgVector::Transpose4x4 (veloc[9], veloc[10], veloc[11], unused, internalForces[m1[0]].m_angular, internalForces[m1[1]].m_angular, internalForces[m1[2]].m_angular, internalForces[m1[3]].m_angular);
+
+			for (dgInt32 k = 0; k < block.m_rowCount; k ++) {
+				dgJacobianMatrixSoaElement* const row = &syncData->m_soaRows[block.m_rowStart + k];
+
+				dgVector frictionNormal (dgVector::m_one);
+				for (dgInt32 lane = 0; lane < 4; lane ++) {
+					dgInt32 frictionIndex = row->m_normalForceIndex[lane];
+					if (frictionIndex >= 0) {
+						dgAssert (frictionIndex < k);
+						frictionNormal[lane] = normalForce[frictionIndex][lane];
+					}
+				}
+
+				dgVector a (row->m_JMinv[0].CompProduct4 (veloc[0]));
+				for (dgInt32 n = 1; n < 12; n ++) {
+					a += row->m_JMinv[n].CompProduct4 (veloc[n]);
+				}
+				a = row->m_coordenateAccel - row->m_force.CompProduct4 (row->m_diagDamp) - a;
+				dgVector f (row->m_force + row->m_invDJMinvJt.CompProduct4 (a));
+
+				dgVector lowerFrictionForce (frictionNormal.CompProduct4 (row->m_lowerBoundFrictionCoefficent));
+				dgVector upperFrictionForce (frictionNormal.CompProduct4 (row->m_upperBoundFrictionCoefficent));
+
+				a = a.AndNot((f > upperFrictionForce) | (f < lowerFrictionForce));
+				f = f.GetMax(lowerFrictionForce).GetMin(upperFrictionForce);
+
+				// joints with both bodies resting keep their force
+				a = a & activeMask;
+				f = (f & activeMask) | row->m_force.AndNot (activeMask);
+				accNorm = accNorm.GetMax(a.Abs());
+
+				dgVector prevValue (f - row->m_force);
+				row->m_force = f;
+				row->m_maxImpact = (f.Abs().GetMax (row->m_maxImpact) & activeMask) | row->m_maxImpact.AndNot (activeMask);
+				normalForce[k] = f;
+
+				for (dgInt32 n = 0; n < 12; n ++) {
+					veloc[n] += row->m_Jt[n].CompProduct4 (prevValue);
+				}
+			}
+
+			dgVector linearM0[4];
+			dgVector angularM0[4];
+			dgVector linearM1[4];
+			dgVector angularM1[4];
+			dgVector::Transpose4x4 (linearM0[0], linearM0[1], linearM0[2], linearM0[3], veloc[0], veloc[1], veloc[2], zero);
+			dgVector::Transpose4x4 (angularM0[0], angularM0[1], angularM0[2], angularM0[3], veloc[3], veloc[4], veloc[5], zero);
+			dgVector::Transpose4x4 (linearM1[0], linearM1[1], linearM1[2], linearM1[3], veloc[6], veloc[7], veloc[8], zero);
+			dgVector::Transpose4x4 (angularM1[0], angularM1[1], angularM1[2], angularM1[3], veloc[9], veloc[10], veloc[11], zero);
+			for (dgInt32 lane = 0; lane < 4; lane ++) {
+				if (activeLanes[lane]) {
+					if (m0[lane]) {
+						internalForces[m0[lane]].m_linear = linearM0[lane];
+						internalForces[m0[lane]].m_angular = angularM0[lane];
+					}
+					if (m1[lane]) {
+						internalForces[m1[lane]].m_linear = linearM1[lane];
+						internalForces[m1[lane]].m_angular = angularM1[lane];
+					}
+				}
+			}
+		}
+	}
+	dgFloat32 maxAccel = dgMax (dgMax (accNorm.m_x, accNorm.m_y), dgMax (accNorm.m_z, accNorm.m_w));
+	syncData->m_accelNorm[threadID] = dgVector (maxAccel);
+}
+
 void dgWorldDynamicUpdate::CalculateJointsVelocParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "CalculateJointsVelocParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 
 	//	const dgInt32* const bodyInfoIndexArray = syncData->m_bodyInfoMap;
 	//	dgBodyInfo* const bodyArray = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
@@ -678,7 +1247,7 @@ void dgWorldDynamicUpdate::CalculateJointsVelocParallelKernel (void* const conte
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
 	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
 
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[0];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[island->m_bodyStart];
 	//dgJacobian* const internalVeloc = &world->m_solverMemory.m_internalVeloc[0];
 	//dgFloat32 invStep = (dgFloat32 (1.0f) / dgFloat32 (LINEAR_SOLVER_SUB_STEPS));
 	//dgFloat32 timestep = syncData->m_timestep * invStep;
@@ -722,6 +1291,7 @@ void dgWorldDynamicUpdate::CalculateJointsVelocParallelKernel (void* const conte
 			dgVector test ((velocStep2 > speedFreeze2) | (omegaStep2 > speedFreeze2));
 			if (test.GetSignMask()) {
 				body->m_resting = false;
+				syncData->m_restingBodyWoken = 1;
 			}
 		}
 	}
@@ -732,6 +1302,8 @@ void dgWorldDynamicUpdate::CalculateJointsImpulseVelocParallelKernel (void* cons
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "CalculateJointsImpulseVelocParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 	//	const dgInt32* const bodyInfoIndexArray = syncData->m_bodyInfoMap;
 
 	//	dgBodyInfo* const bodyArray = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
@@ -739,7 +1311,7 @@ void dgWorldDynamicUpdate::CalculateJointsImpulseVelocParallelKernel (void* cons
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
 	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
 
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[0];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[island->m_bodyStart];
 	//dgJacobian* const internalVeloc = &world->m_solverMemory.m_internalVeloc[0];
 
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
@@ -766,6 +1338,8 @@ void dgWorldDynamicUpdate::UpdateFeedbackForcesParallelKernel (void* const conte
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "UpdateFeedbackForcesParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 	const dgParallelJointMap* const jointInfoIndexArray = syncData->m_jointInfoMap;
 	dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
 	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_memory[0];
@@ -795,6 +1369,8 @@ void dgWorldDynamicUpdate::UpdateBodyVelocityParallelKernel (void* const context
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "UpdateBodyVelocityParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 
 //	const dgInt32* const bodyInfoIndexArray = syncData->m_bodyInfoMap;
 //	dgBodyInfo* const bodyArray = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
@@ -844,6 +1420,8 @@ void dgWorldDynamicUpdate::KinematicCallbackUpdateParallelKernel (void* const co
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "KinematicCallbackUpdateParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 	const dgParallelJointMap* const jointInfoIndexArray = syncData->m_jointInfoMap;
 	dgJointInfo* const constraintArray = (dgJointInfo*) &world->m_jointsMemory[0];
 
@@ -868,13 +1446,15 @@ void dgWorldDynamicUpdate::IntegrateInslandParallel(dgParallelSolverSyncData* co
 //		world->QueueJob (IntegrateInslandParallelKernel, syncData, world);
 //	}
 //	world->SynchronizationBarrier();
-	dgWorldDynamicUpdate::IntegrateInslandParallelKernel (syncData, world, 0);
+	dgWorldDynamicUpdate::IntegrateInslandParallelKernel (syncData, world, syncData->m_threadID);
 }
 
 void dgWorldDynamicUpdate::IntegrateInslandParallelKernel (void* const context, void* const worldContext, dgInt32 threadID) 
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	DG_PROFILER_EVENT (world, "IntegrateInslandParallelKernel", threadID);
+	dgWorldCounterScope counterScope (&world->m_counters, m_dynamicsSolveSpanningTreeTicks, threadID);
 	dgFloat32 timestep = syncData->m_timestep;
 	dgInt32* const atomicIndex = &syncData->m_islandCountCounter; 
 	const dgIsland* const islandArray = syncData->m_islandArray;
@@ -891,6 +1471,11 @@ void dgWorldDynamicUpdate::CalculateForcesGameModeParallel (dgParallelSolverSync
 	dgInt32 threadCounts = world->GetThreadCount();	
 
 	dgInt32 maxPasses = syncData->m_maxPasses;
+	dgSolverIterationLimits limits;
+	GetSolverIterationLimits (&limits, maxPasses, DG_SOLVER_MAX_ERROR);
+
+	bool converged = false;
+	dgInt32 iterationsCount = 0;
 	syncData->m_firstPassCoef = dgFloat32 (0.0f);
 	for (dgInt32 step = 0; step < maxPasses; step ++) {
 
@@ -903,25 +1488,37 @@ void dgWorldDynamicUpdate::CalculateForcesGameModeParallel (dgParallelSolverSync
 		//			world->SynchronizationBarrier();
 		//		}
 
-		syncData->m_atomicIndex = 0;
-		for (dgInt32 j = 0; j < threadCounts; j ++) {
-			world->QueueJob (CalculateJointsAccelParallelKernel, syncData, world);
+		if (!converged) {
+			syncData->m_atomicIndex = 0;
+			ExecuteParallelSolverKernel (CalculateJointsAccelParallelKernel, syncData);
+			syncData->m_firstPassCoef = dgFloat32 (1.0f);
+
+			if (syncData->m_soaBlocks) {
+				// the joints wrote new coordinate accelerations to the rows
+				syncData->m_atomicIndex = 0;
+				ExecuteParallelSolverKernel (UpdateSoaBlocksAccelParallelKernel, syncData);
+			}
 		}
-		world->SynchronizationBarrier();
-		syncData->m_firstPassCoef = dgFloat32 (1.0f);
 
-		dgFloat32 accNorm = DG_SOLVER_MAX_ERROR * dgFloat32 (2.0f);
-		for (dgInt32 passes = 0; (passes < DG_BASE_ITERATION_COUNT) && (accNorm > DG_SOLVER_MAX_ERROR); passes ++) {
+		dgInt32 passes = 0;
+		dgFloat32 accNorm = limits.m_tolerance * dgFloat32 (2.0f);
+		for (; !converged && (passes < limits.m_stepIterations) && (iterationsCount < limits.m_maxIterations) && ((accNorm > limits.m_tolerance) || (iterationsCount < limits.m_minIterations)); passes ++) {
+			iterationsCount ++;
 			for (dgInt32 i = 0; i < threadCounts; i ++) {
 				syncData->m_accelNorm[i] = dgVector (dgFloat32 (0.0f));
 			}
-			for (int i = 0; i < syncData->m_batchesCount; i ++) {
-				syncData->m_atomicIndex = syncData->m_jointBatches[i].m_start;
-				syncData->m_jointsInBatch = syncData->m_jointBatches[i].m_count + syncData->m_atomicIndex;
-				for (dgInt32 j = 0; j < threadCounts; j ++) {
-					world->QueueJob (CalculateJointsForceParallelKernel, syncData, world);
+			if (syncData->m_soaBlocks) {
+				for (int i = 0; i < syncData->m_batchesCount; i ++) {
+					syncData->m_atomicIndex = syncData->m_soaBatches[i].m_start;
+					syncData->m_jointsInBatch = syncData->m_soaBatches[i].m_count + syncData->m_atomicIndex;
+					ExecuteParallelSolverKernel (CalculateJointsForceSoaParallelKernel, syncData);
+				}
+			} else {
+				for (int i = 0; i < syncData->m_batchesCount; i ++) {
+					syncData->m_atomicIndex = syncData->m_jointBatches[i].m_start;
+					syncData->m_jointsInBatch = syncData->m_jointBatches[i].m_count + syncData->m_atomicIndex;
+					ExecuteParallelSolverKernel (CalculateJointsForceParallelKernel, syncData);
 				}
-				world->SynchronizationBarrier();
 			}
 			//syncData->m_atomicIndex = 0;
 			//for (dgInt32 j = 0; j < threadCounts; j ++) {
@@ -934,18 +1531,17 @@ void dgWorldDynamicUpdate::CalculateForcesGameModeParallel (dgParallelSolverSync
 				accNorm = dgMax (accNorm, syncData->m_accelNorm[i].m_x);
 			}
 		}
+		converged |= limits.m_adaptive && (passes == 1) && (accNorm <= limits.m_tolerance) && (iterationsCount >= limits.m_minIterations);
 
 		syncData->m_atomicIndex = 1;
+		syncData->m_restingBodyWoken = 0;
 		if (syncData->m_timestep != dgFloat32 (0.0f)) {
-			for (dgInt32 j = 0; j < threadCounts; j ++) {
-				world->QueueJob (CalculateJointsVelocParallelKernel, syncData, world);
-			}
+			ExecuteParallelSolverKernel (CalculateJointsVelocParallelKernel, syncData);
 		} else {
-			for (dgInt32 j = 0; j < threadCounts; j ++) {
-				world->QueueJob (CalculateJointsImpulseVelocParallelKernel, syncData, world);
-			}
+			ExecuteParallelSolverKernel (CalculateJointsImpulseVelocParallelKernel, syncData);
 		}
-		world->SynchronizationBarrier();
+		// the passes skip the joints between resting bodies, the island has to iterate again when one wakes up
+		converged = converged && !syncData->m_restingBodyWoken;
 
 	}
 
@@ -959,11 +1555,13 @@ void dgWorldDynamicUpdate::CalculateForcesGameModeParallel (dgParallelSolverSync
 	//		world->SynchronizationBarrier();
 	//	}
 
-	syncData->m_atomicIndex = 0;
-	for (dgInt32 j = 0; j < threadCounts; j ++) {
-		world->QueueJob (UpdateFeedbackForcesParallelKernel, syncData, world);
+	if (syncData->m_soaBlocks) {
+		syncData->m_atomicIndex = 0;
+		ExecuteParallelSolverKernel (UpdateRowsFromSoaBlocksParallelKernel, syncData);
 	}
-	world->SynchronizationBarrier();
+
+	syncData->m_atomicIndex = 0;
+	ExecuteParallelSolverKernel (UpdateFeedbackForcesParallelKernel, syncData);
 
 	dgInt32 hasJointFeeback = 0;
 	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
@@ -971,10 +1569,7 @@ void dgWorldDynamicUpdate::CalculateForcesGameModeParallel (dgParallelSolverSync
 	}
 
 	syncData->m_atomicIndex = 1;
-	for (dgInt32 j = 0; j < threadCounts; j ++) {
-		world->QueueJob (UpdateBodyVelocityParallelKernel, syncData, world);
-	}
-	world->SynchronizationBarrier();
+	ExecuteParallelSolverKernel (UpdateBodyVelocityParallelKernel, syncData);
 
 	if (hasJointFeeback) {
 		//		for (int i = 0; i < syncData->m_batchesCount; i ++) {
@@ -987,9 +1582,8 @@ void dgWorldDynamicUpdate::CalculateForcesGameModeParallel (dgParallelSolverSync
 		//		}
 
 		syncData->m_atomicIndex = 0;
-		for (dgInt32 j = 0; j < threadCounts; j ++) {
-			world->QueueJob (KinematicCallbackUpdateParallelKernel, syncData, world);
-		}
-		world->SynchronizationBarrier();
+		ExecuteParallelSolverKernel (KinematicCallbackUpdateParallelKernel, syncData);
 	}
+
+	UpdateSolverIterationCounts (world->m_counters.m_counts[DG_WORLD_COUNTERS_MASTER_ROW], iterationsCount, limits.m_maxIterations);
 }
@@ -873,13 +873,21 @@ void dgWorldDynamicUpdate::CalculateForcesGameMode (const dgIsland* const island
 	dgVector freezeOmega2 (world->m_freezeOmega2 * dgFloat32 (0.1f));
 	dgVector forceActiveMask ((jointCount <= DG_SMALL_ISLAND_COUNT) ?  dgVector (-1, -1, -1, -1): dgFloat32 (0.0f));
 
+	dgSolverIterationLimits limits;
+	GetSolverIterationLimits (&limits, maxPasses, maxAccNorm);
+
+	// in adaptive mode, once the forces of the last substep already meet the residual the island stops iterating
+	bool converged = false;
+	dgInt32 iterationsCount = 0;
 	dgFloat32 firstPassCoef = dgFloat32 (0.0f);
 	for (dgInt32 step = 0; step < maxPasses; step ++) {
 		dgJointAccelerationDecriptor joindDesc;
 		joindDesc.m_timeStep = timestepRK;
 		joindDesc.m_invTimeStep = invTimestepRK;
 		joindDesc.m_firstPassCoefFlag = firstPassCoef;
-		if (firstPassCoef == dgFloat32 (0.0f)) {
+		if (converged) {
+			// the joint accelerations are only needed by the passes
+		} else if (firstPassCoef == dgFloat32 (0.0f)) {
 			for (dgInt32 curJoint = 0; curJoint < jointCount; curJoint ++) {
 				dgJointInfo* const jointInfo = &constraintArray[curJoint];
 				dgConstraint* const constraint = jointInfo->m_joint;
@@ -908,9 +916,11 @@ void dgWorldDynamicUpdate::CalculateForcesGameMode (const dgIsland* const island
 			}
 		}
 
-		dgVector accNorm (maxAccNorm * dgFloat32 (2.0f));
-		for (dgInt32 passes = 0; (passes < DG_BASE_ITERATION_COUNT) && (accNorm.m_x > maxAccNorm); passes ++) {
+		dgInt32 passes = 0;
+		dgVector accNorm (limits.m_tolerance * dgFloat32 (2.0f));
+		for (; !converged && (passes < limits.m_stepIterations) && (iterationsCount < limits.m_maxIterations) && ((accNorm.m_x > limits.m_tolerance) || (iterationsCount < limits.m_minIterations)); passes ++) {
 
+			iterationsCount ++;
 			accNorm = dgVector (dgFloat32 (0.0f));
 			for (dgInt32 curJoint = 0; curJoint < jointCount; curJoint ++) {
 				dgJointInfo* const jointInfo = &constraintArray[curJoint];
@@ -1009,6 +1019,7 @@ void dgWorldDynamicUpdate::CalculateForcesGameMode (const dgIsland* const island
 				}
 			}
 		}
+		converged |= limits.m_adaptive && (passes == 1) && (accNorm.m_x <= limits.m_tolerance) && (iterationsCount >= limits.m_minIterations);
 
 		if (timestepRK != dgFloat32 (0.0f)) {
 			dgVector timestep4 (timestepRK);
@@ -1032,7 +1043,9 @@ void dgWorldDynamicUpdate::CalculateForcesGameMode (const dgIsland* const island
 						dgVector omegaStep2 (omegaStep.DotProduct4(omegaStep));
 						dgVector test ((velocStep2 > speedFreeze2) | (omegaStep2 > speedFreeze2) | forceActiveMask);
 						if (test.GetSignMask()) {
+							// the passes skip the joints between resting bodies, the island has to iterate again
 							body->m_resting = false;
+							converged = false;
 						}
 					}
 				}
@@ -1117,6 +1130,8 @@ void dgWorldDynamicUpdate::CalculateForcesGameMode (const dgIsland* const island
 			}
 		}
 	}
+
+	UpdateSolverIterationCounts (world->m_counters.m_counts[threadIndex], iterationsCount, limits.m_maxIterations);
 }
 
 
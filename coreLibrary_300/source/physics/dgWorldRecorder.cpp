@@ -0,0 +1,421 @@
+/* Copyright (c) <2003-2011> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgDynamicBody.h"
+#include "dgWorldRecorder.h"
+
+
+class dgForceRecord
+{
+	public:
+	dgInt32 m_uniqueID;
+	dgFloat32 m_force[3];
+	dgFloat32 m_torque[3];
+};
+
+
+dgWorldRecorder::dgWorldRecorder (dgWorld* const world)
+	:m_world(world)
+	,m_file(NULL)
+	,m_frame(0)
+	,m_timestep(dgFloat32 (0.0f))
+	,m_replaying(false)
+	,m_newBodies(world->GetAllocator())
+	,m_forces(256, world->GetAllocator())
+	,m_replayBodies(world->GetAllocator())
+	,m_bodyArray(256, world->GetAllocator())
+	,m_loadedCount(0)
+{
+}
+
+dgWorldRecorder::~dgWorldRecorder ()
+{
+	if (m_file) {
+		if (!m_replaying) {
+			dgInt32 tag = m_endTag;
+			OnSerialize (m_file, &tag, sizeof (tag));
+		}
+		fclose (m_file);
+	}
+}
+
+void dgWorldRecorder::OnSerialize (void* const fileHandle, const void* const buffer, size_t size)
+{
+	dgAssert ((size & 0x03) == 0);
+	fwrite (buffer, size, 1, (FILE*) fileHandle);
+}
+
+void dgWorldRecorder::OnDeserialize (void* const fileHandle, void* const buffer, size_t size)
+{
+	dgAssert ((size & 0x03) == 0);
+	if (fread (buffer, size, 1, (FILE*) fileHandle) != 1) {
+		// a truncated log reads as zeros, which ends the replay at the next tag
+		memset (buffer, 0, size);
+	}
+}
+
+void dgWorldRecorder::OnBodySerialize (dgBody& body, dgSerialize serializeCallback, void* const fileHandle)
+{
+}
+
+void dgWorldRecorder::OnBodyDeserialize (dgBody& body, dgDeserialize deserializeCallback, void* const fileHandle)
+{
+	dgWorldRecorder* const recorder = body.GetWorld()->m_recorder;
+	recorder->m_bodyArray[recorder->m_loadedCount] = &body;
+	recorder->m_loadedCount ++;
+	if (body.IsRTTIType (dgBody::m_dynamicBodyRTTI)) {
+		body.SetExtForceAndTorqueCallback (OnReplayForceAndTorque);
+	}
+}
+
+void dgWorldRecorder::OnReplayForceAndTorque (dgBody& body, dgFloat32 timestep, dgInt32 threadIndex)
+{
+	const dgWorldRecorder* const recorder = body.GetWorld()->m_recorder;
+	if (recorder) {
+		const dgInt32 index = body.GetUniqueID() * 2;
+		body.SetForce (recorder->m_forces[index]);
+		body.SetTorque (recorder->m_forces[index + 1]);
+	}
+}
+
+void dgWorldRecorder::ResetForces (const dgBody* const body)
+{
+	const dgInt32 index = body->GetUniqueID() * 2;
+	m_forces[index] = dgVector (dgFloat32 (0.0f));
+	m_forces[index + 1] = dgVector (dgFloat32 (0.0f));
+}
+
+
+dgUnsigned32 dgWorldRecorder::CalculateStateCRC (const dgWorld* const world)
+{
+	dgUnsigned32 crc = 0;
+	const dgBodyMasterList& masterList = *world;
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		// only the x, y, z components, the w of the vectors is not part of the state and can hold anything
+		const dgBody* const body = node->GetInfo().GetBody();
+		const dgMatrix& matrix = body->GetMatrix();
+		const dgVector& veloc = body->GetVelocity();
+		const dgVector& omega = body->GetOmega();
+		dgFloat32 state[6][3];
+		for (dgInt32 i = 0; i < 3; i ++) {
+			state[0][i] = matrix[0][i];
+			state[1][i] = matrix[1][i];
+			state[2][i] = matrix[2][i];
+			state[3][i] = matrix[3][i];
+			state[4][i] = veloc[i];
+			state[5][i] = omega[i];
+		}
+		crc = dgCRC (state, sizeof (state), crc);
+	}
+	return crc;
+}
+
+
+bool dgWorldRecorder::StartRecording (const char* const fileName)
+{
+	dgAssert (!m_file);
+	m_file = fopen (fileName, "wb");
+	if (!m_file) {
+		return false;
+	}
+
+	dgInt32 header[7];
+	header[0] = DG_RECORDER_FILE_ID;
+	header[1] = DG_RECORDER_VERSION;
+	header[2] = sizeof (dgFloat32);
+	header[3] = dgInt32 (m_world->m_solverMode);
+	header[4] = dgInt32 (m_world->m_frictionMode);
+	header[5] = m_world->m_solverMinIterations;
+	header[6] = m_world->m_solverMaxIterations;
+	OnSerialize (m_file, header, sizeof (header));
+	OnSerialize (m_file, &m_world->m_solverResidualTolerance, sizeof (dgFloat32));
+
+	// the master list order depends on the mass of the bodies, the unique ids give back the creation order
+	dgTree<dgBody*, dgInt32> sortedBodies (m_world->GetAllocator());
+	const dgBodyMasterList& masterList = *m_world;
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		dgBody* const body = node->GetInfo().GetBody();
+		sortedBodies.Insert (body, body->GetUniqueID());
+	}
+
+	dgTree<dgBody*, dgInt32>::Iterator iter (sortedBodies);
+	for (iter.Begin(); iter; iter ++) {
+		BodyCreated (iter.GetNode()->GetInfo());
+	}
+	return true;
+}
+
+void dgWorldRecorder::BodyCreated (dgBody* const body)
+{
+	if (!m_replaying) {
+		m_newBodies.Append (body);
+		ResetForces (body);
+	}
+}
+
+void dgWorldRecorder::BodyDestroyed (dgBody* const body)
+{
+	if (!m_replaying) {
+		dgList<dgBody*>::dgListNode* const node = m_newBodies.Find (body);
+		if (node) {
+			m_newBodies.Remove (node);
+		} else {
+			dgInt32 data[2];
+			data[0] = m_destroyBodyTag;
+			data[1] = body->GetUniqueID();
+			OnSerialize (m_file, data, sizeof (data));
+		}
+	}
+}
+
+void dgWorldRecorder::WriteNewBodies ()
+{
+	dgInt32 count = 0;
+	for (dgList<dgBody*>::dgListNode* node = m_newBodies.GetFirst(); node; node = node->GetNext()) {
+		m_bodyArray[count] = node->GetInfo();
+		count ++;
+	}
+
+	dgInt32 tag = m_createBodiesTag;
+	OnSerialize (m_file, &tag, sizeof (tag));
+	m_world->SerializeBodyArray (&m_bodyArray[0], count, OnBodySerialize, OnSerialize, m_file);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgInt32 uniqueID = m_bodyArray[i]->GetUniqueID();
+		OnSerialize (m_file, &uniqueID, sizeof (uniqueID));
+		OnSerialize (m_file, &m_bodyArray[i]->m_matrix, sizeof (dgMatrix));
+		OnSerialize (m_file, &m_bodyArray[i]->m_rotation, sizeof (dgQuaternion));
+	}
+	m_newBodies.RemoveAll();
+	WriteBodyOrder ();
+}
+
+void dgWorldRecorder::WriteBodyOrder ()
+{
+	// the solver visits bodies in master list order, which depend on how the application set the mass of each body
+	dgInt32 count = m_world->GetBodiesCount();
+	OnSerialize (m_file, &count, sizeof (count));
+	const dgBodyMasterList& masterList = *m_world;
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		dgInt32 uniqueID = node->GetInfo().GetBody()->GetUniqueID();
+		OnSerialize (m_file, &uniqueID, sizeof (uniqueID));
+	}
+}
+
+void dgWorldRecorder::ReadBodyOrder ()
+{
+	dgInt32 count;
+	dgBodyMasterList& masterList = *m_world;
+	OnDeserialize (m_file, &count, sizeof (count));
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgInt32 uniqueID;
+		OnDeserialize (m_file, &uniqueID, sizeof (uniqueID));
+		dgTree<dgBody*, dgInt32>::dgTreeNode* const node = m_replayBodies.Find (uniqueID);
+		if (node) {
+			masterList.RotateToEnd (node->GetInfo()->m_masterNode);
+		}
+	}
+}
+
+void dgWorldRecorder::ReadNewBodies ()
+{
+	// the body callback collects the loaded bodies in the same order they were saved
+	m_loadedCount = 0;
+	m_world->DeserializeBodyArray (OnBodyDeserialize, OnDeserialize, m_file);
+	const dgInt32 count = m_loadedCount;
+
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgInt32 uniqueID;
+		dgMatrix matrix;
+		dgQuaternion rotation;
+		dgBody* const body = m_bodyArray[i];
+		OnDeserialize (m_file, &uniqueID, sizeof (uniqueID));
+		OnDeserialize (m_file, &matrix, sizeof (matrix));
+		OnDeserialize (m_file, &rotation, sizeof (rotation));
+
+		// loading rebuilds the matrix and the rotation from each other, restore the recorded bits and everything derived from them
+		body->SetMatrix (matrix);
+		body->m_rotation = rotation;
+		if (body->IsRTTIType (dgBody::m_dynamicBodyRTTI)) {
+			body->CalcInvInertiaMatrix ();
+		}
+
+		m_replayBodies.Insert (body, uniqueID);
+		ResetForces (body);
+	}
+	ReadBodyOrder ();
+}
+
+
+void dgWorldRecorder::BeginStep (dgFloat32 timestep)
+{
+	if (!m_replaying) {
+		m_timestep = timestep;
+		if (m_newBodies.GetCount()) {
+			WriteNewBodies ();
+		}
+	}
+}
+
+bool dgWorldRecorder::ForcesChanged (const dgBody* const body) const
+{
+	if (body->IsRTTIType (dgBody::m_dynamicBodyRTTI)) {
+		const dgDynamicBody* const dynBody = (dgDynamicBody*) body;
+		const dgInt32 index = body->GetUniqueID() * 2;
+		const dgVector& force = m_forces[index];
+		const dgVector& torque = m_forces[index + 1];
+		return (force.m_x != dynBody->m_prevExternalForce.m_x) || (force.m_y != dynBody->m_prevExternalForce.m_y) || (force.m_z != dynBody->m_prevExternalForce.m_z) ||
+			   (torque.m_x != dynBody->m_prevExternalTorque.m_x) || (torque.m_y != dynBody->m_prevExternalTorque.m_y) || (torque.m_z != dynBody->m_prevExternalTorque.m_z);
+	}
+	return false;
+}
+
+void dgWorldRecorder::EndStep ()
+{
+	if (!m_replaying) {
+		const dgBodyMasterList& masterList = *m_world;
+
+		// only the bodies which external force or torque changed since the last update are written
+		dgInt32 count = 0;
+		for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+			count += ForcesChanged (node->GetInfo().GetBody()) ? 1 : 0;
+		}
+
+		dgInt32 tag = m_stepTag;
+		OnSerialize (m_file, &tag, sizeof (tag));
+		OnSerialize (m_file, &m_timestep, sizeof (m_timestep));
+		OnSerialize (m_file, &count, sizeof (count));
+
+		for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+			dgBody* const body = node->GetInfo().GetBody();
+			if (ForcesChanged (body)) {
+				const dgDynamicBody* const dynBody = (dgDynamicBody*) body;
+				const dgInt32 slot = body->GetUniqueID() * 2;
+				m_forces[slot] = dynBody->m_prevExternalForce;
+				m_forces[slot + 1] = dynBody->m_prevExternalTorque;
+
+				dgForceRecord record;
+				record.m_uniqueID = body->GetUniqueID();
+				for (dgInt32 i = 0; i < 3; i ++) {
+					record.m_force[i] = dynBody->m_prevExternalForce[i];
+					record.m_torque[i] = dynBody->m_prevExternalTorque[i];
+				}
+				OnSerialize (m_file, &record, sizeof (record));
+			}
+		}
+
+		dgUnsigned32 crc = CalculateStateCRC (m_world);
+		OnSerialize (m_file, &crc, sizeof (crc));
+		m_frame ++;
+	}
+}
+
+
+dgInt32 dgWorldRecorder::Replay (const char* const fileName, OnReplayStep callback, void* const userData)
+{
+	dgAssert (!m_file);
+	m_file = fopen (fileName, "rb");
+	if (!m_file) {
+		return -2;
+	}
+	m_replaying = true;
+
+	dgInt32 header[7];
+	dgFloat32 residual;
+	OnDeserialize (m_file, header, sizeof (header));
+	OnDeserialize (m_file, &residual, sizeof (residual));
+	if ((header[0] != DG_RECORDER_FILE_ID) || (header[1] != DG_RECORDER_VERSION) || (header[2] != sizeof (dgFloat32))) {
+		return -2;
+	}
+	m_world->SetSolverMode (header[3]);
+	m_world->SetFrictionMode (header[4]);
+	m_world->m_solverResidualTolerance = residual;
+	m_world->m_solverMinIterations = header[5];
+	m_world->m_solverMaxIterations = header[6];
+
+	dgInt32 firstDivergentFrame = -1;
+	for (bool done = false; !done; ) {
+		dgInt32 tag;
+		OnDeserialize (m_file, &tag, sizeof (tag));
+		switch (tag) 
+		{
+			case m_createBodiesTag:
+			{
+				ReadNewBodies ();
+				break;
+			}
+
+			case m_destroyBodyTag:
+			{
+				dgInt32 uniqueID;
+				OnDeserialize (m_file, &uniqueID, sizeof (uniqueID));
+				dgTree<dgBody*, dgInt32>::dgTreeNode* const node = m_replayBodies.Find (uniqueID);
+				if (node) {
+					m_world->DestroyBody (node->GetInfo());
+					m_replayBodies.Remove (node);
+				}
+				break;
+			}
+
+			case m_stepTag:
+			{
+				dgInt32 count;
+				dgFloat32 timestep;
+				OnDeserialize (m_file, &timestep, sizeof (timestep));
+				OnDeserialize (m_file, &count, sizeof (count));
+				for (dgInt32 i = 0; i < count; i ++) {
+					dgForceRecord record;
+					OnDeserialize (m_file, &record, sizeof (record));
+					dgTree<dgBody*, dgInt32>::dgTreeNode* const node = m_replayBodies.Find (record.m_uniqueID);
+					if (node) {
+						const dgInt32 slot = node->GetInfo()->GetUniqueID() * 2;
+						m_forces[slot] = dgVector (record.m_force[0], record.m_force[1], record.m_force[2], dgFloat32 (0.0f));
+						m_forces[slot + 1] = dgVector (record.m_torque[0], record.m_torque[1], record.m_torque[2], dgFloat32 (0.0f));
+					}
+				}
+				dgUnsigned32 recordedCRC;
+				OnDeserialize (m_file, &recordedCRC, sizeof (recordedCRC));
+
+				dgUnsigned64 time = dgGetTimeInMicrosenconds();
+				m_world->Update (timestep);
+				time = dgGetTimeInMicrosenconds() - time;
+
+				dgUnsigned32 crc = CalculateStateCRC (m_world);
+				if ((crc != recordedCRC) && (firstDivergentFrame < 0)) {
+					firstDivergentFrame = m_frame;
+				}
+				if (callback) {
+					callback (userData, m_frame, dgFloat32 (time) * dgFloat32 (1.0e-3f), recordedCRC, crc);
+				}
+				m_frame ++;
+				break;
+			}
+
+			default:
+			{
+				done = true;
+			}
+		}
+	}
+	return firstDivergentFrame;
+}
@@ -0,0 +1,95 @@
+/* Copyright (c) <2003-2011> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef _DG_WORLD_RECORDER_H_
+#define _DG_WORLD_RECORDER_H_
+
+#include "dgPhysicsStdafx.h"
+
+#define DG_RECORDER_FILE_ID			0x4c50524e
+#define DG_RECORDER_VERSION			2
+
+class dgBody;
+class dgWorld;
+
+// records the bodies, the external forces and a crc of the body states of every update to a binary log,
+// the log can be replayed on an empty world to compare the simulation frame by frame.
+class dgWorldRecorder
+{
+	public:
+	typedef void (dgApi *OnReplayStep) (void* const userData, dgInt32 frame, dgFloat32 milliseconds, dgUnsigned32 recordedCRC, dgUnsigned32 replayCRC);
+
+	enum dgRecordTag
+	{
+		m_createBodiesTag = 1,
+		m_destroyBodyTag,
+		m_stepTag,
+		m_endTag,
+	};
+
+	DG_CLASS_ALLOCATOR(allocator)
+
+	dgWorldRecorder (dgWorld* const world);
+	~dgWorldRecorder ();
+
+	bool StartRecording (const char* const fileName);
+	dgInt32 Replay (const char* const fileName, OnReplayStep callback, void* const userData);
+
+	void BodyCreated (dgBody* const body);
+	void BodyDestroyed (dgBody* const body);
+	void BeginStep (dgFloat32 timestep);
+	void EndStep ();
+
+	static dgUnsigned32 CalculateStateCRC (const dgWorld* const world);
+
+	private:
+	void WriteNewBodies ();
+	void ReadNewBodies ();
+	void WriteBodyOrder ();
+	void ReadBodyOrder ();
+	void ResetForces (const dgBody* const body);
+	bool ForcesChanged (const dgBody* const body) const;
+
+	static void dgApi OnSerialize (void* const fileHandle, const void* const buffer, size_t size);
+	static void dgApi OnDeserialize (void* const fileHandle, void* const buffer, size_t size);
+	static void dgApi OnBodySerialize (dgBody& body, dgSerialize serializeCallback, void* const fileHandle);
+	static void dgApi OnBodyDeserialize (dgBody& body, dgDeserialize deserializeCallback, void* const fileHandle);
+	static void dgApi OnReplayForceAndTorque (dgBody& body, dgFloat32 timestep, dgInt32 threadIndex);
+
+	dgWorld* m_world;
+	FILE* m_file;
+	dgInt32 m_frame;
+	dgFloat32 m_timestep;
+	bool m_replaying;
+
+	// bodies created since the last update, they are written to the log at the beginning of the next update
+	dgList<dgBody*> m_newBodies;
+
+	// last external force and torque of each body indexed by unique id, only the changes go to the log
+	dgArray<dgVector> m_forces;
+
+	// replayed bodies indexed by the unique id they had in the recorded world
+	dgTree<dgBody*, dgInt32> m_replayBodies;
+	dgArray<dgBody*> m_bodyArray;
+	dgInt32 m_loadedCount;
+};
+
+#endif